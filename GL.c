@@ -1,10 +1,13 @@
 // This file was generated by a tool:
 // https://github.com/holmak/opengl-loader
 
-#include <assert.h>
+#include <stdio.h>
+#include <string.h>
 #include "GL.h"
 #include <SDL2/SDL.h>
 
+GLSupport GLSupported;
+
 GLPROC_glCullFace glCullFace;
 GLPROC_glFrontFace glFrontFace;
 GLPROC_glHint glHint;
@@ -390,15 +393,69 @@ GLPROC_glGetObjectLabel glGetObjectLabel;
 GLPROC_glObjectPtrLabel glObjectPtrLabel;
 GLPROC_glGetObjectPtrLabel glGetObjectPtrLabel;
 GLPROC_glGetPointerv glGetPointerv;
+GLPROC_glGetProgramBinary glGetProgramBinary;
+GLPROC_glProgramBinary glProgramBinary;
+GLPROC_glProgramParameteri glProgramParameteri;
+GLPROC_glMaxShaderCompilerThreadsKHR glMaxShaderCompilerThreadsKHR;
+GLPROC_glDrawArraysIndirect glDrawArraysIndirect;
+GLPROC_glDrawElementsIndirect glDrawElementsIndirect;
+GLPROC_glDrawArraysInstancedBaseInstance glDrawArraysInstancedBaseInstance;
+GLPROC_glDrawElementsInstancedBaseInstance glDrawElementsInstancedBaseInstance;
+GLPROC_glDrawElementsInstancedBaseVertexBaseInstance glDrawElementsInstancedBaseVertexBaseInstance;
+GLPROC_glMultiDrawArraysIndirect glMultiDrawArraysIndirect;
+GLPROC_glMultiDrawElementsIndirect glMultiDrawElementsIndirect;
+GLPROC_glBufferStorage glBufferStorage;
+GLPROC_glCreateBuffers glCreateBuffers;
+GLPROC_glNamedBufferStorage glNamedBufferStorage;
+GLPROC_glNamedBufferData glNamedBufferData;
+GLPROC_glNamedBufferSubData glNamedBufferSubData;
+GLPROC_glCopyNamedBufferSubData glCopyNamedBufferSubData;
+GLPROC_glClearNamedBufferData glClearNamedBufferData;
+GLPROC_glClearNamedBufferSubData glClearNamedBufferSubData;
+GLPROC_glMapNamedBuffer glMapNamedBuffer;
+GLPROC_glMapNamedBufferRange glMapNamedBufferRange;
+GLPROC_glUnmapNamedBuffer glUnmapNamedBuffer;
+GLPROC_glFlushMappedNamedBufferRange glFlushMappedNamedBufferRange;
+GLPROC_glGetNamedBufferParameteriv glGetNamedBufferParameteriv;
+GLPROC_glGetNamedBufferParameteri64v glGetNamedBufferParameteri64v;
+GLPROC_glGetNamedBufferPointerv glGetNamedBufferPointerv;
+GLPROC_glGetNamedBufferSubData glGetNamedBufferSubData;
+GLPROC_glCreateVertexArrays glCreateVertexArrays;
+GLPROC_glDisableVertexArrayAttrib glDisableVertexArrayAttrib;
+GLPROC_glEnableVertexArrayAttrib glEnableVertexArrayAttrib;
+GLPROC_glVertexArrayElementBuffer glVertexArrayElementBuffer;
+GLPROC_glVertexArrayVertexBuffer glVertexArrayVertexBuffer;
+GLPROC_glVertexArrayVertexBuffers glVertexArrayVertexBuffers;
+GLPROC_glVertexArrayAttribBinding glVertexArrayAttribBinding;
+GLPROC_glVertexArrayAttribFormat glVertexArrayAttribFormat;
+GLPROC_glVertexArrayAttribIFormat glVertexArrayAttribIFormat;
+GLPROC_glVertexArrayAttribLFormat glVertexArrayAttribLFormat;
+GLPROC_glVertexArrayBindingDivisor glVertexArrayBindingDivisor;
+GLPROC_glGetVertexArrayiv glGetVertexArrayiv;
+GLPROC_glGetVertexArrayIndexediv glGetVertexArrayIndexediv;
+GLPROC_glGetVertexArrayIndexed64iv glGetVertexArrayIndexed64iv;
+GLPROC_glTexBufferRange glTexBufferRange;
+GLPROC_glBindImageTexture glBindImageTexture;
+GLPROC_glMemoryBarrier glMemoryBarrier;
+GLPROC_glDispatchCompute glDispatchCompute;
+GLPROC_glDispatchComputeIndirect glDispatchComputeIndirect;
+GLPROC_glShaderStorageBlockBinding glShaderStorageBlockBinding;
+GLPROC_glClearBufferData glClearBufferData;
+GLPROC_glClearBufferSubData glClearBufferSubData;
+GLPROC_glMultiDrawArraysIndirectCount glMultiDrawArraysIndirectCount;
+GLPROC_glMultiDrawElementsIndirectCount glMultiDrawElementsIndirectCount;
+
+// How many functions could not be found, for checking the core groups:
+static int MissingProcs;
 
 static void *Load(const char *name)
 {
     void *proc = SDL_GL_GetProcAddress(name);
-    assert(proc);
+    MissingProcs += (proc == NULL);
     return proc;
 }
 
-void LoadGL()
+static void Load_GL_VERSION_1_0()
 {
     glCullFace = (GLPROC_glCullFace)Load("glCullFace");
     glFrontFace = (GLPROC_glFrontFace)Load("glFrontFace");
@@ -448,6 +505,10 @@ void LoadGL()
     glIsEnabled = (GLPROC_glIsEnabled)Load("glIsEnabled");
     glDepthRange = (GLPROC_glDepthRange)Load("glDepthRange");
     glViewport = (GLPROC_glViewport)Load("glViewport");
+}
+
+static void Load_GL_VERSION_1_1()
+{
     glDrawArrays = (GLPROC_glDrawArrays)Load("glDrawArrays");
     glDrawElements = (GLPROC_glDrawElements)Load("glDrawElements");
     glPolygonOffset = (GLPROC_glPolygonOffset)Load("glPolygonOffset");
@@ -461,10 +522,18 @@ void LoadGL()
     glDeleteTextures = (GLPROC_glDeleteTextures)Load("glDeleteTextures");
     glGenTextures = (GLPROC_glGenTextures)Load("glGenTextures");
     glIsTexture = (GLPROC_glIsTexture)Load("glIsTexture");
+}
+
+static void Load_GL_VERSION_1_2()
+{
     glDrawRangeElements = (GLPROC_glDrawRangeElements)Load("glDrawRangeElements");
     glTexImage3D = (GLPROC_glTexImage3D)Load("glTexImage3D");
     glTexSubImage3D = (GLPROC_glTexSubImage3D)Load("glTexSubImage3D");
     glCopyTexSubImage3D = (GLPROC_glCopyTexSubImage3D)Load("glCopyTexSubImage3D");
+}
+
+static void Load_GL_VERSION_1_3()
+{
     glActiveTexture = (GLPROC_glActiveTexture)Load("glActiveTexture");
     glSampleCoverage = (GLPROC_glSampleCoverage)Load("glSampleCoverage");
     glCompressedTexImage3D = (GLPROC_glCompressedTexImage3D)Load("glCompressedTexImage3D");
@@ -474,6 +543,10 @@ void LoadGL()
     glCompressedTexSubImage2D = (GLPROC_glCompressedTexSubImage2D)Load("glCompressedTexSubImage2D");
     glCompressedTexSubImage1D = (GLPROC_glCompressedTexSubImage1D)Load("glCompressedTexSubImage1D");
     glGetCompressedTexImage = (GLPROC_glGetCompressedTexImage)Load("glGetCompressedTexImage");
+}
+
+static void Load_GL_VERSION_1_4()
+{
     glBlendFuncSeparate = (GLPROC_glBlendFuncSeparate)Load("glBlendFuncSeparate");
     glMultiDrawArrays = (GLPROC_glMultiDrawArrays)Load("glMultiDrawArrays");
     glMultiDrawElements = (GLPROC_glMultiDrawElements)Load("glMultiDrawElements");
@@ -483,6 +556,10 @@ void LoadGL()
     glPointParameteriv = (GLPROC_glPointParameteriv)Load("glPointParameteriv");
     glBlendColor = (GLPROC_glBlendColor)Load("glBlendColor");
     glBlendEquation = (GLPROC_glBlendEquation)Load("glBlendEquation");
+}
+
+static void Load_GL_VERSION_1_5()
+{
     glGenQueries = (GLPROC_glGenQueries)Load("glGenQueries");
     glDeleteQueries = (GLPROC_glDeleteQueries)Load("glDeleteQueries");
     glIsQuery = (GLPROC_glIsQuery)Load("glIsQuery");
@@ -502,6 +579,10 @@ void LoadGL()
     glUnmapBuffer = (GLPROC_glUnmapBuffer)Load("glUnmapBuffer");
     glGetBufferParameteriv = (GLPROC_glGetBufferParameteriv)Load("glGetBufferParameteriv");
     glGetBufferPointerv = (GLPROC_glGetBufferPointerv)Load("glGetBufferPointerv");
+}
+
+static void Load_GL_VERSION_2_0()
+{
     glBlendEquationSeparate = (GLPROC_glBlendEquationSeparate)Load("glBlendEquationSeparate");
     glDrawBuffers = (GLPROC_glDrawBuffers)Load("glDrawBuffers");
     glStencilOpSeparate = (GLPROC_glStencilOpSeparate)Load("glStencilOpSeparate");
@@ -595,12 +676,20 @@ void LoadGL()
     glVertexAttrib4uiv = (GLPROC_glVertexAttrib4uiv)Load("glVertexAttrib4uiv");
     glVertexAttrib4usv = (GLPROC_glVertexAttrib4usv)Load("glVertexAttrib4usv");
     glVertexAttribPointer = (GLPROC_glVertexAttribPointer)Load("glVertexAttribPointer");
+}
+
+static void Load_GL_VERSION_2_1()
+{
     glUniformMatrix2x3fv = (GLPROC_glUniformMatrix2x3fv)Load("glUniformMatrix2x3fv");
     glUniformMatrix3x2fv = (GLPROC_glUniformMatrix3x2fv)Load("glUniformMatrix3x2fv");
     glUniformMatrix2x4fv = (GLPROC_glUniformMatrix2x4fv)Load("glUniformMatrix2x4fv");
     glUniformMatrix4x2fv = (GLPROC_glUniformMatrix4x2fv)Load("glUniformMatrix4x2fv");
     glUniformMatrix3x4fv = (GLPROC_glUniformMatrix3x4fv)Load("glUniformMatrix3x4fv");
     glUniformMatrix4x3fv = (GLPROC_glUniformMatrix4x3fv)Load("glUniformMatrix4x3fv");
+}
+
+static void Load_GL_VERSION_3_0()
+{
     glColorMaski = (GLPROC_glColorMaski)Load("glColorMaski");
     glGetBooleani_v = (GLPROC_glGetBooleani_v)Load("glGetBooleani_v");
     glGetIntegeri_v = (GLPROC_glGetIntegeri_v)Load("glGetIntegeri_v");
@@ -685,6 +774,10 @@ void LoadGL()
     glDeleteVertexArrays = (GLPROC_glDeleteVertexArrays)Load("glDeleteVertexArrays");
     glGenVertexArrays = (GLPROC_glGenVertexArrays)Load("glGenVertexArrays");
     glIsVertexArray = (GLPROC_glIsVertexArray)Load("glIsVertexArray");
+}
+
+static void Load_GL_VERSION_3_1()
+{
     glDrawArraysInstanced = (GLPROC_glDrawArraysInstanced)Load("glDrawArraysInstanced");
     glDrawElementsInstanced = (GLPROC_glDrawElementsInstanced)Load("glDrawElementsInstanced");
     glTexBuffer = (GLPROC_glTexBuffer)Load("glTexBuffer");
@@ -697,6 +790,10 @@ void LoadGL()
     glGetActiveUniformBlockiv = (GLPROC_glGetActiveUniformBlockiv)Load("glGetActiveUniformBlockiv");
     glGetActiveUniformBlockName = (GLPROC_glGetActiveUniformBlockName)Load("glGetActiveUniformBlockName");
     glUniformBlockBinding = (GLPROC_glUniformBlockBinding)Load("glUniformBlockBinding");
+}
+
+static void Load_GL_VERSION_3_2()
+{
     glDrawElementsBaseVertex = (GLPROC_glDrawElementsBaseVertex)Load("glDrawElementsBaseVertex");
     glDrawRangeElementsBaseVertex = (GLPROC_glDrawRangeElementsBaseVertex)Load("glDrawRangeElementsBaseVertex");
     glDrawElementsInstancedBaseVertex = (GLPROC_glDrawElementsInstancedBaseVertex)Load("glDrawElementsInstancedBaseVertex");
@@ -716,6 +813,10 @@ void LoadGL()
     glTexImage3DMultisample = (GLPROC_glTexImage3DMultisample)Load("glTexImage3DMultisample");
     glGetMultisamplefv = (GLPROC_glGetMultisamplefv)Load("glGetMultisamplefv");
     glSampleMaski = (GLPROC_glSampleMaski)Load("glSampleMaski");
+}
+
+static void Load_GL_VERSION_3_3()
+{
     glBindFragDataLocationIndexed = (GLPROC_glBindFragDataLocationIndexed)Load("glBindFragDataLocationIndexed");
     glGetFragDataIndex = (GLPROC_glGetFragDataIndex)Load("glGetFragDataIndex");
     glGenSamplers = (GLPROC_glGenSamplers)Load("glGenSamplers");
@@ -774,6 +875,10 @@ void LoadGL()
     glColorP4uiv = (GLPROC_glColorP4uiv)Load("glColorP4uiv");
     glSecondaryColorP3ui = (GLPROC_glSecondaryColorP3ui)Load("glSecondaryColorP3ui");
     glSecondaryColorP3uiv = (GLPROC_glSecondaryColorP3uiv)Load("glSecondaryColorP3uiv");
+}
+
+static void Load_GL_KHR_debug()
+{
     glDebugMessageControl = (GLPROC_glDebugMessageControl)Load("glDebugMessageControl");
     glDebugMessageInsert = (GLPROC_glDebugMessageInsert)Load("glDebugMessageInsert");
     glDebugMessageCallback = (GLPROC_glDebugMessageCallback)Load("glDebugMessageCallback");
@@ -786,3 +891,299 @@ void LoadGL()
     glGetObjectPtrLabel = (GLPROC_glGetObjectPtrLabel)Load("glGetObjectPtrLabel");
     glGetPointerv = (GLPROC_glGetPointerv)Load("glGetPointerv");
 }
+
+static void Load_GL_ARB_get_program_binary()
+{
+    glGetProgramBinary = (GLPROC_glGetProgramBinary)Load("glGetProgramBinary");
+    glProgramBinary = (GLPROC_glProgramBinary)Load("glProgramBinary");
+    glProgramParameteri = (GLPROC_glProgramParameteri)Load("glProgramParameteri");
+}
+
+static void Load_GL_KHR_parallel_shader_compile()
+{
+    glMaxShaderCompilerThreadsKHR = (GLPROC_glMaxShaderCompilerThreadsKHR)Load("glMaxShaderCompilerThreadsKHR");
+}
+
+static void Load_GL_ARB_draw_indirect()
+{
+    glDrawArraysIndirect = (GLPROC_glDrawArraysIndirect)Load("glDrawArraysIndirect");
+    glDrawElementsIndirect = (GLPROC_glDrawElementsIndirect)Load("glDrawElementsIndirect");
+}
+
+static void Load_GL_ARB_base_instance()
+{
+    glDrawArraysInstancedBaseInstance = (GLPROC_glDrawArraysInstancedBaseInstance)Load("glDrawArraysInstancedBaseInstance");
+    glDrawElementsInstancedBaseInstance = (GLPROC_glDrawElementsInstancedBaseInstance)Load("glDrawElementsInstancedBaseInstance");
+    glDrawElementsInstancedBaseVertexBaseInstance = (GLPROC_glDrawElementsInstancedBaseVertexBaseInstance)Load("glDrawElementsInstancedBaseVertexBaseInstance");
+}
+
+static void Load_GL_ARB_multi_draw_indirect()
+{
+    glMultiDrawArraysIndirect = (GLPROC_glMultiDrawArraysIndirect)Load("glMultiDrawArraysIndirect");
+    glMultiDrawElementsIndirect = (GLPROC_glMultiDrawElementsIndirect)Load("glMultiDrawElementsIndirect");
+}
+
+static void Load_GL_ARB_buffer_storage()
+{
+    glBufferStorage = (GLPROC_glBufferStorage)Load("glBufferStorage");
+}
+
+static void Load_GL_ARB_direct_state_access()
+{
+    glCreateBuffers = (GLPROC_glCreateBuffers)Load("glCreateBuffers");
+    glNamedBufferStorage = (GLPROC_glNamedBufferStorage)Load("glNamedBufferStorage");
+    glNamedBufferData = (GLPROC_glNamedBufferData)Load("glNamedBufferData");
+    glNamedBufferSubData = (GLPROC_glNamedBufferSubData)Load("glNamedBufferSubData");
+    glCopyNamedBufferSubData = (GLPROC_glCopyNamedBufferSubData)Load("glCopyNamedBufferSubData");
+    glClearNamedBufferData = (GLPROC_glClearNamedBufferData)Load("glClearNamedBufferData");
+    glClearNamedBufferSubData = (GLPROC_glClearNamedBufferSubData)Load("glClearNamedBufferSubData");
+    glMapNamedBuffer = (GLPROC_glMapNamedBuffer)Load("glMapNamedBuffer");
+    glMapNamedBufferRange = (GLPROC_glMapNamedBufferRange)Load("glMapNamedBufferRange");
+    glUnmapNamedBuffer = (GLPROC_glUnmapNamedBuffer)Load("glUnmapNamedBuffer");
+    glFlushMappedNamedBufferRange = (GLPROC_glFlushMappedNamedBufferRange)Load("glFlushMappedNamedBufferRange");
+    glGetNamedBufferParameteriv = (GLPROC_glGetNamedBufferParameteriv)Load("glGetNamedBufferParameteriv");
+    glGetNamedBufferParameteri64v = (GLPROC_glGetNamedBufferParameteri64v)Load("glGetNamedBufferParameteri64v");
+    glGetNamedBufferPointerv = (GLPROC_glGetNamedBufferPointerv)Load("glGetNamedBufferPointerv");
+    glGetNamedBufferSubData = (GLPROC_glGetNamedBufferSubData)Load("glGetNamedBufferSubData");
+    glCreateVertexArrays = (GLPROC_glCreateVertexArrays)Load("glCreateVertexArrays");
+    glDisableVertexArrayAttrib = (GLPROC_glDisableVertexArrayAttrib)Load("glDisableVertexArrayAttrib");
+    glEnableVertexArrayAttrib = (GLPROC_glEnableVertexArrayAttrib)Load("glEnableVertexArrayAttrib");
+    glVertexArrayElementBuffer = (GLPROC_glVertexArrayElementBuffer)Load("glVertexArrayElementBuffer");
+    glVertexArrayVertexBuffer = (GLPROC_glVertexArrayVertexBuffer)Load("glVertexArrayVertexBuffer");
+    glVertexArrayVertexBuffers = (GLPROC_glVertexArrayVertexBuffers)Load("glVertexArrayVertexBuffers");
+    glVertexArrayAttribBinding = (GLPROC_glVertexArrayAttribBinding)Load("glVertexArrayAttribBinding");
+    glVertexArrayAttribFormat = (GLPROC_glVertexArrayAttribFormat)Load("glVertexArrayAttribFormat");
+    glVertexArrayAttribIFormat = (GLPROC_glVertexArrayAttribIFormat)Load("glVertexArrayAttribIFormat");
+    glVertexArrayAttribLFormat = (GLPROC_glVertexArrayAttribLFormat)Load("glVertexArrayAttribLFormat");
+    glVertexArrayBindingDivisor = (GLPROC_glVertexArrayBindingDivisor)Load("glVertexArrayBindingDivisor");
+    glGetVertexArrayiv = (GLPROC_glGetVertexArrayiv)Load("glGetVertexArrayiv");
+    glGetVertexArrayIndexediv = (GLPROC_glGetVertexArrayIndexediv)Load("glGetVertexArrayIndexediv");
+    glGetVertexArrayIndexed64iv = (GLPROC_glGetVertexArrayIndexed64iv)Load("glGetVertexArrayIndexed64iv");
+}
+
+static void Load_GL_ARB_texture_buffer_range()
+{
+    glTexBufferRange = (GLPROC_glTexBufferRange)Load("glTexBufferRange");
+}
+
+static void Load_GL_ARB_shader_image_load_store()
+{
+    glBindImageTexture = (GLPROC_glBindImageTexture)Load("glBindImageTexture");
+    glMemoryBarrier = (GLPROC_glMemoryBarrier)Load("glMemoryBarrier");
+}
+
+static void Load_GL_ARB_compute_shader()
+{
+    glDispatchCompute = (GLPROC_glDispatchCompute)Load("glDispatchCompute");
+    glDispatchComputeIndirect = (GLPROC_glDispatchComputeIndirect)Load("glDispatchComputeIndirect");
+}
+
+static void Load_GL_ARB_shader_storage_buffer_object()
+{
+    glShaderStorageBlockBinding = (GLPROC_glShaderStorageBlockBinding)Load("glShaderStorageBlockBinding");
+}
+
+static void Load_GL_ARB_clear_buffer_object()
+{
+    glClearBufferData = (GLPROC_glClearBufferData)Load("glClearBufferData");
+    glClearBufferSubData = (GLPROC_glClearBufferSubData)Load("glClearBufferSubData");
+}
+
+// The functions only lost their ARB suffix when they became core in 4.6:
+static void Load_GL_ARB_indirect_parameters(bool core)
+{
+    glMultiDrawArraysIndirectCount = (GLPROC_glMultiDrawArraysIndirectCount)Load(core ? "glMultiDrawArraysIndirectCount" : "glMultiDrawArraysIndirectCountARB");
+    glMultiDrawElementsIndirectCount = (GLPROC_glMultiDrawElementsIndirectCount)Load(core ? "glMultiDrawElementsIndirectCount" : "glMultiDrawElementsIndirectCountARB");
+}
+
+static bool HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        if (strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Only the groups that the context supports are loaded. Check GLSupported before using anything
+// beyond the version that was requested; pointers in groups that were not loaded are NULL.
+void LoadGL()
+{
+    glGetString = (GLPROC_glGetString)Load("glGetString");
+    glGetStringi = (GLPROC_glGetStringi)Load("glGetStringi");
+    glGetIntegerv = (GLPROC_glGetIntegerv)Load("glGetIntegerv");
+
+    int major = 0, minor = 0;
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (version)
+    {
+        sscanf(version, "%d.%d", &major, &minor);
+    }
+    int v = major * 10 + minor;
+
+    GLSupported.VERSION_1_0 = v >= 10;
+    GLSupported.VERSION_1_1 = v >= 11;
+    GLSupported.VERSION_1_2 = v >= 12;
+    GLSupported.VERSION_1_3 = v >= 13;
+    GLSupported.VERSION_1_4 = v >= 14;
+    GLSupported.VERSION_1_5 = v >= 15;
+    GLSupported.VERSION_2_0 = v >= 20;
+    GLSupported.VERSION_2_1 = v >= 21;
+    GLSupported.VERSION_3_0 = v >= 30;
+    GLSupported.VERSION_3_1 = v >= 31;
+    GLSupported.VERSION_3_2 = v >= 32;
+    GLSupported.VERSION_3_3 = v >= 33;
+    GLSupported.KHR_debug = v >= 43 || HasExtension("GL_KHR_debug");
+    GLSupported.ARB_get_program_binary = v >= 41 || HasExtension("GL_ARB_get_program_binary");
+    GLSupported.KHR_parallel_shader_compile = HasExtension("GL_KHR_parallel_shader_compile");
+    GLSupported.ARB_draw_indirect = v >= 40 || HasExtension("GL_ARB_draw_indirect");
+    GLSupported.ARB_base_instance = v >= 42 || HasExtension("GL_ARB_base_instance");
+    GLSupported.ARB_multi_draw_indirect = v >= 43 || HasExtension("GL_ARB_multi_draw_indirect");
+    GLSupported.ARB_buffer_storage = v >= 44 || HasExtension("GL_ARB_buffer_storage");
+    GLSupported.ARB_direct_state_access = v >= 45 || HasExtension("GL_ARB_direct_state_access");
+    GLSupported.ARB_texture_buffer_range = v >= 43 || HasExtension("GL_ARB_texture_buffer_range");
+    GLSupported.ARB_shader_draw_parameters = v >= 46 || HasExtension("GL_ARB_shader_draw_parameters");
+    GLSupported.ARB_shader_image_load_store = v >= 42 || HasExtension("GL_ARB_shader_image_load_store");
+    GLSupported.ARB_compute_shader = v >= 43 || HasExtension("GL_ARB_compute_shader");
+    GLSupported.ARB_shader_storage_buffer_object = v >= 43 || HasExtension("GL_ARB_shader_storage_buffer_object");
+    GLSupported.ARB_clear_buffer_object = v >= 43 || HasExtension("GL_ARB_clear_buffer_object");
+    GLSupported.ARB_indirect_parameters = v >= 46 || HasExtension("GL_ARB_indirect_parameters");
+
+    // A version is only supported if every function in it and in the versions before it was found:
+    MissingProcs = 0;
+    if (GLSupported.VERSION_1_0)
+    {
+        Load_GL_VERSION_1_0();
+        GLSupported.VERSION_1_0 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_1_1)
+    {
+        Load_GL_VERSION_1_1();
+        GLSupported.VERSION_1_1 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_1_2)
+    {
+        Load_GL_VERSION_1_2();
+        GLSupported.VERSION_1_2 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_1_3)
+    {
+        Load_GL_VERSION_1_3();
+        GLSupported.VERSION_1_3 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_1_4)
+    {
+        Load_GL_VERSION_1_4();
+        GLSupported.VERSION_1_4 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_1_5)
+    {
+        Load_GL_VERSION_1_5();
+        GLSupported.VERSION_1_5 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_2_0)
+    {
+        Load_GL_VERSION_2_0();
+        GLSupported.VERSION_2_0 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_2_1)
+    {
+        Load_GL_VERSION_2_1();
+        GLSupported.VERSION_2_1 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_3_0)
+    {
+        Load_GL_VERSION_3_0();
+        GLSupported.VERSION_3_0 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_3_1)
+    {
+        Load_GL_VERSION_3_1();
+        GLSupported.VERSION_3_1 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_3_2)
+    {
+        Load_GL_VERSION_3_2();
+        GLSupported.VERSION_3_2 = MissingProcs == 0;
+    }
+    if (GLSupported.VERSION_3_3)
+    {
+        Load_GL_VERSION_3_3();
+        GLSupported.VERSION_3_3 = MissingProcs == 0;
+    }
+    if (GLSupported.KHR_debug)
+    {
+        Load_GL_KHR_debug();
+        GLSupported.KHR_debug = glDebugMessageControl && glDebugMessageInsert && glDebugMessageCallback && glGetDebugMessageLog && glPushDebugGroup && glPopDebugGroup && glObjectLabel && glGetObjectLabel && glObjectPtrLabel && glGetObjectPtrLabel && glGetPointerv;
+    }
+    if (GLSupported.ARB_get_program_binary)
+    {
+        Load_GL_ARB_get_program_binary();
+        GLSupported.ARB_get_program_binary = glGetProgramBinary && glProgramBinary && glProgramParameteri;
+    }
+    if (GLSupported.KHR_parallel_shader_compile)
+    {
+        Load_GL_KHR_parallel_shader_compile();
+        GLSupported.KHR_parallel_shader_compile = glMaxShaderCompilerThreadsKHR;
+    }
+    if (GLSupported.ARB_draw_indirect)
+    {
+        Load_GL_ARB_draw_indirect();
+        GLSupported.ARB_draw_indirect = glDrawArraysIndirect && glDrawElementsIndirect;
+    }
+    if (GLSupported.ARB_base_instance)
+    {
+        Load_GL_ARB_base_instance();
+        GLSupported.ARB_base_instance = glDrawArraysInstancedBaseInstance && glDrawElementsInstancedBaseInstance && glDrawElementsInstancedBaseVertexBaseInstance;
+    }
+    if (GLSupported.ARB_multi_draw_indirect)
+    {
+        Load_GL_ARB_multi_draw_indirect();
+        GLSupported.ARB_multi_draw_indirect = glMultiDrawArraysIndirect && glMultiDrawElementsIndirect;
+    }
+    if (GLSupported.ARB_buffer_storage)
+    {
+        Load_GL_ARB_buffer_storage();
+        GLSupported.ARB_buffer_storage = glBufferStorage;
+    }
+    if (GLSupported.ARB_direct_state_access)
+    {
+        Load_GL_ARB_direct_state_access();
+        GLSupported.ARB_direct_state_access = glCreateBuffers && glNamedBufferStorage && glNamedBufferData && glNamedBufferSubData && glCopyNamedBufferSubData && glClearNamedBufferData && glClearNamedBufferSubData && glMapNamedBuffer && glMapNamedBufferRange && glUnmapNamedBuffer && glFlushMappedNamedBufferRange && glGetNamedBufferParameteriv && glGetNamedBufferParameteri64v && glGetNamedBufferPointerv && glGetNamedBufferSubData && glCreateVertexArrays && glDisableVertexArrayAttrib && glEnableVertexArrayAttrib && glVertexArrayElementBuffer && glVertexArrayVertexBuffer && glVertexArrayVertexBuffers && glVertexArrayAttribBinding && glVertexArrayAttribFormat && glVertexArrayAttribIFormat && glVertexArrayAttribLFormat && glVertexArrayBindingDivisor && glGetVertexArrayiv && glGetVertexArrayIndexediv && glGetVertexArrayIndexed64iv;
+    }
+    if (GLSupported.ARB_texture_buffer_range)
+    {
+        Load_GL_ARB_texture_buffer_range();
+        GLSupported.ARB_texture_buffer_range = glTexBufferRange;
+    }
+    if (GLSupported.ARB_shader_image_load_store)
+    {
+        Load_GL_ARB_shader_image_load_store();
+        GLSupported.ARB_shader_image_load_store = glBindImageTexture && glMemoryBarrier;
+    }
+    if (GLSupported.ARB_compute_shader)
+    {
+        Load_GL_ARB_compute_shader();
+        GLSupported.ARB_compute_shader = glDispatchCompute && glDispatchComputeIndirect;
+    }
+    if (GLSupported.ARB_shader_storage_buffer_object)
+    {
+        Load_GL_ARB_shader_storage_buffer_object();
+        GLSupported.ARB_shader_storage_buffer_object = glShaderStorageBlockBinding;
+    }
+    if (GLSupported.ARB_clear_buffer_object)
+    {
+        Load_GL_ARB_clear_buffer_object();
+        GLSupported.ARB_clear_buffer_object = glClearBufferData && glClearBufferSubData;
+    }
+    if (GLSupported.ARB_indirect_parameters)
+    {
+        Load_GL_ARB_indirect_parameters(v >= 46);
+        GLSupported.ARB_indirect_parameters = glMultiDrawArraysIndirectCount && glMultiDrawElementsIndirectCount;
+    }
+}
@@ -17,7 +17,22 @@
 //
 // GL extensions included:
 //   GL_KHR_debug
+//   GL_ARB_get_program_binary
+//   GL_KHR_parallel_shader_compile
+//   GL_ARB_draw_indirect
+//   GL_ARB_base_instance
+//   GL_ARB_multi_draw_indirect
+//   GL_ARB_buffer_storage
+//   GL_ARB_direct_state_access
+//   GL_ARB_texture_buffer_range
+//   GL_ARB_shader_draw_parameters
+//   GL_ARB_shader_image_load_store
+//   GL_ARB_compute_shader
+//   GL_ARB_shader_storage_buffer_object
+//   GL_ARB_clear_buffer_object
+//   GL_ARB_indirect_parameters
 
+#include <stdbool.h>
 #include "khrplatform.h"
 
 typedef unsigned int GLenum;
@@ -924,6 +939,75 @@ typedef void ( *GLVULKANPROCNV)(void);
 #define GL_STACK_OVERFLOW 0x00000503
 #define GL_STACK_UNDERFLOW 0x00000504
 #define GL_DISPLAY_LIST 0x000082E7
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x00008257
+#define GL_PROGRAM_BINARY_LENGTH 0x00008741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x000087FE
+#define GL_PROGRAM_BINARY_FORMATS 0x000087FF
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x000091B0
+#define GL_COMPLETION_STATUS_KHR 0x000091B1
+#define GL_DRAW_INDIRECT_BUFFER 0x00008F3F
+#define GL_DRAW_INDIRECT_BUFFER_BINDING 0x00008F43
+#define GL_MAP_PERSISTENT_BIT 0x00000040
+#define GL_MAP_COHERENT_BIT 0x00000080
+#define GL_DYNAMIC_STORAGE_BIT 0x00000100
+#define GL_CLIENT_STORAGE_BIT 0x00000200
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+#define GL_BUFFER_IMMUTABLE_STORAGE 0x0000821F
+#define GL_BUFFER_STORAGE_FLAGS 0x00008220
+#define GL_TEXTURE_TARGET 0x00001006
+#define GL_QUERY_TARGET 0x000082EA
+#define GL_TEXTURE_BUFFER_OFFSET 0x0000919D
+#define GL_TEXTURE_BUFFER_SIZE 0x0000919E
+#define GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT 0x0000919F
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_ELEMENT_ARRAY_BARRIER_BIT 0x00000002
+#define GL_UNIFORM_BARRIER_BIT 0x00000004
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_PIXEL_BUFFER_BARRIER_BIT 0x00000080
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_TRANSFORM_FEEDBACK_BARRIER_BIT 0x00000800
+#define GL_ATOMIC_COUNTER_BARRIER_BIT 0x00001000
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+#define GL_COMPUTE_SHADER 0x000091B9
+#define GL_MAX_COMPUTE_UNIFORM_BLOCKS 0x000091BB
+#define GL_MAX_COMPUTE_TEXTURE_IMAGE_UNITS 0x000091BC
+#define GL_MAX_COMPUTE_IMAGE_UNIFORMS 0x000091BD
+#define GL_MAX_COMPUTE_SHARED_MEMORY_SIZE 0x00008262
+#define GL_MAX_COMPUTE_UNIFORM_COMPONENTS 0x00008263
+#define GL_MAX_COMPUTE_ATOMIC_COUNTER_BUFFERS 0x00008264
+#define GL_MAX_COMPUTE_ATOMIC_COUNTERS 0x00008265
+#define GL_MAX_COMBINED_COMPUTE_UNIFORM_COMPONENTS 0x00008266
+#define GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS 0x000090EB
+#define GL_MAX_COMPUTE_WORK_GROUP_COUNT 0x000091BE
+#define GL_MAX_COMPUTE_WORK_GROUP_SIZE 0x000091BF
+#define GL_COMPUTE_WORK_GROUP_SIZE 0x00008267
+#define GL_UNIFORM_BLOCK_REFERENCED_BY_COMPUTE_SHADER 0x000090EC
+#define GL_ATOMIC_COUNTER_BUFFER_REFERENCED_BY_COMPUTE_SHADER 0x000090ED
+#define GL_DISPATCH_INDIRECT_BUFFER 0x000090EE
+#define GL_DISPATCH_INDIRECT_BUFFER_BINDING 0x000090EF
+#define GL_COMPUTE_SHADER_BIT 0x00000020
+#define GL_SHADER_STORAGE_BUFFER 0x000090D2
+#define GL_SHADER_STORAGE_BUFFER_BINDING 0x000090D3
+#define GL_SHADER_STORAGE_BUFFER_START 0x000090D4
+#define GL_SHADER_STORAGE_BUFFER_SIZE 0x000090D5
+#define GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS 0x000090D6
+#define GL_MAX_GEOMETRY_SHADER_STORAGE_BLOCKS 0x000090D7
+#define GL_MAX_TESS_CONTROL_SHADER_STORAGE_BLOCKS 0x000090D8
+#define GL_MAX_TESS_EVALUATION_SHADER_STORAGE_BLOCKS 0x000090D9
+#define GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS 0x000090DA
+#define GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS 0x000090DB
+#define GL_MAX_COMBINED_SHADER_STORAGE_BLOCKS 0x000090DC
+#define GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS 0x000090DD
+#define GL_MAX_SHADER_STORAGE_BLOCK_SIZE 0x000090DE
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x000090DF
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#define GL_MAX_COMBINED_SHADER_OUTPUT_RESOURCES 0x00008F39
+#define GL_PARAMETER_BUFFER 0x000080EE
+#define GL_PARAMETER_BUFFER_BINDING 0x000080EF
 
 typedef void (*GLPROC_glCullFace)(GLenum mode);
 typedef void (*GLPROC_glFrontFace)(GLenum mode);
@@ -1310,6 +1394,57 @@ typedef void (*GLPROC_glGetObjectLabel)(GLenum identifier, GLuint name, GLsizei
 typedef void (*GLPROC_glObjectPtrLabel)(const void * ptr, GLsizei length, const GLchar * label);
 typedef void (*GLPROC_glGetObjectPtrLabel)(const void * ptr, GLsizei bufSize, GLsizei * length, GLchar * label);
 typedef void (*GLPROC_glGetPointerv)(GLenum pname, void ** params);
+typedef void (*GLPROC_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei * length, GLenum * binaryFormat, void * binary);
+typedef void (*GLPROC_glProgramBinary)(GLuint program, GLenum binaryFormat, const void * binary, GLsizei length);
+typedef void (*GLPROC_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+typedef void (*GLPROC_glMaxShaderCompilerThreadsKHR)(GLuint count);
+typedef void (*GLPROC_glDrawArraysIndirect)(GLenum mode, const void * indirect);
+typedef void (*GLPROC_glDrawElementsIndirect)(GLenum mode, GLenum type, const void * indirect);
+typedef void (*GLPROC_glDrawArraysInstancedBaseInstance)(GLenum mode, GLint first, GLsizei count, GLsizei instancecount, GLuint baseinstance);
+typedef void (*GLPROC_glDrawElementsInstancedBaseInstance)(GLenum mode, GLsizei count, GLenum type, const void * indices, GLsizei instancecount, GLuint baseinstance);
+typedef void (*GLPROC_glDrawElementsInstancedBaseVertexBaseInstance)(GLenum mode, GLsizei count, GLenum type, const void * indices, GLsizei instancecount, GLint basevertex, GLuint baseinstance);
+typedef void (*GLPROC_glMultiDrawArraysIndirect)(GLenum mode, const void * indirect, GLsizei drawcount, GLsizei stride);
+typedef void (*GLPROC_glMultiDrawElementsIndirect)(GLenum mode, GLenum type, const void * indirect, GLsizei drawcount, GLsizei stride);
+typedef void (*GLPROC_glBufferStorage)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags);
+typedef void (*GLPROC_glCreateBuffers)(GLsizei n, GLuint * buffers);
+typedef void (*GLPROC_glNamedBufferStorage)(GLuint buffer, GLsizeiptr size, const void * data, GLbitfield flags);
+typedef void (*GLPROC_glNamedBufferData)(GLuint buffer, GLsizeiptr size, const void * data, GLenum usage);
+typedef void (*GLPROC_glNamedBufferSubData)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void * data);
+typedef void (*GLPROC_glCopyNamedBufferSubData)(GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+typedef void (*GLPROC_glClearNamedBufferData)(GLuint buffer, GLenum internalformat, GLenum format, GLenum type, const void * data);
+typedef void (*GLPROC_glClearNamedBufferSubData)(GLuint buffer, GLenum internalformat, GLintptr offset, GLsizeiptr size, GLenum format, GLenum type, const void * data);
+typedef void * (*GLPROC_glMapNamedBuffer)(GLuint buffer, GLenum access);
+typedef void * (*GLPROC_glMapNamedBufferRange)(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (*GLPROC_glUnmapNamedBuffer)(GLuint buffer);
+typedef void (*GLPROC_glFlushMappedNamedBufferRange)(GLuint buffer, GLintptr offset, GLsizeiptr length);
+typedef void (*GLPROC_glGetNamedBufferParameteriv)(GLuint buffer, GLenum pname, GLint * params);
+typedef void (*GLPROC_glGetNamedBufferParameteri64v)(GLuint buffer, GLenum pname, GLint64 * params);
+typedef void (*GLPROC_glGetNamedBufferPointerv)(GLuint buffer, GLenum pname, void ** params);
+typedef void (*GLPROC_glGetNamedBufferSubData)(GLuint buffer, GLintptr offset, GLsizeiptr size, void * data);
+typedef void (*GLPROC_glCreateVertexArrays)(GLsizei n, GLuint * arrays);
+typedef void (*GLPROC_glDisableVertexArrayAttrib)(GLuint vaobj, GLuint index);
+typedef void (*GLPROC_glEnableVertexArrayAttrib)(GLuint vaobj, GLuint index);
+typedef void (*GLPROC_glVertexArrayElementBuffer)(GLuint vaobj, GLuint buffer);
+typedef void (*GLPROC_glVertexArrayVertexBuffer)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+typedef void (*GLPROC_glVertexArrayVertexBuffers)(GLuint vaobj, GLuint first, GLsizei count, const GLuint * buffers, const GLintptr * offsets, const GLsizei * strides);
+typedef void (*GLPROC_glVertexArrayAttribBinding)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+typedef void (*GLPROC_glVertexArrayAttribFormat)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+typedef void (*GLPROC_glVertexArrayAttribIFormat)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+typedef void (*GLPROC_glVertexArrayAttribLFormat)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+typedef void (*GLPROC_glVertexArrayBindingDivisor)(GLuint vaobj, GLuint bindingindex, GLuint divisor);
+typedef void (*GLPROC_glGetVertexArrayiv)(GLuint vaobj, GLenum pname, GLint * param);
+typedef void (*GLPROC_glGetVertexArrayIndexediv)(GLuint vaobj, GLuint index, GLenum pname, GLint * param);
+typedef void (*GLPROC_glGetVertexArrayIndexed64iv)(GLuint vaobj, GLuint index, GLenum pname, GLint64 * param);
+typedef void (*GLPROC_glTexBufferRange)(GLenum target, GLenum internalformat, GLuint buffer, GLintptr offset, GLsizeiptr size);
+typedef void (*GLPROC_glBindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (*GLPROC_glMemoryBarrier)(GLbitfield barriers);
+typedef void (*GLPROC_glDispatchCompute)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (*GLPROC_glDispatchComputeIndirect)(GLintptr indirect);
+typedef void (*GLPROC_glShaderStorageBlockBinding)(GLuint program, GLuint storageBlockIndex, GLuint storageBlockBinding);
+typedef void (*GLPROC_glClearBufferData)(GLenum target, GLenum internalformat, GLenum format, GLenum type, const void * data);
+typedef void (*GLPROC_glClearBufferSubData)(GLenum target, GLenum internalformat, GLintptr offset, GLsizeiptr size, GLenum format, GLenum type, const void * data);
+typedef void (*GLPROC_glMultiDrawArraysIndirectCount)(GLenum mode, const void * indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
+typedef void (*GLPROC_glMultiDrawElementsIndirectCount)(GLenum mode, GLenum type, const void * indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
 
 extern GLPROC_glCullFace glCullFace;
 extern GLPROC_glFrontFace glFrontFace;
@@ -1696,5 +1831,89 @@ extern GLPROC_glGetObjectLabel glGetObjectLabel;
 extern GLPROC_glObjectPtrLabel glObjectPtrLabel;
 extern GLPROC_glGetObjectPtrLabel glGetObjectPtrLabel;
 extern GLPROC_glGetPointerv glGetPointerv;
+extern GLPROC_glGetProgramBinary glGetProgramBinary;
+extern GLPROC_glProgramBinary glProgramBinary;
+extern GLPROC_glProgramParameteri glProgramParameteri;
+extern GLPROC_glMaxShaderCompilerThreadsKHR glMaxShaderCompilerThreadsKHR;
+extern GLPROC_glDrawArraysIndirect glDrawArraysIndirect;
+extern GLPROC_glDrawElementsIndirect glDrawElementsIndirect;
+extern GLPROC_glDrawArraysInstancedBaseInstance glDrawArraysInstancedBaseInstance;
+extern GLPROC_glDrawElementsInstancedBaseInstance glDrawElementsInstancedBaseInstance;
+extern GLPROC_glDrawElementsInstancedBaseVertexBaseInstance glDrawElementsInstancedBaseVertexBaseInstance;
+extern GLPROC_glMultiDrawArraysIndirect glMultiDrawArraysIndirect;
+extern GLPROC_glMultiDrawElementsIndirect glMultiDrawElementsIndirect;
+extern GLPROC_glBufferStorage glBufferStorage;
+extern GLPROC_glCreateBuffers glCreateBuffers;
+extern GLPROC_glNamedBufferStorage glNamedBufferStorage;
+extern GLPROC_glNamedBufferData glNamedBufferData;
+extern GLPROC_glNamedBufferSubData glNamedBufferSubData;
+extern GLPROC_glCopyNamedBufferSubData glCopyNamedBufferSubData;
+extern GLPROC_glClearNamedBufferData glClearNamedBufferData;
+extern GLPROC_glClearNamedBufferSubData glClearNamedBufferSubData;
+extern GLPROC_glMapNamedBuffer glMapNamedBuffer;
+extern GLPROC_glMapNamedBufferRange glMapNamedBufferRange;
+extern GLPROC_glUnmapNamedBuffer glUnmapNamedBuffer;
+extern GLPROC_glFlushMappedNamedBufferRange glFlushMappedNamedBufferRange;
+extern GLPROC_glGetNamedBufferParameteriv glGetNamedBufferParameteriv;
+extern GLPROC_glGetNamedBufferParameteri64v glGetNamedBufferParameteri64v;
+extern GLPROC_glGetNamedBufferPointerv glGetNamedBufferPointerv;
+extern GLPROC_glGetNamedBufferSubData glGetNamedBufferSubData;
+extern GLPROC_glCreateVertexArrays glCreateVertexArrays;
+extern GLPROC_glDisableVertexArrayAttrib glDisableVertexArrayAttrib;
+extern GLPROC_glEnableVertexArrayAttrib glEnableVertexArrayAttrib;
+extern GLPROC_glVertexArrayElementBuffer glVertexArrayElementBuffer;
+extern GLPROC_glVertexArrayVertexBuffer glVertexArrayVertexBuffer;
+extern GLPROC_glVertexArrayVertexBuffers glVertexArrayVertexBuffers;
+extern GLPROC_glVertexArrayAttribBinding glVertexArrayAttribBinding;
+extern GLPROC_glVertexArrayAttribFormat glVertexArrayAttribFormat;
+extern GLPROC_glVertexArrayAttribIFormat glVertexArrayAttribIFormat;
+extern GLPROC_glVertexArrayAttribLFormat glVertexArrayAttribLFormat;
+extern GLPROC_glVertexArrayBindingDivisor glVertexArrayBindingDivisor;
+extern GLPROC_glGetVertexArrayiv glGetVertexArrayiv;
+extern GLPROC_glGetVertexArrayIndexediv glGetVertexArrayIndexediv;
+extern GLPROC_glGetVertexArrayIndexed64iv glGetVertexArrayIndexed64iv;
+extern GLPROC_glTexBufferRange glTexBufferRange;
+extern GLPROC_glBindImageTexture glBindImageTexture;
+extern GLPROC_glMemoryBarrier glMemoryBarrier;
+extern GLPROC_glDispatchCompute glDispatchCompute;
+extern GLPROC_glDispatchComputeIndirect glDispatchComputeIndirect;
+extern GLPROC_glShaderStorageBlockBinding glShaderStorageBlockBinding;
+extern GLPROC_glClearBufferData glClearBufferData;
+extern GLPROC_glClearBufferSubData glClearBufferSubData;
+extern GLPROC_glMultiDrawArraysIndirectCount glMultiDrawArraysIndirectCount;
+extern GLPROC_glMultiDrawElementsIndirectCount glMultiDrawElementsIndirectCount;
+
+typedef struct GLSupport
+{
+    bool VERSION_1_0;
+    bool VERSION_1_1;
+    bool VERSION_1_2;
+    bool VERSION_1_3;
+    bool VERSION_1_4;
+    bool VERSION_1_5;
+    bool VERSION_2_0;
+    bool VERSION_2_1;
+    bool VERSION_3_0;
+    bool VERSION_3_1;
+    bool VERSION_3_2;
+    bool VERSION_3_3;
+    bool KHR_debug;
+    bool ARB_get_program_binary;
+    bool KHR_parallel_shader_compile;
+    bool ARB_draw_indirect;
+    bool ARB_base_instance;
+    bool ARB_multi_draw_indirect;
+    bool ARB_buffer_storage;
+    bool ARB_direct_state_access;
+    bool ARB_texture_buffer_range;
+    bool ARB_shader_draw_parameters;
+    bool ARB_shader_image_load_store;
+    bool ARB_compute_shader;
+    bool ARB_shader_storage_buffer_object;
+    bool ARB_clear_buffer_object;
+    bool ARB_indirect_parameters;
+} GLSupport;
+
+extern GLSupport GLSupported;
 
 void LoadGL();
@@ -0,0 +1,30 @@
+// Layout of the packed asset archive (assets.pak), shared by the game and tools/packassets.c.
+//
+// The file starts with an AssetArchiveHeader, followed by the table of contents: one
+// AssetArchiveEntry per file, sorted by name so it can be binary searched. Names are stored as
+// NUL-terminated paths relative to the assets directory, using forward slashes. Each file's data
+// starts on an ASSET_ALIGNMENT boundary and is followed by a NUL byte, so text files can be used
+// as C strings straight from the mapped archive. All offsets are from the start of the file and
+// all fields are little-endian.
+
+#include <stdint.h>
+
+#define ASSET_ARCHIVE_MAGIC 0x4B505353 // "SSPK"
+#define ASSET_ARCHIVE_VERSION 1
+#define ASSET_ALIGNMENT 16
+
+typedef struct AssetArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+} AssetArchiveHeader;
+
+typedef struct AssetArchiveEntry
+{
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+} AssetArchiveEntry;
@@ -0,0 +1,257 @@
+#include "common.h"
+#include "assetformat.h"
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ASSET_ARCHIVE_NAME "assets.pak"
+#define ASSET_DIRECTORY_NAME "assets/"
+
+// Release builds can compile the archive into the executable; see tools/packassets.c and build.sh.
+#ifdef EMBED_ASSETS
+extern const uint8_t *EmbeddedAssetArchive;
+extern const size_t EmbeddedAssetArchiveSize;
+#endif
+
+static struct assetGlobals
+{
+    bool started;
+    char *baseDirectory;
+    char *assetDirectory;
+
+    // The mapped archive, if there is one:
+    const uint8_t *archive;
+    size_t archiveSize;
+    const AssetArchiveEntry *entries;
+    uint32_t entryCount;
+} g;
+
+//=============================================================================================
+// Memory-mapped files
+//=============================================================================================
+
+#ifdef _WIN32
+
+static const void *mapFile(char *path, size_t *size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    const void *view = NULL;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            *size = (size_t)fileSize.QuadPart;
+            // The view keeps the mapping alive:
+            CloseHandle(mapping);
+        }
+    }
+
+    CloseHandle(file);
+    return view;
+}
+
+#else
+
+static const void *mapFile(char *path, size_t *size)
+{
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return NULL;
+    }
+
+    const void *view = NULL;
+    struct stat info;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (p != MAP_FAILED)
+        {
+            view = p;
+            *size = info.st_size;
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed:
+    close(file);
+    return view;
+}
+
+#endif
+
+//=============================================================================================
+// Archive
+//=============================================================================================
+
+static bool validateArchive(const uint8_t *archive, size_t size)
+{
+    if (size < sizeof(AssetArchiveHeader))
+    {
+        return false;
+    }
+
+    const AssetArchiveHeader *header = (const AssetArchiveHeader *)archive;
+    if (header->magic != ASSET_ARCHIVE_MAGIC ||
+        header->version != ASSET_ARCHIVE_VERSION ||
+        header->entryCount > (size - sizeof(*header)) / sizeof(AssetArchiveEntry))
+    {
+        return false;
+    }
+
+    // Check every entry once here so that lookups can trust the table of contents:
+    const AssetArchiveEntry *entries = (const AssetArchiveEntry *)(header + 1);
+    for (uint32_t i = 0; i < header->entryCount; i++)
+    {
+        const AssetArchiveEntry *e = &entries[i];
+        if ((uint64_t)e->nameOffset + e->nameLength >= size ||
+            archive[e->nameOffset + e->nameLength] != '\0' ||
+            e->dataOffset > size ||
+            e->dataSize >= size - e->dataOffset ||
+            archive[e->dataOffset + e->dataSize] != '\0')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void useArchive(const uint8_t *archive, size_t size)
+{
+    g.archive = archive;
+    g.archiveSize = size;
+    g.entries = (const AssetArchiveEntry *)(archive + sizeof(AssetArchiveHeader));
+    g.entryCount = ((const AssetArchiveHeader *)archive)->entryCount;
+}
+
+static void startAssets()
+{
+    g.started = true;
+
+    // Assets are found next to the executable, not in the current directory:
+    g.baseDirectory = SDL_GetBasePath();
+    if (!g.baseDirectory)
+    {
+        g.baseDirectory = SDL_strdup("");
+    }
+    size_t length = strlen(g.baseDirectory) + sizeof(ASSET_DIRECTORY_NAME);
+    g.assetDirectory = xalloc(length);
+    snprintf(g.assetDirectory, length, "%s" ASSET_DIRECTORY_NAME, g.baseDirectory);
+
+#ifdef EMBED_ASSETS
+    // The archive is compiled into the executable, so there is no file to open:
+    check(validateArchive(EmbeddedAssetArchive, EmbeddedAssetArchiveSize), "invalid embedded assets");
+    useArchive(EmbeddedAssetArchive, EmbeddedAssetArchiveSize);
+#else
+    char archivePath[1024];
+    snprintf(archivePath, sizeof(archivePath), "%s" ASSET_ARCHIVE_NAME, g.baseDirectory);
+    size_t size = 0;
+    const uint8_t *archive = mapFile(archivePath, &size);
+    if (archive && validateArchive(archive, size))
+    {
+        useArchive(archive, size);
+    }
+    else if (archive)
+    {
+        fprintf(stderr, "warning: ignoring invalid asset archive: %s\n", archivePath);
+    }
+#endif
+}
+
+static const AssetArchiveEntry *findArchiveEntry(char *name)
+{
+    uint32_t low = 0, high = g.entryCount;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        int order = strcmp(name, (const char *)g.archive + g.entries[mid].nameOffset);
+        if (order == 0)
+        {
+            return &g.entries[mid];
+        }
+        else if (order < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+//=============================================================================================
+// Assets
+//=============================================================================================
+
+// Stops using the archive so that assets are always read from the assets directory, which is
+// what hot reload watches.
+void useLooseAssets()
+{
+    if (!g.started)
+    {
+        startAssets();
+    }
+    g.entryCount = 0;
+}
+
+char *getAssetDirectory()
+{
+    if (!g.started)
+    {
+        startAssets();
+    }
+    return g.assetDirectory;
+}
+
+// Finds an asset by its path relative to the assets directory. Assets in the archive are
+// returned in place; otherwise the file is read from the assets directory, and releaseAsset must
+// be called when done with it either way. The data is always followed by a NUL byte.
+bool loadAsset(char *name, Asset *asset)
+{
+    if (!g.started)
+    {
+        startAssets();
+    }
+
+    memset(asset, 0, sizeof(*asset));
+    const AssetArchiveEntry *entry = findArchiveEntry(name);
+    if (entry)
+    {
+        asset->data = (const char *)g.archive + entry->dataOffset;
+        asset->size = (size_t)entry->dataSize;
+        return true;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%s", g.assetDirectory, name);
+    asset->data = tryReadFile(path, &asset->size);
+    asset->allocated = true;
+    return asset->data != NULL;
+}
+
+void releaseAsset(Asset *asset)
+{
+    if (asset->allocated)
+    {
+        free((void *)asset->data);
+    }
+    memset(asset, 0, sizeof(*asset));
+}
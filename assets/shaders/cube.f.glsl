@@ -1,5 +1,7 @@
 #version 330
 
+#include "lighting.glsl"
+
 uniform float uniAmbientLight;
 
 in vec3 vertNormal;
@@ -8,10 +10,11 @@ in vec4 vertColor;
 out vec4 fragColor;
 
 void main() {
-    vec3 normal = normalize(vertNormal);
-    vec3 lightDir = normalize(vec3(1.0, 0.0, 0.0));
-    float light = clamp(dot(lightDir, normal), 0.0, 1.0);
-    light = max(uniAmbientLight, light);
+#ifdef LIGHTING
+    float light = max(uniAmbientLight, directionalLight(vertNormal));
+#else
+    float light = uniAmbientLight;
+#endif
     fragColor = vertColor;
     fragColor.rgb *= light;
 }
@@ -1,5 +1,9 @@
 #version 330
 
+#if defined(INSTANCED) && defined(DRAW_ID)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
 uniform mat4 uniProjection;
 uniform mat4 uniModelTransform;
 uniform vec4 uniModelColor;
@@ -8,11 +12,39 @@ layout(location = 0) in vec4 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec4 inColor;
 
+#if defined(INSTANCED) && defined(DRAW_ID)
+// Per-draw data from the renderer, indexed by instance: four texels of model transform columns, then the color.
+uniform samplerBuffer uniDrawData;
+#elif defined(INSTANCED)
+// Per-draw data from the renderer. The columns of the model transform are in locations 3-6:
+layout(location = 3) in mat4 inModelTransform;
+layout(location = 7) in vec4 inModelColor;
+#endif
+
 out vec3 vertNormal;
 out vec4 vertColor;
 
 void main() {
-    gl_Position = uniProjection * uniModelTransform * vec4(inPosition.xyz, 1.0);
-    vertNormal = (uniModelTransform * vec4(inNormal, 0.0)).xyz;
-    vertColor = uniModelColor * inColor;
+#if defined(INSTANCED) && defined(DRAW_ID)
+    int drawData = 5 * (gl_BaseInstanceARB + gl_InstanceID);
+    mat4 modelTransform = mat4(
+        texelFetch(uniDrawData, drawData + 0),
+        texelFetch(uniDrawData, drawData + 1),
+        texelFetch(uniDrawData, drawData + 2),
+        texelFetch(uniDrawData, drawData + 3));
+    vec4 modelColor = texelFetch(uniDrawData, drawData + 4);
+#elif defined(INSTANCED)
+    mat4 modelTransform = inModelTransform;
+    vec4 modelColor = inModelColor;
+#else
+    mat4 modelTransform = uniModelTransform;
+    vec4 modelColor = uniModelColor;
+#endif
+    gl_Position = uniProjection * modelTransform * vec4(inPosition.xyz, 1.0);
+    vertNormal = (modelTransform * vec4(inNormal, 0.0)).xyz;
+#ifdef VERTEX_COLOR
+    vertColor = modelColor * inColor;
+#else
+    vertColor = modelColor;
+#endif
 }
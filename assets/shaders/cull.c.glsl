@@ -0,0 +1,82 @@
+#version 430
+
+// Culls a cull set's objects against the view frustum, picks a level of detail for each one that
+// is left, and appends a draw command and its per-draw data for it; see drawCullSet.
+
+layout(local_size_x = 64) in;
+
+struct DrawInstance {
+    mat4 transform;
+    vec4 color;
+};
+
+struct CullObject {
+    DrawInstance instance;
+    vec4 bounds;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    CullObject objects[];
+};
+
+layout(std430, binding = 1) writeonly buffer Commands {
+    DrawCommand commands[];
+};
+
+layout(std430, binding = 2) writeonly buffer Instances {
+    DrawInstance instances[];
+};
+
+layout(std430, binding = 3) buffer Counter {
+    uint drawCount;
+};
+
+uniform uint uniObjectCount;
+uniform vec4 uniFrustum[6];
+uniform vec3 uniCameraPosition;
+uniform int uniLodCount;
+uniform float uniLodDistance[4];
+// Index count, first index and base vertex of each level's mesh:
+uniform ivec3 uniLodMesh[4];
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uniObjectCount) {
+        return;
+    }
+
+    vec4 bounds = objects[i].bounds;
+    if (bounds.w <= 0.0) {
+        return;
+    }
+    for (int p = 0; p < 6; p++) {
+        if (dot(uniFrustum[p].xyz, bounds.xyz) + uniFrustum[p].w < -bounds.w) {
+            return;
+        }
+    }
+
+    float distance = length(bounds.xyz - uniCameraPosition);
+    int lod = 0;
+    while (lod < uniLodCount && distance >= uniLodDistance[lod]) {
+        lod++;
+    }
+    if (lod == uniLodCount) {
+        return;
+    }
+
+    uint slot = atomicAdd(drawCount, 1u);
+    commands[slot].count = uint(uniLodMesh[lod].x);
+    commands[slot].instanceCount = 1u;
+    commands[slot].firstIndex = uint(uniLodMesh[lod].y);
+    commands[slot].baseVertex = uniLodMesh[lod].z;
+    commands[slot].baseInstance = slot;
+    instances[slot] = objects[i].instance;
+}
@@ -0,0 +1,5 @@
+// Diffuse light from a single fixed direction.
+float directionalLight(vec3 normal) {
+    vec3 lightDir = normalize(vec3(1.0, 0.0, 0.0));
+    return clamp(dot(lightDir, normalize(normal)), 0.0, 1.0);
+}
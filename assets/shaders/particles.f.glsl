@@ -0,0 +1,12 @@
+#version 330
+
+in vec2 vertCorner;
+in vec4 vertColor;
+
+out vec4 fragColor;
+
+void main() {
+    // A round spot with a soft edge:
+    float edge = 1.0 - smoothstep(0.5, 1.0, length(vertCorner));
+    fragColor = vec4(vertColor.rgb, vertColor.a * edge);
+}
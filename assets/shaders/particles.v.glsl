@@ -0,0 +1,36 @@
+// Draws each particle as a camera-facing square, one instance per particle; see drawParticleSystem.
+#version 330
+
+uniform mat4 uniProjection;
+uniform vec3 uniCameraRight;
+uniform vec3 uniCameraUp;
+uniform float uniParticleSize;
+
+// The particle state, one per instance; see particlestep.v.glsl:
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inVelocity;
+layout(location = 2) in vec4 inColor;
+
+out vec2 vertCorner;
+out vec4 vertColor;
+
+void main() {
+    float age = inPosition.w;
+    float lifetime = inVelocity.w;
+    if (age < 0.0 || age >= lifetime) {
+        // Outside the clip volume, so nothing is drawn:
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        vertCorner = vec2(0.0);
+        vertColor = vec4(0.0);
+        return;
+    }
+
+    // A triangle strip, with the corners in the order (-1, -1), (1, -1), (-1, 1), (1, 1):
+    vertCorner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    vec3 offset = 0.5 * uniParticleSize * (vertCorner.x * uniCameraRight + vertCorner.y * uniCameraUp);
+    gl_Position = uniProjection * vec4(inPosition.xyz + offset, 1.0);
+
+    // Fade out over the particle's life:
+    vertColor = inColor;
+    vertColor.a *= 1.0 - age / lifetime;
+}
@@ -0,0 +1,98 @@
+// Advances each particle by one time step, or gives it a new life at one of the emitters once its
+// old one is over. The outputs are captured with transform feedback; see updateParticleSystem.
+#version 330
+
+// These match MAX_PARTICLE_EMITTERS and MAX_PARTICLE_ATTRACTORS:
+#define MAX_EMITTERS 4
+#define MAX_ATTRACTORS 4
+
+uniform float uniTimeStep;
+uniform uint uniSeed;
+
+uniform int uniEmitterCount;
+// Position and radius:
+uniform vec4 uniEmitterPosition[MAX_EMITTERS];
+// Velocity and spread:
+uniform vec4 uniEmitterVelocity[MAX_EMITTERS];
+uniform vec4 uniEmitterColor[MAX_EMITTERS];
+// Lifetime, and the running total of the shares up to and including this emitter, out of 1:
+uniform vec2 uniEmitterLife[MAX_EMITTERS];
+
+// Gravity and drag:
+uniform vec4 uniGravity;
+uniform int uniAttractorCount;
+// Position and strength:
+uniform vec4 uniAttractor[MAX_ATTRACTORS];
+
+// Position and age:
+layout(location = 0) in vec4 inPosition;
+// Velocity and lifetime:
+layout(location = 1) in vec4 inVelocity;
+layout(location = 2) in vec4 inColor;
+
+out vec4 outPosition;
+out vec4 outVelocity;
+out vec4 outColor;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Uniform in [0, 1):
+float random(inout uint state) {
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+vec3 randomDirection(inout uint state) {
+    float z = 2.0 * random(state) - 1.0;
+    float theta = 6.2831853 * random(state);
+    float r = sqrt(1.0 - z * z);
+    return vec3(r * cos(theta), r * sin(theta), z);
+}
+
+void main() {
+    vec3 position = inPosition.xyz;
+    float age = inPosition.w + uniTimeStep;
+    vec3 velocity = inVelocity.xyz;
+    float lifetime = inVelocity.w;
+    vec4 color = inColor;
+
+    if (age >= lifetime && uniEmitterCount > 0) {
+        uint seed = hash(uint(gl_VertexID) ^ uniSeed);
+        float pick = random(seed);
+        int e = 0;
+        while (e < uniEmitterCount - 1 && pick >= uniEmitterLife[e].y) {
+            e++;
+        }
+
+        // Spread evenly through the emitter's sphere:
+        float radius = uniEmitterPosition[e].w * pow(random(seed), 1.0 / 3.0);
+        position = uniEmitterPosition[e].xyz + radius * randomDirection(seed);
+        velocity = uniEmitterVelocity[e].xyz + uniEmitterVelocity[e].w * random(seed) * randomDirection(seed);
+        color = uniEmitterColor[e];
+        age = 0.0;
+        lifetime = uniEmitterLife[e].x * (0.75 + 0.5 * random(seed));
+    } else if (age >= 0.0) {
+        // Particles that have not been born yet have a negative age, and wait:
+        vec3 acceleration = uniGravity.xyz;
+        for (int i = 0; i < uniAttractorCount; i++) {
+            vec3 d = uniAttractor[i].xyz - position;
+            // Softened so that particles passing through the center are not flung away:
+            float distanceSquared = dot(d, d) + 0.01;
+            acceleration += uniAttractor[i].w * d * inversesqrt(distanceSquared) / distanceSquared;
+        }
+        velocity += acceleration * uniTimeStep;
+        velocity *= max(0.0, 1.0 - uniGravity.w * uniTimeStep);
+        position += velocity * uniTimeStep;
+    }
+
+    outPosition = vec4(position, age);
+    outVelocity = vec4(velocity, lifetime);
+    outColor = color;
+}
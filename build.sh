@@ -1,2 +1,16 @@
 #!/bin/sh
-cc SpinningCube/*.c -Wall -Wno-missing-braces -g -lm -lSDL2 -o screensavers
+# Set EMBED_ASSETS=1 to compile the assets into the executable instead of packing assets.pak.
+set -e
+cc tools/packassets.c -Wall -g -o packassets
+cc tools/perft.c checkersengine.c -Wall -O2 -lpthread -o perft
+cc tools/matrixtest.c matrix.c -Wall -Wno-missing-braces -O2 -lm -o matrixtest
+cc tools/searchbench.c checkerssearch.c checkersendgames.c checkersengine.c -Wall -O2 -lSDL2 -o searchbench
+cc tools/endgamegen.c checkersendgames.c checkersengine.c -Wall -O2 -lpthread -o endgamegen
+if [ -n "$EMBED_ASSETS" ]; then
+    mkdir -p generated
+    ./packassets -c assets generated/embeddedassets.c
+    cc *.c generated/embeddedassets.c -DEMBED_ASSETS -Wall -Wno-missing-braces -g -lm -lSDL2 -o screensavers
+else
+    ./packassets assets assets.pak
+    cc *.c -Wall -Wno-missing-braces -g -lm -lSDL2 -o screensavers
+fi
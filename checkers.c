@@ -1,28 +1,85 @@
-#include "Common.h"
+#include "common.h"
+#include "checkerssearch.h"
+#include <string.h>
 
 #define BOARD_SIZE 8
 #define CYLINDER_FACETS 20
+#define CYLINDER_FAR_FACETS 12
 #define CYLINDER_RADIUS 0.4f
 #define CYLINDER_HEIGHT 0.15f
-
-#define PIECE_NONE 0
-#define PIECE_RED 1
-#define PIECE_BLACK 2
+#define CYLINDER_BOUNDS 0.45f
+#define CYLINDER_FAR_DISTANCE 9.0f
+
+// Pieces 0 to 11 are red and the rest are black:
+#define PIECE_COUNT 24
+#define RED_PIECES 12
+#define NO_PIECE -1
+// Seconds for each step of a move, between moves, and between games:
+#define STEP_TIME 0.35f
+#define MOVE_PAUSE 0.4f
+#define GAME_OVER_PAUSE 3.0f
+// How high pieces go as they move, when they are taking a piece and when they are not:
+#define JUMP_HEIGHT 0.5f
+#define SLIDE_HEIGHT 0.1f
+// A game where nothing is taken or crowned for this many moves is a draw:
+#define DRAW_MOVES 50
+// The first few moves of each game are random, so that no two games are the same, and the rest
+// are searched for, which takes less time than the pause between moves:
+#define RANDOM_MOVES 4
+#define SEARCH_TIME 0.3
+#define TABLE_MEGABYTES 32
+// Made by tools/endgamegen.c, and found next to the executable. The game plays without it:
+#define ENDGAMES_NAME "checkers.egdb"
+
+// What updateCheckers hands to renderCheckers:
+typedef struct CheckersFrame
+{
+    Matrix4 projectionAndView;
+    Vector3 cameraPosition;
+    Vector3 piecePositions[PIECE_COUNT];
+    bool kings[PIECE_COUNT];
+} CheckersFrame;
 
 static struct checkersGlobals
 {
-    bool started;
+    bool simulationStarted, renderingStarted;
 
-    GLuint program;
-    GLuint uniformProjection;
-    GLuint uniformModelTransform;
-    GLuint uniformModelColor;
-    GLuint uniformAmbientLight;
+    ShaderProgram *litShader, *flatShader;
 
-    Mesh cube, plane, cylinder;
+    Mesh cube, plane, cylinder, farCylinder;
+    CullSet pieces;
+    DrawSet squares;
+    // The board, with the squares and pieces under it, and a crown under each piece:
+    Scene scene;
+    int32_t boardNode;
+    size_t pieceNodes[PIECE_COUNT], crownNodes[PIECE_COUNT];
+    // What the scene shows now:
+    Vector3 shownPositions[PIECE_COUNT];
+    bool shownKings[PIECE_COUNT];
 
     float angle;
-    char board[BOARD_SIZE][BOARD_SIZE];
+    uint32_t random;
+
+    // The game, and the pieces it is shown with:
+    CheckersBoard game;
+    int8_t squarePieces[32];
+    Vector3 piecePositions[PIECE_COUNT];
+    bool kings[PIECE_COUNT];
+    int takenCounts[2];
+    int moveCount, quietMoves;
+    bool gameOver;
+    CheckersSearch search;
+    CheckersTable table;
+    CheckersEndgames endgames;
+    bool searching;
+
+    // The move being shown, one step at a time, or NO_PIECE between moves:
+    CheckersMove move;
+    bool moveChosen;
+    int movingPiece;
+    int moveStep;
+    float stepTime;
+    float waitTime;
 } g;
 
 static bool isPlayable(int x, int y)
@@ -30,7 +87,266 @@ static bool isPlayable(int x, int y)
     return (x ^ y) & 1;
 }
 
-static void start()
+// Builds a piece with the given number of side facets, at most CYLINDER_FACETS:
+static void createCylinder(Mesh *mesh, uint16_t facets)
+{
+    // The rim as a unit circle, scaled out to the radius in one batch. The side normals point
+    // straight out from the axis:
+    float circleX[CYLINDER_FACETS], circleY[CYLINDER_FACETS], circleZ[CYLINDER_FACETS];
+    float spokeX[CYLINDER_FACETS], spokeY[CYLINDER_FACETS], spokeZ[CYLINDER_FACETS];
+    float normalX[CYLINDER_FACETS], normalY[CYLINDER_FACETS], normalZ[CYLINDER_FACETS];
+    for (uint16_t i = 0; i < facets; i++)
+    {
+        float theta = 2 * PI * ((float)i / facets);
+        circleX[i] = cosf(theta);
+        circleY[i] = 0;
+        circleZ[i] = -sinf(theta);
+    }
+    Vector3Arrays circle = { circleX, circleY, circleZ };
+    Vector3Arrays spokes = { spokeX, spokeY, spokeZ };
+    Vector3Arrays normals = { normalX, normalY, normalZ };
+    Matrix4 rim = matrixScaleF(CYLINDER_RADIUS, 1, CYLINDER_RADIUS);
+    matrixTransformPoints(&rim, circle, spokes, facets);
+    matrixTransformNormals(&rim, circle, normals, facets);
+
+    BasicVertex vertices[3 * CYLINDER_FACETS];
+    uint16_t indices[9 * CYLINDER_FACETS];
+    for (uint16_t i = 0; i < facets; i++)
+    {
+        uint16_t v = 3 * i;
+        int tri = 9 * i;
+
+        Vector3 spoke = { spokeX[i], spokeY[i], spokeZ[i] };
+        Vector3 normal = { normalX[i], normalY[i], normalZ[i] };
+        BasicVertex bottom = { spoke, 0, normal, { 0xFF, 0xFF, 0xFF, 0xFF } };
+        BasicVertex top = bottom;
+        top.position.y = CYLINDER_HEIGHT;
+        BasicVertex topFlat = top;
+        topFlat.normal = (Vector3){ 0, 1, 0 };
+        vertices[v + 0] = bottom;
+        vertices[v + 1] = top;
+        vertices[v + 2] = topFlat;
+
+        // Side triangles:
+        uint16_t end = 3 * facets;
+        indices[tri + 0] = (v) % end;
+        indices[tri + 1] = (v + 1) % end;
+        indices[tri + 2] = (v + 4) % end;
+        indices[tri + 3] = (v) % end;
+        indices[tri + 4] = (v + 4) % end;
+        indices[tri + 5] = (v + 3) % end;
+
+        // Top triangles:
+        indices[tri + 6] = 2;
+        indices[tri + 7] = (v + 5) % end;
+        indices[tri + 8] = v + 2;
+    }
+
+    createMesh(mesh);
+    setMeshData(mesh, 3 * facets, vertices, 9 * facets, indices);
+}
+
+//=============================================================================================
+// Games
+//=============================================================================================
+
+static uint32_t nextRandom()
+{
+    g.random ^= g.random << 13;
+    g.random ^= g.random >> 17;
+    g.random ^= g.random << 5;
+    return g.random;
+}
+
+static Vector3 squarePosition(int square)
+{
+    int x, y;
+    getCheckersSquare(square, &x, &y);
+    return (Vector3){ x - BOARD_SIZE / 2 + 0.5f, 0, y - BOARD_SIZE / 2 + 0.5f };
+}
+
+// Taken pieces are lined up beside the board, red's on one side and black's on the other:
+static Vector3 takenPosition(int side, int index)
+{
+    float x = 5.0f + index / 6;
+    float z = -2.5f + index % 6;
+    return (side == CHECKERS_RED) ? (Vector3){ -x, 0, z } : (Vector3){ x, 0, -z };
+}
+
+static void startGame()
+{
+    startCheckersBoard(&g.game);
+    memset(g.squarePieces, NO_PIECE, sizeof(g.squarePieces));
+    for (int i = 0; i < PIECE_COUNT; i++)
+    {
+        // Red starts on the first twelve squares, and black on the last twelve:
+        int square = (i < RED_PIECES) ? i : 32 - PIECE_COUNT + i;
+        g.squarePieces[square] = (int8_t)i;
+        g.piecePositions[i] = squarePosition(square);
+        g.kings[i] = false;
+    }
+    g.takenCounts[CHECKERS_RED] = 0;
+    g.takenCounts[CHECKERS_BLACK] = 0;
+    g.moveCount = 0;
+    g.quietMoves = 0;
+    g.gameOver = false;
+    g.moveChosen = false;
+    g.movingPiece = NO_PIECE;
+    g.waitTime = MOVE_PAUSE;
+}
+
+// The search runs on its own thread, and this only ever looks to see if it is done, so however
+// long it takes, the frames keep coming:
+static void chooseMove()
+{
+    if (g.searching)
+    {
+        g.moveChosen = takeCheckersMove(&g.search, &g.move);
+        g.searching = !g.moveChosen;
+        return;
+    }
+
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = generateCheckersMoves(&g.game, moves);
+    if (count == 0 || g.quietMoves >= DRAW_MOVES)
+    {
+        g.gameOver = true;
+        g.waitTime = GAME_OVER_PAUSE;
+    }
+    else if (g.moveCount < RANDOM_MOVES)
+    {
+        g.move = moves[nextRandom() % count];
+        g.moveChosen = true;
+    }
+    else
+    {
+        requestCheckersMove(&g.search, &g.game);
+        g.searching = true;
+    }
+}
+
+static void startMove()
+{
+    g.movingPiece = g.squarePieces[g.move.path[0]];
+    g.moveChosen = false;
+    g.moveStep = 0;
+    g.stepTime = 0;
+}
+
+static void finishMove()
+{
+    int from = g.move.path[0];
+    int to = g.move.path[g.move.length - 1];
+    bool wasKing = (g.game.kings >> from) & 1;
+    makeCheckersMove(&g.game, &g.move);
+    bool isKing = (g.game.kings >> to) & 1;
+
+    g.squarePieces[from] = NO_PIECE;
+    g.squarePieces[to] = (int8_t)g.movingPiece;
+    g.kings[g.movingPiece] = isKing;
+    g.moveCount++;
+    g.quietMoves = (g.move.captures || isKing != wasKing) ? 0 : g.quietMoves + 1;
+    g.movingPiece = NO_PIECE;
+    g.waitTime = MOVE_PAUSE;
+}
+
+// Moves the pieces along at display speed, and starts the next move or game when it is time:
+static void updateGame(float timeStep)
+{
+    // The next move is chosen during the pause after the last one:
+    if (g.movingPiece == NO_PIECE)
+    {
+        g.waitTime -= timeStep;
+        if (g.gameOver)
+        {
+            if (g.waitTime <= 0)
+            {
+                startGame();
+            }
+            return;
+        }
+
+        if (!g.moveChosen)
+        {
+            chooseMove();
+        }
+        if (g.moveChosen && g.waitTime <= 0)
+        {
+            startMove();
+        }
+        return;
+    }
+
+    int from = g.move.path[g.moveStep];
+    int to = g.move.path[g.moveStep + 1];
+    g.stepTime += timeStep;
+    float t = fminf(g.stepTime / STEP_TIME, 1);
+    float height = (g.move.captures ? JUMP_HEIGHT : SLIDE_HEIGHT) * sinf(PI * t);
+    Vector3 a = squarePosition(from);
+    Vector3 b = squarePosition(to);
+    g.piecePositions[g.movingPiece] = (Vector3){ a.x + t * (b.x - a.x), height, a.z + t * (b.z - a.z) };
+    if (t < 1)
+    {
+        return;
+    }
+
+    // The piece that was jumped over leaves the board as soon as the jump lands:
+    if (g.move.captures)
+    {
+        int fromX, fromY, toX, toY;
+        getCheckersSquare(from, &fromX, &fromY);
+        getCheckersSquare(to, &toX, &toY);
+        int over = findCheckersSquare((fromX + toX) / 2, (fromY + toY) / 2);
+        int taken = g.squarePieces[over];
+        if (taken != NO_PIECE)
+        {
+            int side = (taken < RED_PIECES) ? CHECKERS_RED : CHECKERS_BLACK;
+            g.piecePositions[taken] = takenPosition(side, g.takenCounts[side]++);
+            g.squarePieces[over] = NO_PIECE;
+        }
+    }
+
+    g.moveStep++;
+    g.stepTime = 0;
+    if (g.moveStep == g.move.length - 1)
+    {
+        finishMove();
+    }
+}
+
+static void startSimulation()
+{
+    g.angle = 0;
+    g.random = 0x2545F491;
+    check(createCheckersTable(&g.table, TABLE_MEGABYTES), "cannot make the checkers transposition table");
+    check(startCheckersSearch(&g.search, SEARCH_TIME, &g.table), "cannot start the checkers search");
+    char *baseDirectory = SDL_GetBasePath();
+    char endgamesPath[1024];
+    snprintf(endgamesPath, sizeof(endgamesPath), "%s" ENDGAMES_NAME, baseDirectory ? baseDirectory : "");
+    SDL_free(baseDirectory);
+    if (openCheckersEndgames(&g.endgames, endgamesPath))
+    {
+        g.search.endgames = &g.endgames;
+    }
+    // The search thread and its helpers leave one core for rendering. The search works with any
+    // number of helpers, so it is fine if some of them cannot be started:
+    int helperCount = SDL_GetCPUCount() - 2;
+    if (!startCheckersHelpers(&g.search, helperCount))
+    {
+        fprintf(stderr, "warning: started %d of %d checkers search helpers\n", g.search.helperCount, helperCount);
+    }
+    startGame();
+}
+
+static void stopSimulation()
+{
+    stopCheckersSearch(&g.search);
+    stopCheckersHelpers(&g.search);
+    destroyCheckersTable(&g.table);
+    closeCheckersEndgames(&g.endgames);
+}
+
+static void startRendering()
 {
     //=============================================================================================
     // Data
@@ -71,151 +387,152 @@ static void start()
         0, 1, 3, 0, 3, 2,
     };
 
-    BasicVertex cylinderVertices[3 * CYLINDER_FACETS];
-    uint16_t cylinderIndices[9 * CYLINDER_FACETS];
-    for (uint16_t i = 0; i < CYLINDER_FACETS; i++)
-    {
-        uint16_t v = 3 * i;
-        int tri = 9 * i;
-
-        float theta = 2 * PI * ((float)i / CYLINDER_FACETS);
-        Matrix4 rotateY = matrixRotationY(theta);
-        Vector3 spoke = matrixTransformPoint(rotateY, (Vector3) { CYLINDER_RADIUS, 0, 0 });
-        Vector3 normal = matrixTransformPoint(rotateY, (Vector3) { 0, 0, 1 });
-        BasicVertex bottom = { spoke, 0, normal, { 0xFF, 0xFF, 0xFF, 0xFF } };
-        BasicVertex top = bottom;
-        top.position.y = CYLINDER_HEIGHT;
-        BasicVertex topFlat = top;
-        topFlat.normal = (Vector3){ 0, 1, 0 };
-        cylinderVertices[v + 0] = bottom;
-        cylinderVertices[v + 1] = top;
-        cylinderVertices[v + 2] = topFlat;
-
-        // Side triangles:
-        uint16_t end = COUNTOF(cylinderVertices);
-        cylinderIndices[tri + 0] = (v) % end;
-        cylinderIndices[tri + 1] = (v + 1) % end;
-        cylinderIndices[tri + 2] = (v + 4) % end;
-        cylinderIndices[tri + 3] = (v) % end;
-        cylinderIndices[tri + 4] = (v + 4) % end;
-        cylinderIndices[tri + 5] = (v + 3) % end;
-
-        // Top triangles:
-        cylinderIndices[tri + 6] = 2;
-        cylinderIndices[tri + 7] = (v + 5) % end;
-        cylinderIndices[tri + 8] = v + 2;
-    }
-
-    char* vertexShaderSource = readTextFile("assets/shaders/cube.v.glsl");
-    char* fragmentShaderSource = readTextFile("assets/shaders/cube.f.glsl");
-
     //=============================================================================================
     // GL resources
     //=============================================================================================
 
-    g.program = compileShaderProgram(vertexShaderSource, fragmentShaderSource);
-    g.uniformProjection = glGetUniformLocation(g.program, "uniProjection");
-    g.uniformModelTransform = glGetUniformLocation(g.program, "uniModelTransform");
-    g.uniformModelColor = glGetUniformLocation(g.program, "uniModelColor");
-    g.uniformAmbientLight = glGetUniformLocation(g.program, "uniAmbientLight");
+    // The pieces are plain white and the board squares face away from the light, so neither needs
+    // vertex colors and the squares can skip lighting. Everything is drawn from draw sets:
+    g.litShader = requestBasicShader("LIGHTING INSTANCED");
+    g.flatShader = requestBasicShader("INSTANCED");
 
     createMesh(&g.cube);
     setMeshData(&g.cube, COUNTOF(cubeVertices), cubeVertices, COUNTOF(cubeIndices), cubeIndices);
     createMesh(&g.plane);
     setMeshData(&g.plane, COUNTOF(planeVertices), planeVertices, COUNTOF(planeIndices), planeIndices);
-    createMesh(&g.cylinder);
-    setMeshData(&g.cylinder, COUNTOF(cylinderVertices), cylinderVertices, COUNTOF(cylinderIndices), cylinderIndices);
+    createCylinder(&g.cylinder, CYLINDER_FACETS);
+    createCylinder(&g.farCylinder, CYLINDER_FAR_FACETS);
 
     //=============================================================================================
-    // Program state
+    // GL state
     //=============================================================================================
 
-    g.angle = 0;
+    glDisable(GL_STENCIL_TEST);
 
     //=============================================================================================
-    // GL state
+    // Draws
     //=============================================================================================
 
-    glDisable(GL_STENCIL_TEST);
+    // The draws are built once and stay on the GPU, and only the pieces that move are sent again.
+    // The pieces are also culled, and the ones on the far side of the board use fewer facets:
+    Mesh pieceLods[] = { g.cylinder, g.farCylinder };
+    float pieceLodDistances[] = { CYLINDER_FAR_DISTANCE, 1000.0f };
+    createCullSet(&g.pieces, 2 * PIECE_COUNT, pieceLods, pieceLodDistances, COUNTOF(pieceLods));
+    createDrawSet(&g.squares, BOARD_SIZE * BOARD_SIZE);
+
+    // The pieces and squares are placed through the scene, which only passes on their transforms
+    // again if something moves:
+    createScene(&g.scene, 1 + 2 * PIECE_COUNT + BOARD_SIZE * BOARD_SIZE);
+    Vector3 one = { 1, 1, 1 };
+    g.boardNode = (int32_t)addSceneNode(&g.scene, -1, (Vector3){ 0, 0, 0 }, quaternionIdentity(), one);
+
+    // Every piece starts at the middle of the board until the first frame says where it goes. A
+    // crown is another piece on top, which is scaled away until it is needed:
+    Color redPiece = { 1, 0, 0, 1 };
+    Color blackPiece = { 0, 0, 0, 1 };
+    for (int i = 0; i < PIECE_COUNT; i++)
+    {
+        g.pieceNodes[i] = addSceneNode(&g.scene, g.boardNode, (Vector3){ 0, 0, 0 }, quaternionIdentity(), one);
+        size_t index = addToCullSet(&g.pieces, &g.scene.worlds[g.pieceNodes[i]], (i < RED_PIECES) ? redPiece : blackPiece, CYLINDER_BOUNDS);
+        attachSceneCullObject(&g.scene, g.pieceNodes[i], &g.pieces, index);
+    }
+    for (int i = 0; i < PIECE_COUNT; i++)
+    {
+        g.crownNodes[i] = addSceneNode(&g.scene, (int32_t)g.pieceNodes[i], (Vector3){ 0, CYLINDER_HEIGHT, 0 }, quaternionIdentity(), (Vector3){ 0, 0, 0 });
+        size_t index = addToCullSet(&g.pieces, &g.scene.worlds[g.crownNodes[i]], (i < RED_PIECES) ? redPiece : blackPiece, CYLINDER_BOUNDS);
+        attachSceneCullObject(&g.scene, g.crownNodes[i], &g.pieces, index);
+    }
 
-    for (int by = 0; by < BOARD_SIZE; by++)
+    for (int gy = 0; gy < BOARD_SIZE; gy++)
     {
-        for (int bx = 0; bx < BOARD_SIZE; bx++)
+        for (int gx = 0; gx < BOARD_SIZE; gx++)
         {
-            if (isPlayable(bx, by))
-            {
-                if (by < 3)
-                {
-                    g.board[bx][by] = PIECE_RED;
-                }
-                else if (by >= 5)
-                {
-                    g.board[bx][by] = PIECE_BLACK;
-                }
-            }
+            float w = 0.3f;
+            Color red = { 1, w, w, 1 };
+            Color black = { w, w, w, 1 };
+
+            Vector3 position = { gx - BOARD_SIZE / 2 + 0.5f, 0, gy - BOARD_SIZE / 2 + 0.5f };
+            size_t node = addSceneNode(&g.scene, g.boardNode, position, quaternionIdentity(), (Vector3){ 0.5f, 0.5f, 0.5f });
+            size_t index = addToDrawSet(&g.squares, &g.plane, &g.scene.worlds[node], isPlayable(gx, gy) ? black : red);
+            attachSceneDraw(&g.scene, node, &g.squares, index);
         }
     }
 }
 
-void screensaverCheckers()
+void updateCheckers(FramePacket *packet)
 {
-    if (!g.started)
+    if (!g.simulationStarted)
     {
-        start();
-        g.started = true;
+        startSimulation();
+        g.simulationStarted = true;
     }
 
     g.angle += FRAME_TIME * 0.02f;
     g.angle = fmodf(g.angle, 2 * PI);
+    updateGame(FRAME_TIME);
 
-    glClearColor(0.7f, 0.7f, 0.7f, 0.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glUniform4f(g.uniformModelColor, 1, 1, 1, 1);
-    glUniform1f(g.uniformAmbientLight, 0.5f);
+    CheckersFrame *frame = allocatePacketData(packet, sizeof(*frame));
+    packet->data = frame;
+    memcpy(frame->piecePositions, g.piecePositions, sizeof(frame->piecePositions));
+    memcpy(frame->kings, g.kings, sizeof(frame->kings));
 
     // Set up projection:
-    glUseProgram(g.program);
-    Matrix4 projectionAndView = matrixRotationY(g.angle);
-    matrixConcat(&projectionAndView, matrixRotationX(45 * TO_RADIANS));
-    matrixConcat(&projectionAndView, matrixTranslationF(0, -1, -8));
-    matrixConcat(&projectionAndView, matrixPerspective(0.1f, 90.0f * TO_RADIANS));
-    glUniformMatrix4fv(g.uniformProjection, 1, GL_TRUE, projectionAndView.e);
+    Matrix4 view = matrixOrbit(g.angle, 45 * TO_RADIANS, (Vector3){ 0, -1, -8 });
+    frame->projectionAndView = matrixViewPerspective(&view, 0.1f, 90.0f * TO_RADIANS);
+    frame->cameraPosition = matrixViewPosition(&view);
+}
 
-    Color redPiece = { 1, 0, 0, 1 };
-    Color blackPiece = { 0, 0, 0, 1 };
+// Ends the search threads, which may be in the middle of a search.
+void stopCheckers()
+{
+    if (g.simulationStarted)
+    {
+        stopSimulation();
+        g.simulationStarted = false;
+    }
+}
 
-    for (int by = 0; by < BOARD_SIZE; by++)
+void renderCheckers(FramePacket *packet)
+{
+    if (!g.renderingStarted)
     {
-        for (int bx = 0; bx < BOARD_SIZE; bx++)
-        {
-            char piece = g.board[bx][by];
-            if (piece != PIECE_NONE)
-            {
-                Matrix4 transform = matrixTranslationF((float)bx - 3.5f, 0, (float)by - 3.5f);
-                glUniformMatrix4fv(g.uniformModelTransform, 1, GL_TRUE, transform.e);
-                glUniform4fv(g.uniformModelColor, 1, piece == PIECE_RED ? &redPiece.r : &blackPiece.r);
-                glBindVertexArray(g.cylinder.vao);
-                glDrawElements(GL_TRIANGLES, (GLsizei)g.cylinder.primitiveCount, GL_UNSIGNED_SHORT, 0);
-            }
-        }
+        startRendering();
+        g.renderingStarted = true;
     }
 
-    // Draw board:
-    glBindVertexArray(g.plane.vao);
-    for (int gy = 0; gy < BOARD_SIZE; gy++)
+    CheckersFrame *frame = packet->data;
+
+    // Only the pieces that moved are passed on to the scene:
+    for (int i = 0; i < PIECE_COUNT; i++)
     {
-        for (int gx = 0; gx < BOARD_SIZE; gx++)
+        Vector3 p = frame->piecePositions[i];
+        Vector3 shown = g.shownPositions[i];
+        if (p.x != shown.x || p.y != shown.y || p.z != shown.z)
         {
-            float w = 0.3f;
-            float red[] = { 1, w, w, 1 };
-            float black[] = { w, w, w, 1 };
-
-            Matrix4 modelTransform = matrixScaleUniform(0.5f);
-            matrixConcat(&modelTransform, matrixTranslationF(gx - BOARD_SIZE / 2 + 0.5f, 0, gy - BOARD_SIZE / 2 + 0.5f));
-            glUniformMatrix4fv(g.uniformModelTransform, 1, GL_TRUE, modelTransform.e);
-            glUniform4fv(g.uniformModelColor, 1, isPlayable(gx, gy) ? black : red);
-            glDrawElements(GL_TRIANGLES, (GLsizei)g.plane.primitiveCount, GL_UNSIGNED_SHORT, 0);
+            setSceneNodePosition(&g.scene, g.pieceNodes[i], p);
+            g.shownPositions[i] = p;
+        }
+        if (frame->kings[i] != g.shownKings[i])
+        {
+            float scale = frame->kings[i] ? 1.0f : 0.0f;
+            setSceneNode(&g.scene, g.crownNodes[i], (Vector3){ 0, CYLINDER_HEIGHT, 0 }, quaternionIdentity(), (Vector3){ scale, scale, scale });
+            g.shownKings[i] = frame->kings[i];
         }
     }
+    updateScene(&g.scene);
+
+    glClearColor(0.7f, 0.7f, 0.7f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    useShaderProgram(g.litShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, &frame->projectionAndView);
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 0.5f);
+
+    drawCullSet(&g.pieces, &frame->projectionAndView, frame->cameraPosition);
+
+    // Draw board:
+    useShaderProgram(g.flatShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, &frame->projectionAndView);
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 0.5f);
+    drawDrawSet(&g.squares);
 }
@@ -0,0 +1,342 @@
+#include "checkersendgames.h"
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Where each kind of piece can be, by material index. Men are never on the row where they would
+// be crowned, so black men are on squares 4 to 31 and red men on squares 0 to 27:
+static const int FirstSquares[4] = { 4, 0, 0, 0 };
+static const int SquareCounts[4] = { 28, 32, 28, 32 };
+
+// Binomial coefficients, n choose k:
+static const uint32_t Choose[33][CHECKERS_ENDGAME_MAX_PIECES + 1] =
+{
+    { 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+    { 1, 2, 1, 0, 0, 0, 0, 0, 0 },
+    { 1, 3, 3, 1, 0, 0, 0, 0, 0 },
+    { 1, 4, 6, 4, 1, 0, 0, 0, 0 },
+    { 1, 5, 10, 10, 5, 1, 0, 0, 0 },
+    { 1, 6, 15, 20, 15, 6, 1, 0, 0 },
+    { 1, 7, 21, 35, 35, 21, 7, 1, 0 },
+    { 1, 8, 28, 56, 70, 56, 28, 8, 1 },
+    { 1, 9, 36, 84, 126, 126, 84, 36, 9 },
+    { 1, 10, 45, 120, 210, 252, 210, 120, 45 },
+    { 1, 11, 55, 165, 330, 462, 462, 330, 165 },
+    { 1, 12, 66, 220, 495, 792, 924, 792, 495 },
+    { 1, 13, 78, 286, 715, 1287, 1716, 1716, 1287 },
+    { 1, 14, 91, 364, 1001, 2002, 3003, 3432, 3003 },
+    { 1, 15, 105, 455, 1365, 3003, 5005, 6435, 6435 },
+    { 1, 16, 120, 560, 1820, 4368, 8008, 11440, 12870 },
+    { 1, 17, 136, 680, 2380, 6188, 12376, 19448, 24310 },
+    { 1, 18, 153, 816, 3060, 8568, 18564, 31824, 43758 },
+    { 1, 19, 171, 969, 3876, 11628, 27132, 50388, 75582 },
+    { 1, 20, 190, 1140, 4845, 15504, 38760, 77520, 125970 },
+    { 1, 21, 210, 1330, 5985, 20349, 54264, 116280, 203490 },
+    { 1, 22, 231, 1540, 7315, 26334, 74613, 170544, 319770 },
+    { 1, 23, 253, 1771, 8855, 33649, 100947, 245157, 490314 },
+    { 1, 24, 276, 2024, 10626, 42504, 134596, 346104, 735471 },
+    { 1, 25, 300, 2300, 12650, 53130, 177100, 480700, 1081575 },
+    { 1, 26, 325, 2600, 14950, 65780, 230230, 657800, 1562275 },
+    { 1, 27, 351, 2925, 17550, 80730, 296010, 888030, 2220075 },
+    { 1, 28, 378, 3276, 20475, 98280, 376740, 1184040, 3108105 },
+    { 1, 29, 406, 3654, 23751, 118755, 475020, 1560780, 4292145 },
+    { 1, 30, 435, 4060, 27405, 142506, 593775, 2035800, 5852925 },
+    { 1, 31, 465, 4495, 31465, 169911, 736281, 2629575, 7888725 },
+    { 1, 32, 496, 4960, 35960, 201376, 906192, 3365856, 10518300 },
+};
+
+static uint32_t reverseBits(uint32_t bits)
+{
+    bits = ((bits >> 1) & 0x55555555u) | ((bits & 0x55555555u) << 1);
+    bits = ((bits >> 2) & 0x33333333u) | ((bits & 0x33333333u) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0Fu) | ((bits & 0x0F0F0F0Fu) << 4);
+    bits = ((bits >> 8) & 0x00FF00FFu) | ((bits & 0x00FF00FFu) << 8);
+    return (bits >> 16) | (bits << 16);
+}
+
+// The squares of each kind of piece, by material index:
+static void getKinds(const CheckersBoard *board, uint32_t *kinds)
+{
+    kinds[CHECKERS_BLACK_MEN] = board->pieces[CHECKERS_BLACK] & ~board->kings;
+    kinds[CHECKERS_BLACK_KINGS] = board->pieces[CHECKERS_BLACK] & board->kings;
+    kinds[CHECKERS_RED_MEN] = board->pieces[CHECKERS_RED] & ~board->kings;
+    kinds[CHECKERS_RED_KINGS] = board->pieces[CHECKERS_RED] & board->kings;
+}
+
+//=============================================================================================
+// Positions
+//=============================================================================================
+
+// Turns the board around and swaps the colors, which gives the same position for the other side.
+// Square n goes to square 31 - n.
+void turnCheckersBoard(CheckersBoard *board)
+{
+    uint32_t black = board->pieces[CHECKERS_BLACK];
+    board->pieces[CHECKERS_BLACK] = reverseBits(board->pieces[CHECKERS_RED]);
+    board->pieces[CHECKERS_RED] = reverseBits(black);
+    board->kings = reverseBits(board->kings);
+    board->turn ^= 1;
+}
+
+// Fills in four counts, in the order of the CHECKERS_BLACK_MEN to CHECKERS_RED_KINGS indexes.
+void getCheckersMaterial(const CheckersBoard *board, int *material)
+{
+    uint32_t kinds[4];
+    getKinds(board, kinds);
+    for (int kind = 0; kind < 4; kind++)
+    {
+        material[kind] = countCheckersSquares(kinds[kind]);
+    }
+}
+
+uint64_t countEndgamePositions(const int *material)
+{
+    uint64_t count = 1;
+    for (int kind = 0; kind < 4; kind++)
+    {
+        count *= Choose[SquareCounts[kind]][material[kind]];
+    }
+    return count;
+}
+
+// Where a position with black to move, and with the given material, is in its slice. Each kind of
+// piece's squares are numbered as a combination, and the numbers are put together like digits.
+uint64_t getEndgameIndex(const int *material, const CheckersBoard *board)
+{
+    uint32_t kinds[4];
+    getKinds(board, kinds);
+    uint64_t index = 0;
+    for (int kind = 0; kind < 4; kind++)
+    {
+        uint32_t squares = kinds[kind] >> FirstSquares[kind];
+        uint32_t rank = 0;
+        for (int i = 1; squares; i++)
+        {
+            rank += Choose[lowestCheckersSquare(squares)][i];
+            squares &= squares - 1;
+        }
+        index = index * Choose[SquareCounts[kind]][material[kind]] + rank;
+    }
+    return index;
+}
+
+// The opposite of getEndgameIndex. Returns false if the index puts two pieces on one square.
+bool setEndgamePosition(const int *material, uint64_t index, CheckersBoard *board)
+{
+    memset(board, 0, sizeof(*board));
+    board->turn = CHECKERS_BLACK;
+    uint32_t occupied = 0;
+    for (int kind = 3; kind >= 0; kind--)
+    {
+        uint32_t combinations = Choose[SquareCounts[kind]][material[kind]];
+        uint32_t rank = (uint32_t)(index % combinations);
+        index /= combinations;
+
+        // Each piece is on the highest square whose combinations do not pass the rank:
+        uint32_t squares = 0;
+        for (int i = material[kind]; i > 0; i--)
+        {
+            int square = i - 1;
+            while (Choose[square + 1][i] <= rank)
+            {
+                square++;
+            }
+            rank -= Choose[square][i];
+            squares |= 1u << square;
+        }
+
+        squares <<= FirstSquares[kind];
+        if (squares & occupied)
+        {
+            return false;
+        }
+        occupied |= squares;
+        board->pieces[(kind < CHECKERS_RED_MEN) ? CHECKERS_BLACK : CHECKERS_RED] |= squares;
+        board->kings |= (kind == CHECKERS_BLACK_KINGS || kind == CHECKERS_RED_KINGS) ? squares : 0;
+    }
+    return true;
+}
+
+int getEndgameValue(const uint8_t *slice, uint64_t index)
+{
+    return (slice[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+// Returns CHECKERS_ENDGAME_MISSING for positions with too many pieces, or that are otherwise not
+// in the databases. This is cheap enough to call for every position in a search.
+int probeCheckersEndgames(const CheckersEndgames *endgames, const CheckersBoard *board)
+{
+    if (countCheckersSquares(board->pieces[CHECKERS_BLACK] | board->pieces[CHECKERS_RED]) > endgames->maxPieces)
+    {
+        return CHECKERS_ENDGAME_MISSING;
+    }
+    CheckersBoard turned;
+    if (board->turn == CHECKERS_RED)
+    {
+        turned = *board;
+        turnCheckersBoard(&turned);
+        board = &turned;
+    }
+
+    int material[4];
+    getCheckersMaterial(board, material);
+    const uint8_t *slice = endgames->slices[material[0]][material[1]][material[2]][material[3]];
+    if (!slice)
+    {
+        return CHECKERS_ENDGAME_MISSING;
+    }
+    return getEndgameValue(slice, getEndgameIndex(material, board));
+}
+
+//=============================================================================================
+// Files
+//=============================================================================================
+
+#ifdef _WIN32
+
+static const void *mapFile(const char *path, size_t *size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    const void *view = NULL;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            *size = (size_t)fileSize.QuadPart;
+            // The view keeps the mapping alive:
+            CloseHandle(mapping);
+        }
+    }
+
+    CloseHandle(file);
+    return view;
+}
+
+static void unmapFile(const void *view, size_t size)
+{
+    (void)size;
+    UnmapViewOfFile(view);
+}
+
+#else
+
+static const void *mapFile(const char *path, size_t *size)
+{
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return NULL;
+    }
+
+    const void *view = NULL;
+    struct stat info;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (p != MAP_FAILED)
+        {
+            view = p;
+            *size = info.st_size;
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed:
+    close(file);
+    return view;
+}
+
+static void unmapFile(const void *view, size_t size)
+{
+    munmap((void *)view, size);
+}
+
+#endif
+
+// Checks every slice once here so that probes can trust them:
+static bool useFile(CheckersEndgames *endgames, const uint8_t *file, size_t size)
+{
+    if (size < sizeof(CheckersEndgameHeader))
+    {
+        return false;
+    }
+    const CheckersEndgameHeader *header = (const CheckersEndgameHeader *)file;
+    if (header->magic != CHECKERS_ENDGAME_MAGIC ||
+        header->version != CHECKERS_ENDGAME_VERSION ||
+        header->maxPieces > CHECKERS_ENDGAME_MAX_PIECES ||
+        header->sliceCount > (size - sizeof(*header)) / sizeof(CheckersEndgameSlice))
+    {
+        return false;
+    }
+
+    const CheckersEndgameSlice *slices = (const CheckersEndgameSlice *)(header + 1);
+    for (uint32_t i = 0; i < header->sliceCount; i++)
+    {
+        const CheckersEndgameSlice *s = &slices[i];
+        int material[4];
+        int pieces = 0;
+        for (int kind = 0; kind < 4; kind++)
+        {
+            material[kind] = s->material[kind];
+            pieces += material[kind];
+        }
+        if (pieces > (int)header->maxPieces ||
+            s->positionCount != countEndgamePositions(material) ||
+            s->dataOffset % CHECKERS_ENDGAME_ALIGNMENT != 0 ||
+            s->dataOffset > size ||
+            (s->positionCount + 3) / 4 > size - s->dataOffset)
+        {
+            return false;
+        }
+        endgames->slices[material[0]][material[1]][material[2]][material[3]] = file + s->dataOffset;
+    }
+    endgames->maxPieces = (int)header->maxPieces;
+    return true;
+}
+
+// Maps the databases that tools/endgamegen.c made. Returns false if the file cannot be read or
+// is not valid, and then probes find nothing.
+bool openCheckersEndgames(CheckersEndgames *endgames, const char *path)
+{
+    memset(endgames, 0, sizeof(*endgames));
+    size_t size = 0;
+    const uint8_t *file = mapFile(path, &size);
+    if (!file)
+    {
+        return false;
+    }
+    if (!useFile(endgames, file, size))
+    {
+        unmapFile(file, size);
+        memset(endgames, 0, sizeof(*endgames));
+        return false;
+    }
+    endgames->file = file;
+    endgames->fileSize = size;
+    return true;
+}
+
+void closeCheckersEndgames(CheckersEndgames *endgames)
+{
+    if (endgames->file)
+    {
+        unmapFile(endgames->file, endgames->fileSize);
+    }
+    memset(endgames, 0, sizeof(*endgames));
+}
@@ -0,0 +1,80 @@
+// Endgame databases for checkersengine.c: whether each position with only a few pieces left is a
+// win, a loss or a draw for the side to move, with perfect play. tools/endgamegen.c makes the
+// file, and the search maps it and reads values straight from the mapping.
+//
+// The file starts with a CheckersEndgameHeader, followed by one CheckersEndgameSlice for each mix
+// of pieces: how many men and kings each side has. Each slice's values start on a
+// CHECKERS_ENDGAME_ALIGNMENT boundary and take two bits each, four to a byte, lowest bits first.
+// Only positions with black to move are stored; one with red to move is looked up as the same
+// position turned around, with the colors swapped. A position's place in its slice comes from
+// where each kind of piece is, numbered as combinations of the squares that kind can be on; see
+// getEndgameIndex. Some places are for positions with two pieces on one square, which cannot
+// happen and are never looked up. All offsets are from the start of the file and all fields are
+// little-endian.
+
+#include <stddef.h>
+#include "checkersengine.h"
+
+#define CHECKERS_ENDGAME_MAGIC 0x47454B43 // "CKEG"
+#define CHECKERS_ENDGAME_VERSION 1
+#define CHECKERS_ENDGAME_ALIGNMENT 64
+// The format allows up to this many pieces, though making databases that big is not practical:
+#define CHECKERS_ENDGAME_MAX_PIECES 8
+
+// Values, for the side to move:
+#define CHECKERS_DRAW 0
+#define CHECKERS_WIN 1
+#define CHECKERS_LOSS 2
+// probeCheckersEndgames returns this for positions that are not in the databases:
+#define CHECKERS_ENDGAME_MISSING -1
+
+// The order of the counts in a material:
+#define CHECKERS_BLACK_MEN 0
+#define CHECKERS_BLACK_KINGS 1
+#define CHECKERS_RED_MEN 2
+#define CHECKERS_RED_KINGS 3
+
+typedef struct CheckersEndgameHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t maxPieces;
+    uint32_t sliceCount;
+} CheckersEndgameHeader;
+
+typedef struct CheckersEndgameSlice
+{
+    // Black men, black kings, red men and red kings:
+    uint8_t material[4];
+    uint32_t reserved;
+    uint64_t dataOffset;
+    uint64_t positionCount;
+} CheckersEndgameSlice;
+
+typedef struct CheckersEndgames
+{
+    int maxPieces;
+    // Each slice's values, by material, or NULL for slices that are not in the databases:
+    const uint8_t *slices[CHECKERS_ENDGAME_MAX_PIECES + 1][CHECKERS_ENDGAME_MAX_PIECES + 1][CHECKERS_ENDGAME_MAX_PIECES + 1][CHECKERS_ENDGAME_MAX_PIECES + 1];
+    // The mapped file, if the slices are in one:
+    const void *file;
+    size_t fileSize;
+} CheckersEndgames;
+
+void turnCheckersBoard(CheckersBoard *board);
+
+void getCheckersMaterial(const CheckersBoard *board, int *material);
+
+uint64_t countEndgamePositions(const int *material);
+
+uint64_t getEndgameIndex(const int *material, const CheckersBoard *board);
+
+bool setEndgamePosition(const int *material, uint64_t index, CheckersBoard *board);
+
+int getEndgameValue(const uint8_t *slice, uint64_t index);
+
+int probeCheckersEndgames(const CheckersEndgames *endgames, const CheckersBoard *board);
+
+bool openCheckersEndgames(CheckersEndgames *endgames, const char *path);
+
+void closeCheckersEndgames(CheckersEndgames *endgames);
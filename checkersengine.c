@@ -0,0 +1,211 @@
+#include "checkersengine.h"
+
+#define EVEN_ROWS 0x0F0F0F0Fu
+#define ODD_ROWS 0xF0F0F0F0u
+// Even-row squares with a square up and to the right, and odd-row squares with one to the left:
+#define NOT_RIGHT_EDGE 0x07070707u
+#define NOT_LEFT_EDGE 0xE0E0E0E0u
+// Where each side's men are crowned:
+#define BLACK_KING_ROW 0x0000000Fu
+#define RED_KING_ROW 0xF0000000u
+
+// Directions, numbered so that the opposite of d is d ^ 3. Red men move in the first two and
+// black men in the last two:
+#define UP_LEFT 0
+#define UP_RIGHT 1
+#define DOWN_LEFT 2
+#define DOWN_RIGHT 3
+
+// The places a capture has reached, for addJumps:
+typedef struct JumpSearch
+{
+    CheckersMove move;
+    CheckersMove *moves;
+    int count;
+    int side;
+    uint32_t other, empty;
+} JumpSearch;
+
+//=============================================================================================
+// Moves
+//=============================================================================================
+
+// Moves every square in `bits` one step diagonally. Squares that would go off the board are lost.
+static uint32_t step(uint32_t bits, int direction)
+{
+    switch (direction)
+    {
+    case UP_LEFT: return ((bits & EVEN_ROWS) << 4) | ((bits & NOT_LEFT_EDGE) << 3);
+    case UP_RIGHT: return ((bits & NOT_RIGHT_EDGE) << 5) | ((bits & ODD_ROWS) << 4);
+    case DOWN_LEFT: return ((bits & EVEN_ROWS) >> 4) | ((bits & NOT_LEFT_EDGE) >> 5);
+    default: return ((bits & NOT_RIGHT_EDGE) >> 3) | ((bits & ODD_ROWS) >> 4);
+    }
+}
+
+static bool isForward(int side, int direction)
+{
+    return (side == CHECKERS_RED) == (direction < DOWN_LEFT);
+}
+
+static void addMove(CheckersMove *moves, int *count, const CheckersMove *move)
+{
+    // Kings can take the same pieces in a different order and end up in the same place, which is
+    // the same move:
+    int last = move->length - 1;
+    for (int i = 0; i < *count; i++)
+    {
+        CheckersMove *m = &moves[i];
+        if (m->captures == move->captures && m->path[0] == move->path[0] && m->path[m->length - 1] == move->path[last])
+        {
+            return;
+        }
+    }
+    if (*count < CHECKERS_MAX_MOVES)
+    {
+        moves[(*count)++] = *move;
+    }
+}
+
+// Follows every way a capture can go on from `at`. Taken pieces stay on the board until the move
+// is over, so they cannot be jumped twice or landed on.
+static void addJumps(JumpSearch *search, uint32_t at, bool king)
+{
+    CheckersMove *move = &search->move;
+    bool extended = false;
+    for (int d = 0; d < 4; d++)
+    {
+        if (!king && !isForward(search->side, d))
+        {
+            continue;
+        }
+        uint32_t over = step(at, d) & search->other & ~move->captures;
+        uint32_t land = step(over, d) & search->empty;
+        if (!land)
+        {
+            continue;
+        }
+
+        extended = true;
+        move->path[move->length++] = (uint8_t)lowestCheckersSquare(land);
+        move->captures |= over;
+        uint32_t kingRow = (search->side == CHECKERS_RED) ? RED_KING_ROW : BLACK_KING_ROW;
+        if (!king && (land & kingRow))
+        {
+            addMove(search->moves, &search->count, move);
+        }
+        else
+        {
+            addJumps(search, land, king);
+        }
+        move->captures &= ~over;
+        move->length--;
+    }
+
+    if (!extended && move->length > 1)
+    {
+        addMove(search->moves, &search->count, move);
+    }
+}
+
+void startCheckersBoard(CheckersBoard *board)
+{
+    board->pieces[CHECKERS_RED] = 0x00000FFFu;
+    board->pieces[CHECKERS_BLACK] = 0xFFF00000u;
+    board->kings = 0;
+    board->turn = CHECKERS_BLACK;
+}
+
+// Fills in every legal move for the side to move, and returns how many there are. If there are
+// captures, those are the only legal moves.
+int generateCheckersMoves(const CheckersBoard *board, CheckersMove *moves)
+{
+    int side = board->turn;
+    uint32_t own = board->pieces[side];
+    uint32_t other = board->pieces[side ^ 1];
+    uint32_t empty = ~(own | other);
+    uint32_t kings = own & board->kings;
+
+    // The pieces that can capture, found for all of them at once: a piece next to one of the
+    // other side's, with an empty square beyond it.
+    uint32_t jumpers = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        uint32_t movers = isForward(side, d) ? own : kings;
+        jumpers |= movers & step(other & step(empty, d ^ 3), d ^ 3);
+    }
+
+    if (jumpers)
+    {
+        JumpSearch search = { 0 };
+        search.moves = moves;
+        search.side = side;
+        search.other = other;
+        while (jumpers)
+        {
+            uint32_t piece = jumpers & (0 - jumpers);
+            jumpers ^= piece;
+            // The capturing piece's own square is free to land on again:
+            search.empty = empty | piece;
+            search.move.path[0] = (uint8_t)lowestCheckersSquare(piece);
+            search.move.length = 1;
+            addJumps(&search, piece, (piece & kings) != 0);
+        }
+        return search.count;
+    }
+
+    int count = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        uint32_t movers = isForward(side, d) ? own : kings;
+        uint32_t targets = step(movers, d) & empty;
+        while (targets && count < CHECKERS_MAX_MOVES)
+        {
+            uint32_t to = targets & (0 - targets);
+            targets ^= to;
+            CheckersMove *move = &moves[count++];
+            move->captures = 0;
+            move->path[0] = (uint8_t)lowestCheckersSquare(step(to, d ^ 3));
+            move->path[1] = (uint8_t)lowestCheckersSquare(to);
+            move->length = 2;
+        }
+    }
+    return count;
+}
+
+void makeCheckersMove(CheckersBoard *board, const CheckersMove *move)
+{
+    int side = board->turn;
+    uint32_t from = 1u << move->path[0];
+    uint32_t to = 1u << move->path[move->length - 1];
+
+    board->pieces[side] = (board->pieces[side] & ~from) | to;
+    board->pieces[side ^ 1] &= ~move->captures;
+    if (board->kings & from)
+    {
+        board->kings = (board->kings & ~from) | to;
+    }
+    board->kings &= ~move->captures;
+    board->kings |= to & ((side == CHECKERS_RED) ? RED_KING_ROW : BLACK_KING_ROW);
+    board->turn = side ^ 1;
+}
+
+//=============================================================================================
+// Squares
+//=============================================================================================
+
+// Where a square is on the full board.
+void getCheckersSquare(int square, int *x, int *y)
+{
+    *y = square / 4;
+    *x = 2 * (square % 4) + ((*y & 1) ^ 1);
+}
+
+// Returns -1 for a light square or one off the board.
+int findCheckersSquare(int x, int y)
+{
+    if (x < 0 || x >= 8 || y < 0 || y >= 8 || !((x ^ y) & 1))
+    {
+        return -1;
+    }
+    return 4 * y + x / 2;
+}
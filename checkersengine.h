@@ -0,0 +1,71 @@
+// The rules of checkers (English draughts), shared by the game and its tools.
+//
+// Boards are bitboards of the 32 dark squares. Square 4 * row + column is the column'th dark
+// square from the left in that row, counting rows up from red's side; on the full 8 by 8 board it
+// is at x = 2 * column + 1 in even rows and x = 2 * column in odd rows. Red starts in rows 0 to 2
+// and moves up, and black starts in rows 5 to 7, moves down, and moves first. Captures are
+// compulsory and go on for as long as the capturing piece can jump again, except that a man that
+// reaches the far row is crowned and its move ends there. A side that cannot move has lost.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define CHECKERS_BLACK 0
+#define CHECKERS_RED 1
+
+// A king can take at most all twelve of the other side's pieces, in thirteen squares:
+#define CHECKERS_MAX_PATH 13
+#define CHECKERS_MAX_MOVES 128
+
+typedef struct CheckersBoard
+{
+    // Indexed by side:
+    uint32_t pieces[2];
+    uint32_t kings;
+    // The side to move:
+    int turn;
+} CheckersBoard;
+
+typedef struct CheckersMove
+{
+    // The pieces taken, as a bitboard:
+    uint32_t captures;
+    // Every square the piece stops on, starting where it is:
+    uint8_t path[CHECKERS_MAX_PATH];
+    uint8_t length;
+} CheckersMove;
+
+// How many squares a bitboard has, and the lowest one, which it must have:
+static inline int countCheckersSquares(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt(bits);
+#else
+    return __builtin_popcount(bits);
+#endif
+}
+
+static inline int lowestCheckersSquare(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+void startCheckersBoard(CheckersBoard *board);
+
+int generateCheckersMoves(const CheckersBoard *board, CheckersMove *moves);
+
+void makeCheckersMove(CheckersBoard *board, const CheckersMove *move);
+
+void getCheckersSquare(int square, int *x, int *y);
+
+int findCheckersSquare(int x, int y);
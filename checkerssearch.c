@@ -0,0 +1,816 @@
+#include "checkerssearch.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PLY 64
+#define WIN_SCORE 30000
+#define INFINITE_SCORE 32000
+// How many nodes the search visits between looks at the clock:
+#define CLOCK_NODES 1024
+// History scores are halved before they reach the killer moves' place in the move order:
+#define MAX_HISTORY (1 << 16)
+
+// What pieces are worth to the evaluation:
+#define MAN_VALUE 100
+#define KING_VALUE 140
+#define ADVANCE_VALUE 3
+#define BACK_ROW_VALUE 8
+#define CENTER_VALUE 5
+#define CENTER_SQUARES 0x00066000u
+// Wins that the endgame databases know of are worth less than a win the search can see, but still
+// count material, so that the winning side goes on to take pieces:
+#define ENDGAME_WIN_SCORE 20000
+
+// Transposition table entries are packed into 64 bits: the score, the depth it was searched to,
+// which kind of bound it is, where the best move went from and to, and the search's age.
+#define BUCKET_ENTRIES 4
+#define BOUND_UPPER 1
+#define BOUND_LOWER 2
+#define BOUND_EXACT 3
+#define AGE_MASK 63
+
+struct CheckersTableBucket
+{
+    // Each entry's check is its hash XORed with its data:
+    struct
+    {
+        uint64_t check, data;
+    } entries[BUCKET_ENTRIES];
+};
+
+// One thread's search, with what it has learned about move order:
+typedef struct SearchThread
+{
+    Uint64 deadline;
+    // The search also stops when this is set:
+    SDL_atomic_t *stop;
+    bool stopped;
+    uint64_t nodes;
+    CheckersTable *table;
+    uint64_t tableProbes, tableHits;
+    // The databases are only asked about positions with fewer pieces than the root:
+    const CheckersEndgames *endgames;
+    int rootPieces;
+    uint64_t endgameHits;
+    // Moves that caused a cutoff at each ply, and at any ply, by where they go from and to:
+    CheckersMove killers[MAX_PLY][2];
+    int history[32][32];
+} SearchThread;
+
+// Random numbers for each kind of piece on each square, and for red to move; see initializeKeys:
+static uint64_t Keys[2][2][32];
+static uint64_t TurnKey;
+
+static bool sameMove(const CheckersMove *a, const CheckersMove *b)
+{
+    return a->length > 0 && b->length > 0 &&
+        a->path[0] == b->path[0] &&
+        a->path[a->length - 1] == b->path[b->length - 1] &&
+        a->captures == b->captures;
+}
+
+//=============================================================================================
+// Transposition table
+//=============================================================================================
+
+// The keys are the same every run, from a fixed seed, so setting them again is harmless.
+static void initializeKeys(void)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t *keys = &Keys[0][0][0];
+    for (int i = 0; i <= 2 * 2 * 32; i++)
+    {
+        // splitmix64:
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        if (i < 2 * 2 * 32)
+        {
+            keys[i] = z;
+        }
+        else
+        {
+            TurnKey = z;
+        }
+    }
+}
+
+uint64_t hashCheckersBoard(const CheckersBoard *board)
+{
+    uint64_t hash = (board->turn == CHECKERS_RED) ? TurnKey : 0;
+    for (int side = 0; side < 2; side++)
+    {
+        uint32_t pieces = board->pieces[side];
+        while (pieces)
+        {
+            int square = lowestCheckersSquare(pieces);
+            pieces &= pieces - 1;
+            hash ^= Keys[side][(board->kings >> square) & 1][square];
+        }
+    }
+    return hash;
+}
+
+// The hash of `next`, which is `board` after `move`, from only the pieces that the move changed.
+static uint64_t updateHash(uint64_t hash, const CheckersBoard *board, const CheckersBoard *next, const CheckersMove *move)
+{
+    int side = board->turn;
+    int from = move->path[0];
+    int to = move->path[move->length - 1];
+    hash ^= Keys[side][(board->kings >> from) & 1][from];
+    hash ^= Keys[side][(next->kings >> to) & 1][to];
+    hash ^= TurnKey;
+    uint32_t captures = move->captures;
+    while (captures)
+    {
+        int square = lowestCheckersSquare(captures);
+        captures &= captures - 1;
+        hash ^= Keys[side ^ 1][(board->kings >> square) & 1][square];
+    }
+    return hash;
+}
+
+// Makes the biggest table that fits in the given size. Returns false if there is not enough memory.
+bool createCheckersTable(CheckersTable *table, size_t megabytes)
+{
+    initializeKeys();
+    memset(table, 0, sizeof(*table));
+    size_t size = (megabytes > 0 ? megabytes : 1) << 20;
+    table->bucketCount = 1;
+    while (table->bucketCount * 2 * sizeof(CheckersTableBucket) <= size)
+    {
+        table->bucketCount *= 2;
+    }
+
+    // Buckets must not straddle cache lines:
+    table->memory = malloc(table->bucketCount * sizeof(CheckersTableBucket) + 63);
+    if (!table->memory)
+    {
+        return false;
+    }
+    table->buckets = (CheckersTableBucket *)(((uintptr_t)table->memory + 63) & ~(uintptr_t)63);
+    clearCheckersTable(table);
+    return true;
+}
+
+void destroyCheckersTable(CheckersTable *table)
+{
+    free(table->memory);
+    memset(table, 0, sizeof(*table));
+}
+
+// Forgets every position. Nothing may be searching with the table.
+void clearCheckersTable(CheckersTable *table)
+{
+    memset(table->buckets, 0, table->bucketCount * sizeof(CheckersTableBucket));
+    table->age = 0;
+}
+
+static uint64_t packEntry(int score, int depth, int bound, const CheckersMove *move, int age)
+{
+    return (uint64_t)(uint16_t)score |
+        (uint64_t)depth << 16 |
+        (uint64_t)bound << 24 |
+        (uint64_t)move->path[0] << 26 |
+        (uint64_t)move->path[move->length - 1] << 31 |
+        (uint64_t)(age & AGE_MASK) << 36;
+}
+
+static int entryScore(uint64_t data) { return (int16_t)(data & 0xFFFF); }
+static int entryDepth(uint64_t data) { return (int)(data >> 16) & 0xFF; }
+static int entryBound(uint64_t data) { return (int)(data >> 24) & 3; }
+static int entryFrom(uint64_t data) { return (int)(data >> 26) & 31; }
+static int entryTo(uint64_t data) { return (int)(data >> 31) & 31; }
+static int entryAge(uint64_t data) { return (int)(data >> 36) & AGE_MASK; }
+
+// Wins are scored by how far they are from the root, but are stored by how far they are from the
+// position itself, which is the same however the search got there:
+static int scoreToTable(int score, int ply)
+{
+    return (score >= WIN_SCORE - MAX_PLY) ? score + ply : (score <= -WIN_SCORE + MAX_PLY) ? score - ply : score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+    return (score >= WIN_SCORE - MAX_PLY) ? score - ply : (score <= -WIN_SCORE + MAX_PLY) ? score + ply : score;
+}
+
+// Each word is read once, so an entry that another thread is halfway through writing cannot pass
+// the check.
+static bool probeTable(CheckersTable *table, uint64_t hash, uint64_t *data)
+{
+    CheckersTableBucket *bucket = &table->buckets[hash & (table->bucketCount - 1)];
+    for (int i = 0; i < BUCKET_ENTRIES; i++)
+    {
+        uint64_t check = bucket->entries[i].check;
+        uint64_t entry = bucket->entries[i].data;
+        if ((check ^ entry) == hash && entry != 0)
+        {
+            *data = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Replaces the position's old entry if it has one, or else the least useful entry in its bucket:
+// one from an earlier search, or failing that, the shallowest.
+static void storeTable(CheckersTable *table, uint64_t hash, uint64_t data)
+{
+    CheckersTableBucket *bucket = &table->buckets[hash & (table->bucketCount - 1)];
+    int replace = 0;
+    int lowest = INT_MAX;
+    for (int i = 0; i < BUCKET_ENTRIES; i++)
+    {
+        uint64_t entry = bucket->entries[i].data;
+        if ((bucket->entries[i].check ^ entry) == hash)
+        {
+            replace = i;
+            break;
+        }
+        int worth = entryDepth(entry) + ((entryAge(entry) == (table->age & AGE_MASK)) ? 256 : 0);
+        if (worth < lowest)
+        {
+            lowest = worth;
+            replace = i;
+        }
+    }
+    bucket->entries[replace].check = hash ^ data;
+    bucket->entries[replace].data = data;
+}
+
+//=============================================================================================
+// Evaluation
+//=============================================================================================
+
+// For the side to move. Besides material, men are worth a little more the closer they get to
+// being crowned, and for staying on the back row, where they keep the other side from crowning.
+static int evaluate(const CheckersBoard *board)
+{
+    int score = 0;
+    for (int side = 0; side < 2; side++)
+    {
+        uint32_t pieces = board->pieces[side];
+        uint32_t men = pieces & ~board->kings;
+        int value = MAN_VALUE * countCheckersSquares(men) + KING_VALUE * countCheckersSquares(pieces & board->kings);
+        for (int row = 1; row < 7; row++)
+        {
+            int advance = (side == CHECKERS_RED) ? row : 7 - row;
+            value += ADVANCE_VALUE * advance * countCheckersSquares(men & (0xFu << (4 * row)));
+        }
+        value += BACK_ROW_VALUE * countCheckersSquares(men & ((side == CHECKERS_RED) ? 0x0000000Fu : 0xF0000000u));
+        value += CENTER_VALUE * countCheckersSquares(pieces & CENTER_SQUARES);
+        score += (side == board->turn) ? value : -value;
+    }
+    return score;
+}
+
+static int scoreEndgame(const CheckersBoard *board, int value)
+{
+    switch (value)
+    {
+    case CHECKERS_WIN: return ENDGAME_WIN_SCORE + evaluate(board);
+    case CHECKERS_LOSS: return -ENDGAME_WIN_SCORE + evaluate(board);
+    default: return 0;
+    }
+}
+
+//=============================================================================================
+// Search
+//=============================================================================================
+
+// The best move found so far goes first, then the captures that take the most, then moves that
+// have caused cutoffs before:
+static int scoreMove(SearchThread *thread, const CheckersMove *move, const CheckersMove *best, int ply)
+{
+    if (best && sameMove(move, best))
+    {
+        return 1 << 30;
+    }
+    if (move->captures)
+    {
+        return (1 << 20) + countCheckersSquares(move->captures);
+    }
+    if (sameMove(move, &thread->killers[ply][0]))
+    {
+        return 1 << 19;
+    }
+    if (sameMove(move, &thread->killers[ply][1]))
+    {
+        return 1 << 18;
+    }
+    return thread->history[move->path[0]][move->path[move->length - 1]];
+}
+
+// Moves the best of the moves from `first` on to `first`:
+static void pickMove(CheckersMove *moves, int *scores, int first, int count)
+{
+    int best = first;
+    for (int i = first + 1; i < count; i++)
+    {
+        if (scores[i] > scores[best])
+        {
+            best = i;
+        }
+    }
+    if (best != first)
+    {
+        CheckersMove move = moves[first];
+        moves[first] = moves[best];
+        moves[best] = move;
+        int score = scores[first];
+        scores[first] = scores[best];
+        scores[best] = score;
+    }
+}
+
+static void rememberCutoff(SearchThread *thread, const CheckersMove *move, int depth, int ply)
+{
+    if (!sameMove(move, &thread->killers[ply][0]))
+    {
+        thread->killers[ply][1] = thread->killers[ply][0];
+        thread->killers[ply][0] = *move;
+    }
+
+    int *history = &thread->history[move->path[0]][move->path[move->length - 1]];
+    *history += depth * depth;
+    if (*history >= MAX_HISTORY)
+    {
+        for (int from = 0; from < 32; from++)
+        {
+            for (int to = 0; to < 32; to++)
+            {
+                thread->history[from][to] /= 2;
+            }
+        }
+    }
+}
+
+// Negamax alpha-beta with a null window for every move after the first. Captures are forced, so
+// past the nominal depth the search keeps going for as long as there are captures to make, and
+// only judges positions that are quiet. Positions that the table has already searched deep
+// enough are not searched again, and otherwise its best move for them goes first. Endgames that
+// the search reaches by taking pieces are looked up instead of searched.
+static int searchNode(SearchThread *thread, const CheckersBoard *board, uint64_t hash, int depth, int ply, int alpha, int beta)
+{
+    if (++thread->nodes % CLOCK_NODES == 0 &&
+        (SDL_GetPerformanceCounter() >= thread->deadline || (thread->stop && SDL_AtomicGet(thread->stop))))
+    {
+        thread->stopped = true;
+    }
+    if (thread->stopped)
+    {
+        return 0;
+    }
+
+    if (thread->endgames && countCheckersSquares(board->pieces[CHECKERS_BLACK] | board->pieces[CHECKERS_RED]) < thread->rootPieces)
+    {
+        int value = probeCheckersEndgames(thread->endgames, board);
+        if (value != CHECKERS_ENDGAME_MISSING)
+        {
+            thread->endgameHits++;
+            return scoreEndgame(board, value);
+        }
+    }
+
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = generateCheckersMoves(board, moves);
+    if (count == 0)
+    {
+        return -WIN_SCORE + ply;
+    }
+    if ((depth <= 0 && !moves[0].captures) || ply >= MAX_PLY - 1)
+    {
+        return evaluate(board);
+    }
+
+    // Capture sequences past the nominal depth all count as depth 0:
+    CheckersTable *table = thread->table;
+    int tableDepth = (depth > 0) ? depth : 0;
+    int tableFrom = -1;
+    int tableTo = -1;
+    uint64_t entry;
+    if (table)
+    {
+        thread->tableProbes++;
+        if (probeTable(table, hash, &entry))
+        {
+            thread->tableHits++;
+            int score = scoreFromTable(entryScore(entry), ply);
+            int bound = entryBound(entry);
+            if (entryDepth(entry) >= tableDepth &&
+                (bound == BOUND_EXACT ||
+                (bound == BOUND_LOWER && score >= beta) ||
+                (bound == BOUND_UPPER && score <= alpha)))
+            {
+                return score;
+            }
+            tableFrom = entryFrom(entry);
+            tableTo = entryTo(entry);
+        }
+    }
+
+    int scores[CHECKERS_MAX_MOVES];
+    for (int i = 0; i < count; i++)
+    {
+        CheckersMove *move = &moves[i];
+        bool tableMove = (move->path[0] == tableFrom && move->path[move->length - 1] == tableTo);
+        scores[i] = tableMove ? (1 << 30) : scoreMove(thread, move, NULL, ply);
+    }
+
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    int best = 0;
+    for (int i = 0; i < count; i++)
+    {
+        pickMove(moves, scores, i, count);
+        CheckersBoard next = *board;
+        makeCheckersMove(&next, &moves[i]);
+        uint64_t nextHash = updateHash(hash, board, &next, &moves[i]);
+
+        int score;
+        if (i == 0)
+        {
+            score = -searchNode(thread, &next, nextHash, depth - 1, ply + 1, -beta, -alpha);
+        }
+        else
+        {
+            score = -searchNode(thread, &next, nextHash, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+            {
+                score = -searchNode(thread, &next, nextHash, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        if (thread->stopped)
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            best = i;
+        }
+        if (score > alpha)
+        {
+            alpha = score;
+        }
+        if (alpha >= beta)
+        {
+            if (!moves[i].captures)
+            {
+                rememberCutoff(thread, &moves[i], depth, ply);
+            }
+            break;
+        }
+    }
+
+    if (table)
+    {
+        int bound = (bestScore >= beta) ? BOUND_LOWER : (bestScore > originalAlpha) ? BOUND_EXACT : BOUND_UPPER;
+        int depthStored = (tableDepth < 255) ? tableDepth : 255;
+        storeTable(table, hash, packEntry(scoreToTable(bestScore, ply), depthStored, bound, &moves[best], table->age));
+    }
+    return bestScore;
+}
+
+// When the databases know the root, the search only has to choose between the moves that keep
+// the best result, which the databases also know. Returns how many of those there are.
+static int keepBestEndgameMoves(const CheckersEndgames *endgames, const CheckersBoard *board, CheckersMove *moves, int count)
+{
+    if (!endgames || probeCheckersEndgames(endgames, board) == CHECKERS_ENDGAME_MISSING)
+    {
+        return count;
+    }
+
+    // For the side to move, the other side's loss is best:
+    int ranks[CHECKERS_MAX_MOVES];
+    int bestRank = 0;
+    for (int i = 0; i < count; i++)
+    {
+        CheckersBoard next = *board;
+        makeCheckersMove(&next, &moves[i]);
+        int value = next.pieces[next.turn] ? probeCheckersEndgames(endgames, &next) : CHECKERS_LOSS;
+        ranks[i] = (value == CHECKERS_LOSS) ? 2 : (value == CHECKERS_WIN) ? 0 : 1;
+        bestRank = (ranks[i] > bestRank) ? ranks[i] : bestRank;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (ranks[i] == bestRank)
+        {
+            moves[kept++] = moves[i];
+        }
+    }
+    return kept;
+}
+
+// Searches one ply deeper each time, starting with the best move from the last time, until the
+// thread is stopped or reaches the last depth. Only searches that finish count. The result's move
+// has a length of 0 if the side to move has lost.
+static void searchRoot(SearchThread *thread, const CheckersBoard *board, int firstDepth, int lastDepth, CheckersSearchResult *result)
+{
+    uint64_t hash = hashCheckersBoard(board);
+    memset(result, 0, sizeof(*result));
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = generateCheckersMoves(board, moves);
+    count = keepBestEndgameMoves(thread->endgames, board, moves, count);
+    thread->rootPieces = countCheckersSquares(board->pieces[CHECKERS_BLACK] | board->pieces[CHECKERS_RED]);
+    if (count > 0)
+    {
+        result->move = moves[0];
+    }
+
+    // There is nothing to think about with only one move:
+    for (int depth = firstDepth; depth <= lastDepth && count > 1; depth++)
+    {
+        int scores[CHECKERS_MAX_MOVES];
+        for (int i = 0; i < count; i++)
+        {
+            scores[i] = scoreMove(thread, &moves[i], &result->move, 0);
+        }
+
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        CheckersMove best = moves[0];
+        for (int i = 0; i < count; i++)
+        {
+            pickMove(moves, scores, i, count);
+            CheckersBoard next = *board;
+            makeCheckersMove(&next, &moves[i]);
+            uint64_t nextHash = updateHash(hash, board, &next, &moves[i]);
+
+            int score;
+            if (i == 0)
+            {
+                score = -searchNode(thread, &next, nextHash, depth - 1, 1, -beta, -alpha);
+            }
+            else
+            {
+                score = -searchNode(thread, &next, nextHash, depth - 1, 1, -alpha - 1, -alpha);
+                if (score > alpha)
+                {
+                    score = -searchNode(thread, &next, nextHash, depth - 1, 1, -beta, -alpha);
+                }
+            }
+            if (thread->stopped)
+            {
+                break;
+            }
+            if (score > alpha)
+            {
+                alpha = score;
+                best = moves[i];
+            }
+        }
+        if (thread->stopped)
+        {
+            break;
+        }
+
+        result->move = best;
+        result->score = alpha;
+        result->depth = depth;
+
+        // Once the game is decided, searching deeper will not change the move:
+        if (abs(alpha) >= WIN_SCORE - MAX_PLY)
+        {
+            break;
+        }
+    }
+
+    result->nodes = thread->nodes;
+    result->tableProbes = thread->tableProbes;
+    result->tableHits = thread->tableHits;
+    result->endgameHits = thread->endgameHits;
+}
+
+static int getLastDepth(CheckersSearch *search)
+{
+    return (search->maxDepth > 0 && search->maxDepth < MAX_PLY) ? search->maxDepth : MAX_PLY - 1;
+}
+
+// Searches for as long as the time budget allows, with the helpers if there are any and the
+// search has a table for them to share. Only one of these can run on a search at a time.
+void findCheckersMove(CheckersSearch *search, const CheckersBoard *board, CheckersSearchResult *result)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    SearchThread searchThread;
+    SearchThread *thread = &searchThread;
+    memset(thread, 0, sizeof(*thread));
+    thread->deadline = start + (Uint64)(search->timeBudget * frequency);
+    thread->stop = &search->quit;
+    thread->table = search->table;
+    thread->endgames = search->endgames;
+    if (thread->table)
+    {
+        thread->table->age++;
+    }
+
+    int helperCount = thread->table ? search->helperCount : 0;
+    if (helperCount > 0)
+    {
+        search->root = *board;
+        search->deadline = thread->deadline;
+        SDL_AtomicSet(&search->stop, 0);
+        for (int i = 0; i < helperCount; i++)
+        {
+            SDL_SemPost(search->helpers[i].wake);
+        }
+    }
+
+    searchRoot(thread, board, 1, getLastDepth(search), result);
+
+    if (helperCount > 0)
+    {
+        SDL_AtomicSet(&search->stop, 1);
+        for (int i = 0; i < helperCount; i++)
+        {
+            SDL_SemWait(search->helpersDone);
+        }
+        for (int i = 0; i < helperCount; i++)
+        {
+            CheckersHelper *helper = &search->helpers[i];
+            result->nodes += helper->nodes;
+            result->tableProbes += helper->tableProbes;
+            result->tableHits += helper->tableHits;
+            result->endgameHits += helper->endgameHits;
+        }
+    }
+    result->seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+}
+
+//=============================================================================================
+// Helper threads
+//=============================================================================================
+
+// Half of the helpers start a ply deeper than the rest, so that they are not all searching the
+// same depth as the main search.
+static int runHelper(void *data)
+{
+    CheckersHelper *helper = data;
+    CheckersSearch *search = helper->search;
+    for (;;)
+    {
+        SDL_SemWait(helper->wake);
+        if (search->quitting)
+        {
+            break;
+        }
+
+        SearchThread searchThread;
+        SearchThread *thread = &searchThread;
+        memset(thread, 0, sizeof(*thread));
+        thread->deadline = search->deadline;
+        thread->stop = &search->stop;
+        thread->table = search->table;
+        thread->endgames = search->endgames;
+        CheckersSearchResult result;
+        searchRoot(thread, &search->root, 1 + (~helper->index & 1), getLastDepth(search), &result);
+        helper->nodes = result.nodes;
+        helper->tableProbes = result.tableProbes;
+        helper->tableHits = result.tableHits;
+        helper->endgameHits = result.endgameHits;
+        SDL_SemPost(search->helpersDone);
+    }
+    return 0;
+}
+
+// Starts threads to help findCheckersMove, up to CHECKERS_MAX_HELPERS. Returns false if they
+// cannot all be started; the ones that did start still help, and helperCount says how many.
+bool startCheckersHelpers(CheckersSearch *search, int helperCount)
+{
+    helperCount = (helperCount > CHECKERS_MAX_HELPERS) ? CHECKERS_MAX_HELPERS : helperCount;
+    if (helperCount <= 0)
+    {
+        return true;
+    }
+    search->helpersDone = SDL_CreateSemaphore(0);
+    if (!search->helpersDone)
+    {
+        return false;
+    }
+
+    search->quitting = false;
+    for (int i = 0; i < helperCount; i++)
+    {
+        CheckersHelper *helper = &search->helpers[i];
+        memset(helper, 0, sizeof(*helper));
+        helper->search = search;
+        helper->index = i;
+        helper->wake = SDL_CreateSemaphore(0);
+        if (!helper->wake)
+        {
+            return false;
+        }
+        helper->thread = SDL_CreateThread(runHelper, "checkers helper", helper);
+        if (!helper->thread)
+        {
+            SDL_DestroySemaphore(helper->wake);
+            return false;
+        }
+        search->helperCount = i + 1;
+    }
+    return true;
+}
+
+// Ends the helper threads. Nothing may be searching with them.
+void stopCheckersHelpers(CheckersSearch *search)
+{
+    search->quitting = true;
+    for (int i = 0; i < search->helperCount; i++)
+    {
+        CheckersHelper *helper = &search->helpers[i];
+        SDL_SemPost(helper->wake);
+        SDL_WaitThread(helper->thread, NULL);
+        SDL_DestroySemaphore(helper->wake);
+    }
+    if (search->helpersDone)
+    {
+        SDL_DestroySemaphore(search->helpersDone);
+    }
+    search->helpersDone = NULL;
+    search->helperCount = 0;
+    search->quitting = false;
+}
+
+//=============================================================================================
+// Search thread
+//=============================================================================================
+
+static int runSearch(void *data)
+{
+    CheckersSearch *search = data;
+    for (;;)
+    {
+        SDL_SemWait(search->wake);
+        if (SDL_AtomicGet(&search->quit))
+        {
+            break;
+        }
+        int request = SDL_AtomicGet(&search->requested);
+        findCheckersMove(search, &search->request, &search->result);
+        // Setting this is a full barrier, so the result is there for whoever sees it:
+        SDL_AtomicSet(&search->finished, request);
+    }
+    return 0;
+}
+
+// Starts a thread that searches whenever it is asked to; see requestCheckersMove. The table can be
+// NULL. Returns false if the thread cannot be started.
+bool startCheckersSearch(CheckersSearch *search, double timeBudget, CheckersTable *table)
+{
+    memset(search, 0, sizeof(*search));
+    search->timeBudget = timeBudget;
+    search->table = table;
+    search->wake = SDL_CreateSemaphore(0);
+    if (!search->wake)
+    {
+        return false;
+    }
+    search->thread = SDL_CreateThread(runSearch, "checkers search", search);
+    return search->thread != NULL;
+}
+
+// Ends the search thread, cutting short anything it is searching. Stop the helpers after this.
+void stopCheckersSearch(CheckersSearch *search)
+{
+    if (!search->thread)
+    {
+        return;
+    }
+    SDL_AtomicSet(&search->quit, 1);
+    SDL_AtomicSet(&search->stop, 1);
+    SDL_SemPost(search->wake);
+    SDL_WaitThread(search->thread, NULL);
+    SDL_DestroySemaphore(search->wake);
+    search->thread = NULL;
+    search->wake = NULL;
+}
+
+// Has the search thread look for the best move for the side to move. There can only be one
+// request out at a time, so wait for takeCheckersMove before asking again.
+void requestCheckersMove(CheckersSearch *search, const CheckersBoard *board)
+{
+    search->request = *board;
+    SDL_AtomicAdd(&search->requested, 1);
+    SDL_SemPost(search->wake);
+}
+
+// Returns true with the answer to the last request, once it is ready. This never waits, so it
+// can be called every frame.
+bool takeCheckersMove(CheckersSearch *search, CheckersMove *move)
+{
+    int requested = SDL_AtomicGet(&search->requested);
+    if (search->taken == requested || SDL_AtomicGet(&search->finished) != requested)
+    {
+        return false;
+    }
+    *move = search->result.move;
+    search->taken = requested;
+    return true;
+}
@@ -0,0 +1,103 @@
+// A checkers player for checkersengine.c: iterative deepening alpha-beta search with a time
+// budget and a transposition table, which can run on its own thread; see startCheckersSearch. It
+// can also use more cores, with helper threads that share its table (see startCheckersHelpers),
+// and look endgames up in the databases in checkersendgames.h.
+
+#include <SDL2/SDL.h>
+#include "checkersendgames.h"
+
+#define CHECKERS_MAX_HELPERS 63
+
+typedef struct CheckersSearchResult
+{
+    CheckersMove move;
+    // For the side to move, in hundredths of a man:
+    int score;
+    // The deepest search that finished:
+    int depth;
+    uint64_t nodes;
+    double seconds;
+    // How often the transposition table was asked about a position, and how often it knew it:
+    uint64_t tableProbes, tableHits;
+    // How many positions the endgame databases settled:
+    uint64_t endgameHits;
+} CheckersSearchResult;
+
+typedef struct CheckersTableBucket CheckersTableBucket;
+
+// Positions that searches have seen before, by their Zobrist hashes. Any number of searches can
+// share one table while they run: entries are written without locks, and one that is torn by two
+// writes at once fails its check and is ignored.
+typedef struct CheckersTable
+{
+    // Each bucket takes one cache line, and the count is a power of two:
+    CheckersTableBucket *buckets;
+    size_t bucketCount;
+    void *memory;
+    // Entries from earlier searches make way for the current one's:
+    int age;
+} CheckersTable;
+
+typedef struct CheckersHelper
+{
+    struct CheckersSearch *search;
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    int index;
+    // From its last search:
+    uint64_t nodes, tableProbes, tableHits, endgameHits;
+} CheckersHelper;
+
+typedef struct CheckersSearch
+{
+    // Every search stops after this many seconds, or at this depth if it is not 0:
+    double timeBudget;
+    int maxDepth;
+    // Can be NULL, or shared with other searches:
+    CheckersTable *table;
+    // Can be NULL:
+    const CheckersEndgames *endgames;
+
+    // Lazy SMP: while findCheckersMove searches, the helpers search the same position to varied
+    // depths, and what they put in the table lets it go deeper sooner. Its own search still picks
+    // the move. They run until `stop` is set, and each posts `helpersDone` when it has stopped:
+    CheckersHelper helpers[CHECKERS_MAX_HELPERS];
+    int helperCount;
+    SDL_sem *helpersDone;
+    CheckersBoard root;
+    Uint64 deadline;
+    SDL_atomic_t stop;
+    bool quitting;
+
+    // The search thread takes requests through these. A result is ready once `finished` has
+    // caught up with `requested`. Setting `quit` ends the search thread and any search:
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+    CheckersBoard request;
+    SDL_atomic_t requested, finished;
+    CheckersSearchResult result;
+    int taken;
+} CheckersSearch;
+
+bool createCheckersTable(CheckersTable *table, size_t megabytes);
+
+void destroyCheckersTable(CheckersTable *table);
+
+void clearCheckersTable(CheckersTable *table);
+
+uint64_t hashCheckersBoard(const CheckersBoard *board);
+
+void findCheckersMove(CheckersSearch *search, const CheckersBoard *board, CheckersSearchResult *result);
+
+bool startCheckersSearch(CheckersSearch *search, double timeBudget, CheckersTable *table);
+
+void stopCheckersSearch(CheckersSearch *search);
+
+bool startCheckersHelpers(CheckersSearch *search, int helperCount);
+
+void stopCheckersHelpers(CheckersSearch *search);
+
+void requestCheckersMove(CheckersSearch *search, const CheckersBoard *board);
+
+bool takeCheckersMove(CheckersSearch *search, CheckersMove *move);
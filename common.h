@@ -2,6 +2,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <SDL2/SDL.h>
 #include "GL.h"
 
@@ -14,6 +15,7 @@
 #define FRAME_TIME (1 / 60.0f)
 #define UNUSED(var) (void)(var)
 #define COUNTOF(a) (sizeof(a) / sizeof(a[0]))
+#define HASH_SEED 0xCBF29CE484222325ull
 
 typedef struct Vector3
 {
@@ -25,11 +27,23 @@ typedef struct Vector4
     float x, y, z, w;
 } Vector4;
 
+typedef struct Quaternion
+{
+    float x, y, z, w;
+} Quaternion;
+
 typedef struct Matrix4
 {
     float e[16];
 } Matrix4;
 
+// Points or directions stored as one array per coordinate, for the batch transforms; see
+// matrixTransformPoints.
+typedef struct Vector3Arrays
+{
+    float *x, *y, *z;
+} Vector3Arrays;
+
 typedef struct Color
 {
     float r, g, b, a;
@@ -48,12 +62,238 @@ typedef struct BasicVertex
     PackedColor color;
 } BasicVertex;
 
+// The contents of a file from the assets directory; see loadAsset.
+typedef struct Asset
+{
+    const char *data;
+    size_t size;
+    bool allocated;
+} Asset;
+
+// A program that may still be compiling; see requestShaderProgram.
+typedef struct ShaderProgram
+{
+    GLuint program;
+    GLuint pending;
+    GLuint vertexShader, fragmentShader, computeShader;
+    uint64_t cacheKey;
+} ShaderProgram;
+
+// The uniforms of all the shaders, for the setters; see setUniformFloats. The names are in shaders.c.
+#define UNIFORM_PROJECTION 0
+#define UNIFORM_MODEL_TRANSFORM 1
+#define UNIFORM_MODEL_COLOR 2
+#define UNIFORM_AMBIENT_LIGHT 3
+#define UNIFORM_DRAW_DATA 4
+#define UNIFORM_OBJECT_COUNT 5
+#define UNIFORM_FRUSTUM 6
+#define UNIFORM_CAMERA_POSITION 7
+#define UNIFORM_LOD_COUNT 8
+#define UNIFORM_LOD_DISTANCE 9
+#define UNIFORM_LOD_MESH 10
+#define UNIFORM_TIME_STEP 11
+#define UNIFORM_SEED 12
+#define UNIFORM_EMITTER_COUNT 13
+#define UNIFORM_EMITTER_POSITION 14
+#define UNIFORM_EMITTER_VELOCITY 15
+#define UNIFORM_EMITTER_COLOR 16
+#define UNIFORM_EMITTER_LIFE 17
+#define UNIFORM_GRAVITY 18
+#define UNIFORM_ATTRACTOR_COUNT 19
+#define UNIFORM_ATTRACTOR 20
+#define UNIFORM_CAMERA_RIGHT 21
+#define UNIFORM_CAMERA_UP 22
+#define UNIFORM_PARTICLE_SIZE 23
+#define UNIFORM_COUNT 24
+
+// A range of the renderer's shared vertex and index buffers; see setMeshData.
 typedef struct Mesh
 {
-    GLuint vao, vertexBuffer, indexBuffer;
+    GLint baseVertex;
+    GLuint firstIndex;
     size_t primitiveCount;
 } Mesh;
 
+// Per-draw data for shaders built with INSTANCED; see addDraw.
+typedef struct DrawInstance
+{
+    Matrix4 transform;
+    Color color;
+} DrawInstance;
+
+// The layout that glMultiDrawElementsIndirect reads.
+typedef struct DrawCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+} DrawCommand;
+
+// An object in a cull set: its draw and a bounding sphere in world space (center, radius).
+typedef struct CullObject
+{
+    DrawInstance instance;
+    Vector4 bounds;
+} CullObject;
+
+// Draws that stay in GPU buffers between frames; see createDrawSet.
+typedef struct DrawSet
+{
+    GLuint commandBuffer, instanceBuffer, instanceTexture;
+    DrawCommand *commands;
+    DrawInstance *instances;
+    size_t count, capacity;
+    // The range of draws that changed since the set was last drawn:
+    size_t dirtyStart, dirtyEnd;
+} DrawSet;
+
+#define MAX_LODS 4
+
+// Objects that are culled and given a level of detail every frame; see createCullSet.
+typedef struct CullSet
+{
+    Mesh lods[MAX_LODS];
+    float lodDistances[MAX_LODS];
+    int lodCount;
+    GLuint objectBuffer, commandBuffer, instanceBuffer, counterBuffer, instanceTexture;
+    CullObject *objects;
+    size_t count, capacity;
+    size_t dirtyStart, dirtyEnd;
+} CullSet;
+
+// Where a scene node is drawn, in either a draw set or a cull set:
+typedef struct SceneDraw
+{
+    DrawSet *drawSet;
+    CullSet *cullSet;
+    size_t index;
+} SceneDraw;
+
+// A hierarchy of transforms kept in flat arrays; see createScene. Parents always come before
+// their children.
+typedef struct Scene
+{
+    int32_t *parents;
+    Vector3 *positions;
+    Quaternion *rotations;
+    Vector3 *scales;
+    Matrix4 *worlds;
+    bool *dirty;
+    // The last update that changed each node's world transform:
+    uint32_t *updated;
+    SceneDraw *draws;
+    size_t count, capacity;
+    // Nodes before this one are not dirty:
+    size_t firstDirty;
+    uint32_t updateCount;
+} Scene;
+
+// Work for the job system: a function to run over the items [start, end) of some data.
+typedef void (*JobFunction)(void *data, size_t start, size_t end);
+
+// Counts the jobs that have been added against it and have not finished; see addJob. Start it at
+// zero, and only reuse it once waitForJobs has returned.
+typedef struct JobCounter
+{
+    SDL_atomic_t pending;
+} JobCounter;
+
+// Entities kept as one array per component; see createEntityStore. The live entities are packed
+// at the front of every array, in no particular order.
+typedef struct EntityStore
+{
+    Vector3 *positions;
+    Quaternion *orientations;
+    float *scales;
+    Vector3 *velocities;
+    // The axis of rotation, scaled by the rate in radians per second:
+    Vector3 *spins;
+    Color *colors;
+    // Indexes the mesh list given to drawEntities:
+    uint16_t *meshes;
+
+    // The entity in each slot, and the slot of each entity or, for a free ID, the next free ID:
+    uint32_t *ids;
+    uint32_t *slots;
+    uint32_t firstFree;
+    size_t count, capacity;
+} EntityStore;
+
+// Updates the entities in slots [start, end) of a store; see runEntitySystem.
+typedef void (*EntitySystem)(EntityStore *store, size_t start, size_t end, float timeStep);
+
+#define MAX_PARTICLE_EMITTERS 4
+#define MAX_PARTICLE_ATTRACTORS 4
+
+// Where particles are born. Each one starts somewhere within `radius` of the position, moving at
+// the velocity plus up to `spread` in a random direction, and lives for about `lifetime` seconds.
+// Emitters take a share of the births proportional to their `share`.
+typedef struct ParticleEmitter
+{
+    Vector3 position;
+    float radius;
+    Vector3 velocity;
+    float spread;
+    Color color;
+    float lifetime;
+    float share;
+} ParticleEmitter;
+
+// Pulls particles toward a point with a force that falls off with the square of the distance.
+// A negative strength pushes them away.
+typedef struct ParticleAttractor
+{
+    Vector3 position;
+    float strength;
+} ParticleAttractor;
+
+// Particles that are only ever touched by the GPU; see createParticleSystem. The emitters, forces
+// and sprite size can be changed at any time.
+typedef struct ParticleSystem
+{
+    ParticleEmitter emitters[MAX_PARTICLE_EMITTERS];
+    int emitterCount;
+    ParticleAttractor attractors[MAX_PARTICLE_ATTRACTORS];
+    int attractorCount;
+    Vector3 gravity;
+    float drag;
+    float size;
+
+    size_t count;
+    // The particle state is read from one buffer and written to the other, which swap every step:
+    GLuint buffers[2];
+    GLuint stepVertexArrays[2], drawVertexArrays[2];
+    int current;
+    uint32_t stepCount;
+} ParticleSystem;
+
+#define MAX_PACKET_DRAWS 256
+
+// Instanced draws recorded into a frame packet; see addPacketDraw.
+typedef struct PacketDraw
+{
+    Mesh *mesh;
+    DrawInstance *instances;
+    size_t count;
+} PacketDraw;
+
+// Everything the render thread needs to draw one frame. The simulation thread fills it in and
+// leaves it alone from submitFramePacket until it comes back from beginFramePacket.
+typedef struct FramePacket
+{
+    // The mode's own uniforms and such, from allocatePacketData:
+    void *data;
+    PacketDraw draws[MAX_PACKET_DRAWS];
+    int drawCount;
+
+    uint8_t *arena;
+    size_t used, capacity;
+} FramePacket;
+
+typedef void (*FrameFunction)(FramePacket *packet);
+
 //=============================================================================================
 // Basics
 //=============================================================================================
@@ -62,14 +302,88 @@ void check(bool condition, char *message);
 
 void *xalloc(size_t size);
 
+char *tryReadFile(char *path, size_t *size);
+
+char *tryReadTextFile(char *path);
+
 char *readTextFile(char *path);
 
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size);
+
+uint64_t hashString(uint64_t hash, const char *text);
+
+//=============================================================================================
+// Assets
+//=============================================================================================
+
+bool loadAsset(char *name, Asset *asset);
+
+void releaseAsset(Asset *asset);
+
+char *getAssetDirectory();
+
+void useLooseAssets();
+
 //=============================================================================================
 // GL
 //=============================================================================================
 
+extern FILE *GLLog;
+
 GLuint compileShaderProgram(char *vertexShaderSource, char *fragmentShaderSource);
 
+void requestShaderProgram(ShaderProgram *shader, char *vertexShaderSource, char *fragmentShaderSource);
+
+void requestComputeProgram(ShaderProgram *shader, char *computeShaderSource);
+
+void requestFeedbackProgram(ShaderProgram *shader, char *vertexShaderSource, char *feedbackVaryings);
+
+bool isShaderProgramReady(ShaderProgram *shader);
+
+GLuint getShaderProgram(ShaderProgram *shader);
+
+GLuint useShaderProgram(ShaderProgram *shader);
+
+void useProgram(GLuint program);
+
+GLuint getCurrentProgram();
+
+void setUniformFloats(int uniform, int components, int count, const float *values);
+
+void setUniformInts(int uniform, int components, int count, const GLint *values);
+
+void setUniformFloat(int uniform, float value);
+
+void setUniformInt(int uniform, GLint value);
+
+void setUniformUint(int uniform, GLuint value);
+
+void setUniformVector3(int uniform, Vector3 value);
+
+void setUniformVector4(int uniform, Vector4 value);
+
+void setUniformColor(int uniform, Color value);
+
+void setUniformMatrix4(int uniform, Matrix4 *value);
+
+void setUniformBlockBinding(int uniform, GLuint binding);
+
+char *preprocessShader(char *name, char *defines);
+
+void addShaderDefines(char *defines);
+
+ShaderProgram *requestShaderVariant(char *vertexShaderName, char *fragmentShaderName, char *modeDefines);
+
+ShaderProgram *requestComputeVariant(char *computeShaderName, char *modeDefines);
+
+ShaderProgram *requestFeedbackVariant(char *vertexShaderName, char *feedbackVaryings, char *modeDefines);
+
+ShaderProgram *requestBasicShader(char *defines);
+
+void startShaderHotReload();
+
+void updateShaderHotReload();
+
 void createMesh(Mesh *mesh);
 
 void setMeshData(
@@ -77,16 +391,136 @@ void setMeshData(
     size_t vertexCount, BasicVertex *vertexData,
     size_t indexCount, uint16_t *indexData);
 
+void useBasicRenderer();
+
+void startRenderer();
+
+void drawMesh(Mesh *mesh);
+
+void addDraw(Mesh *mesh, Matrix4 *transform, Color color);
+
+DrawInstance *addInstancedDraw(Mesh *mesh, size_t count);
+
+void submitDraws();
+
+void endRenderFrame();
+
+void createDrawSet(DrawSet *set, size_t capacity);
+
+void setDraw(DrawSet *set, size_t index, Mesh *mesh, Matrix4 *transform, Color color);
+
+void setDrawTransform(DrawSet *set, size_t index, Matrix4 *transform);
+
+size_t addToDrawSet(DrawSet *set, Mesh *mesh, Matrix4 *transform, Color color);
+
+void drawDrawSet(DrawSet *set);
+
+void createCullSet(CullSet *set, size_t capacity, Mesh *lods, float *lodDistances, int lodCount);
+
+void setCullObject(CullSet *set, size_t index, Matrix4 *transform, Color color, float radius);
+
+void setCullObjectTransform(CullSet *set, size_t index, Matrix4 *transform);
+
+size_t addToCullSet(CullSet *set, Matrix4 *transform, Color color, float radius);
+
+void drawCullSet(CullSet *set, Matrix4 *viewProjection, Vector3 cameraPosition);
+
+//=============================================================================================
+// Scenes
+//=============================================================================================
+
+void createScene(Scene *scene, size_t capacity);
+
+size_t addSceneNode(Scene *scene, int32_t parent, Vector3 position, Quaternion rotation, Vector3 scale);
+
+void setSceneNode(Scene *scene, size_t node, Vector3 position, Quaternion rotation, Vector3 scale);
+
+void setSceneNodePosition(Scene *scene, size_t node, Vector3 position);
+
+void attachSceneDraw(Scene *scene, size_t node, DrawSet *set, size_t index);
+
+void attachSceneCullObject(Scene *scene, size_t node, CullSet *set, size_t index);
+
+void updateScene(Scene *scene);
+
+//=============================================================================================
+// Jobs
+//=============================================================================================
+
+void startJobs(int threadCount);
+
+int getJobThreadCount();
+
+void addJob(JobFunction function, void *data, size_t start, size_t end, JobCounter *counter, JobCounter *dependency);
+
+void parallelFor(JobFunction function, void *data, size_t count, size_t grain, JobCounter *counter, JobCounter *dependency);
+
+void waitForJobs(JobCounter *counter);
+
+//=============================================================================================
+// Frames
+//=============================================================================================
+
+void startRenderThread(SDL_Window *window, SDL_GLContext context, FrameFunction render, bool threaded);
+
+void stopRenderThread();
+
+FramePacket *beginFramePacket();
+
+void submitFramePacket(FramePacket *packet);
+
+void *allocatePacketData(FramePacket *packet, size_t size);
+
+DrawInstance *addPacketDraw(FramePacket *packet, Mesh *mesh, size_t count);
+
+void queuePacketDraws(FramePacket *packet);
+
+//=============================================================================================
+// Entities
+//=============================================================================================
+
+void createEntityStore(EntityStore *store, size_t capacity);
+
+uint32_t addEntity(EntityStore *store);
+
+void removeEntity(EntityStore *store, uint32_t id);
+
+size_t getEntitySlot(EntityStore *store, uint32_t id);
+
+void runEntitySystem(EntityStore *store, EntitySystem system, float timeStep);
+
+void moveEntities(EntityStore *store, size_t start, size_t end, float timeStep);
+
+void spinEntities(EntityStore *store, size_t start, size_t end, float timeStep);
+
+void drawEntities(EntityStore *store, Mesh *meshes, int meshCount, FramePacket *packet);
+
+//=============================================================================================
+// Particles
+//=============================================================================================
+
+void createParticleSystem(ParticleSystem *system, size_t count, float startTime);
+
+void updateParticleSystem(ParticleSystem *system, float timeStep);
+
+void drawParticleSystem(ParticleSystem *system, Matrix4 *viewProjection, Vector3 cameraRight, Vector3 cameraUp);
+
 //=============================================================================================
 // Matrices
 //=============================================================================================
 
+void sinCos(float radians, float *sine, float *cosine);
+
+Matrix4 matrixIdentity();
+
 Matrix4 matrixPixelPerfect();
 
 Matrix4 matrixPerspective(float near, float fov);
 
 Matrix4 matrixMultiply(Matrix4 left, Matrix4 right);
 
+void matrixMultiplyTo(Matrix4 *result, const Matrix4 *left, const Matrix4 *right);
+
 void matrixConcat(Matrix4 *left, Matrix4 right);
 
 Matrix4 matrixTranslation(Vector3 v);
@@ -105,10 +539,54 @@ Matrix4 matrixScaleUniform(float s);
 
 Vector3 matrixTransformPoint(Matrix4 transform, Vector3 point);
 
+Quaternion quaternionIdentity();
+
+Quaternion quaternionAxisAngle(Vector3 axis, float radians);
+
+Quaternion quaternionMultiply(Quaternion left, Quaternion right);
+
+Matrix4 matrixTRS(Vector3 translation, Quaternion rotation, Vector3 scale);
+
+Matrix4 matrixLookAt(Vector3 eye, Vector3 target, Vector3 up);
+
+Matrix4 matrixOrbit(float yaw, float pitch, Vector3 offset);
+
+Matrix4 matrixViewPerspective(const Matrix4 *view, float near, float fov);
+
+Vector3 matrixViewPosition(const Matrix4 *view);
+
+Vector3 matrixViewRight(const Matrix4 *view);
+
+Vector3 matrixViewUp(const Matrix4 *view);
+
+void matrixTransformPoints(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count);
+
+void matrixProjectPoints(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count);
+
+void matrixTransformVectors(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count);
+
+void matrixTransformNormals(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count);
+
 //=============================================================================================
 // Modes
 //=============================================================================================
 
-void screensaverCube();
+void updateCube(FramePacket *packet);
+
+void renderCube(FramePacket *packet);
+
+void updateCheckers(FramePacket *packet);
+
+void renderCheckers(FramePacket *packet);
+
+void stopCheckers();
+
+void updateFountain(FramePacket *packet);
+
+void renderFountain(FramePacket *packet);
+
+void updateCubeField(FramePacket *packet);
+
+void renderCubeField(FramePacket *packet);
 
-void screensaverCheckers();
+void createCubeMesh(Mesh *mesh);
@@ -1,26 +1,26 @@
-#include "Common.h"
+#include "common.h"
+
+// What updateCube hands to renderCube:
+typedef struct CubeFrame
+{
+    Matrix4 projectionAndView;
+    Matrix4 cubeTransform;
+} CubeFrame;
 
 static struct cubeGlobals
 {
-	bool started;
+	bool simulationStarted, renderingStarted;
     
-    GLuint program;
-    GLuint uniformProjection;
-    GLuint uniformModelTransform;
-    GLuint uniformModelColor;
-    GLuint uniformAmbientLight;
+    ShaderProgram *litShader, *flatShader;
 
     Mesh cube, plane;
 
     float angle;
 } g;
 
-static void start()
+// A cube from -1 to +1 on each axis, with a different color at each corner.
+void createCubeMesh(Mesh *mesh)
 {
-    //=============================================================================================
-    // Data
-    //=============================================================================================
-
     BasicVertex cubeVertices[] =
     {
         { { -1, -1, -1 }, 0, { 0, 0, 0 }, { 0x00, 0x00, 0x00, 0xFF } },
@@ -43,6 +43,21 @@ static void start()
         2, 3, 7, 2, 7, 6, // top
     };
 
+    createMesh(mesh);
+    setMeshData(mesh, COUNTOF(cubeVertices), cubeVertices, COUNTOF(cubeIndices), cubeIndices);
+}
+
+static void startSimulation()
+{
+    g.angle = 0;
+}
+
+static void startRendering()
+{
+    //=============================================================================================
+    // Data
+    //=============================================================================================
+
     BasicVertex planeVertices[] =
     {
         { { -1, 0, -1 }, 0, { 0, 1, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
@@ -56,42 +71,53 @@ static void start()
         0, 1, 3, 0, 3, 2,
     };
 
-    char *vertexShaderSource = readTextFile("assets/shaders/cube.v.glsl");
-    char *fragmentShaderSource = readTextFile("assets/shaders/cube.f.glsl");
-
     //=============================================================================================
     // GL resources
     //=============================================================================================
 
-    g.program = compileShaderProgram(vertexShaderSource, fragmentShaderSource);
-    g.uniformProjection = glGetUniformLocation(g.program, "uniProjection");
-    g.uniformModelTransform = glGetUniformLocation(g.program, "uniModelTransform");
-    g.uniformModelColor = glGetUniformLocation(g.program, "uniModelColor");
-    g.uniformAmbientLight = glGetUniformLocation(g.program, "uniAmbientLight");
+    g.litShader = requestBasicShader("LIGHTING VERTEX_COLOR");
+    g.flatShader = requestBasicShader("");
 
-    createMesh(&g.cube);
-    setMeshData(&g.cube, COUNTOF(cubeVertices), cubeVertices, COUNTOF(cubeIndices), cubeIndices);
+    createCubeMesh(&g.cube);
     createMesh(&g.plane);
     setMeshData(&g.plane, COUNTOF(planeVertices), planeVertices, COUNTOF(planeIndices), planeIndices);
-
-    //=============================================================================================
-    // Program state
-    //=============================================================================================
-
-    g.angle = 0;
 }
 
-void screensaverCube()
+void updateCube(FramePacket *packet)
 {
-	if (!g.started)
+	if (!g.simulationStarted)
 	{
-		start();
-		g.started = true;
+		startSimulation();
+		g.simulationStarted = true;
 	}
 
     g.angle += FRAME_TIME * 0.1f;
     g.angle = fmodf(g.angle, 2 * PI);
 
+    CubeFrame *frame = allocatePacketData(packet, sizeof(*frame));
+    packet->data = frame;
+
+    // Set up projection:
+    Matrix4 view = matrixOrbit(0, 15 * TO_RADIANS, (Vector3){ 0, -2, -6 });
+    frame->projectionAndView = matrixViewPerspective(&view, 0.1f, 90.0f * TO_RADIANS);
+
+    Quaternion cubeRotation = quaternionMultiply(
+        quaternionAxisAngle((Vector3){ 1, 0, 0 }, g.angle),
+        quaternionAxisAngle((Vector3){ 0, 1, 0 }, 2 * g.angle));
+    frame->cubeTransform = matrixTRS((Vector3){ 0, 2, 0 }, cubeRotation, (Vector3){ 1, 1, 1 });
+}
+
+void renderCube(FramePacket *packet)
+{
+	if (!g.renderingStarted)
+	{
+		startRendering();
+		g.renderingStarted = true;
+	}
+
+    CubeFrame *frame = packet->data;
+    Matrix4 *projectionAndView = &frame->projectionAndView;
+
     glClearColor(0.5f, 0.5f, 0.5f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
@@ -99,49 +125,36 @@ void screensaverCube()
     glStencilFunc(GL_ALWAYS, 0x00, 0x00);
     glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
     glStencilMask(0xFF);
-    glUniform4f(g.uniformModelColor, 1, 1, 1, 1);
-    glUniform1f(g.uniformAmbientLight, 1.0f);
-
-    // Set up projection:
-    glUseProgram(g.program);
-    Matrix4 projectionAndView = matrixMultiply(
-        matrixMultiply(
-            matrixRotationX(15 * TO_RADIANS),
-            matrixTranslationF(0, -2, -6)),
-        matrixPerspective(0.1f, 90.0f * TO_RADIANS));
-    glUniformMatrix4fv(g.uniformProjection, 1, GL_TRUE, projectionAndView.e);
 
     // Draw cube:
-    Matrix4 cubeTransform = matrixMultiply(
-        matrixMultiply(
-            matrixRotationX(g.angle),
-            matrixRotationY(2 * g.angle)),
-        matrixTranslationF(0, 2, 0));
-    glUniformMatrix4fv(g.uniformModelTransform, 1, GL_TRUE, cubeTransform.e);
-    glBindVertexArray(g.cube.vao);
-    glDrawElements(GL_TRIANGLES, (GLsizei)g.cube.primitiveCount, GL_UNSIGNED_SHORT, 0);
+    useShaderProgram(g.litShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, projectionAndView);
+    setUniformColor(UNIFORM_MODEL_COLOR, (Color){ 1, 1, 1, 1 });
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 1.0f);
+    setUniformMatrix4(UNIFORM_MODEL_TRANSFORM, &frame->cubeTransform);
+    drawMesh(&g.cube);
 
     // Draw plane:
-    Matrix4 modelTransform = matrixMultiply(
-        matrixScaleUniform(2),
-        matrixTranslationF(0, 0, 0));
-    glUniformMatrix4fv(g.uniformModelTransform, 1, GL_TRUE, modelTransform.e);
-    glUniform4f(g.uniformModelColor, 0, 0, 0, 1);
-    glBindVertexArray(g.plane.vao);
+    useShaderProgram(g.flatShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, projectionAndView);
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 1.0f);
+    Matrix4 modelTransform = matrixScaleUniform(2);
+    setUniformMatrix4(UNIFORM_MODEL_TRANSFORM, &modelTransform);
+    setUniformColor(UNIFORM_MODEL_COLOR, (Color){ 0, 0, 0, 1 });
     glStencilFunc(GL_ALWAYS, 0xFF, 0xFF);
     glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
     glDepthMask(GL_FALSE);
-    glDrawElements(GL_TRIANGLES, (GLsizei)g.plane.primitiveCount, GL_UNSIGNED_SHORT, 0);
+    drawMesh(&g.plane);
     glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
     glDepthMask(GL_TRUE);
 
     // Draw reflected cube:
+    useShaderProgram(g.litShader);
     glStencilFunc(GL_NOTEQUAL, 0x00, 0xFF);
-    cubeTransform = matrixMultiply(
-        cubeTransform,
+    Matrix4 reflectedTransform = matrixMultiply(
+        frame->cubeTransform,
         matrixScaleF(1, -1, 1));
-    glUniformMatrix4fv(g.uniformModelTransform, 1, GL_TRUE, cubeTransform.e);
-    glUniform4f(g.uniformModelColor, 0.3f, 0.3f, 0.3f, 1.0f);
-    glBindVertexArray(g.cube.vao);
-    glDrawElements(GL_TRIANGLES, (GLsizei)g.cube.primitiveCount, GL_UNSIGNED_SHORT, 0);
+    setUniformMatrix4(UNIFORM_MODEL_TRANSFORM, &reflectedTransform);
+    setUniformColor(UNIFORM_MODEL_COLOR, (Color){ 0.3f, 0.3f, 0.3f, 1.0f });
+    drawMesh(&g.cube);
 }
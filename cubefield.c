@@ -0,0 +1,159 @@
+#include "common.h"
+
+#define CUBE_COUNT 100000
+// Half the size of the box the cubes drift around in:
+#define FIELD_SIZE 50.0f
+// How often to report how long the CPU spends on each frame:
+#define REPORT_FRAMES 600
+
+// What updateCubeField hands to renderCubeField, besides the draws:
+typedef struct CubeFieldFrame
+{
+    Matrix4 projectionAndView;
+} CubeFieldFrame;
+
+static struct cubeFieldGlobals
+{
+    bool simulationStarted, renderingStarted;
+
+    ShaderProgram *shader;
+
+    Mesh cube;
+    EntityStore cubes;
+
+    float angle;
+    uint32_t random;
+
+    // Simulation time, which does not include anything the render thread does:
+    uint64_t cpuTime;
+    int frames;
+} g;
+
+// A number from 0 to 1, from a xorshift generator:
+static float random01()
+{
+    g.random ^= g.random << 13;
+    g.random ^= g.random >> 17;
+    g.random ^= g.random << 5;
+    return (g.random >> 8) / 16777216.0f;
+}
+
+static float randomRange(float low, float high)
+{
+    return low + (high - low) * random01();
+}
+
+// Cubes that drift out of the box come back in on the other side:
+static void wrapEntities(EntityStore *store, size_t start, size_t end, float timeStep)
+{
+    UNUSED(timeStep);
+    Vector3 *positions = store->positions;
+    for (size_t i = start; i < end; i++)
+    {
+        float *p = &positions[i].x;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (p[axis] > FIELD_SIZE)
+            {
+                p[axis] -= 2 * FIELD_SIZE;
+            }
+            else if (p[axis] < -FIELD_SIZE)
+            {
+                p[axis] += 2 * FIELD_SIZE;
+            }
+        }
+    }
+}
+
+static void startRendering()
+{
+    g.shader = requestBasicShader("VERTEX_COLOR INSTANCED");
+    createCubeMesh(&g.cube);
+}
+
+static void startSimulation()
+{
+    g.angle = 0;
+    g.random = 0x9E3779B9;
+
+    // Every cube spins about its own axis at its own rate, and drifts slowly:
+    createEntityStore(&g.cubes, CUBE_COUNT);
+    for (int i = 0; i < CUBE_COUNT; i++)
+    {
+        size_t slot = getEntitySlot(&g.cubes, addEntity(&g.cubes));
+        g.cubes.positions[slot] = (Vector3){
+            randomRange(-FIELD_SIZE, FIELD_SIZE),
+            randomRange(-FIELD_SIZE, FIELD_SIZE),
+            randomRange(-FIELD_SIZE, FIELD_SIZE),
+        };
+        g.cubes.scales[slot] = randomRange(0.2f, 0.5f);
+        g.cubes.velocities[slot] = (Vector3){ randomRange(-0.5f, 0.5f), randomRange(-0.5f, 0.5f), randomRange(-0.5f, 0.5f) };
+
+        Vector3 axis = { randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1) };
+        float length = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z) + 1e-6f;
+        float rate = randomRange(0.5f, 3.0f) / length;
+        g.cubes.spins[slot] = (Vector3){ axis.x * rate, axis.y * rate, axis.z * rate };
+
+        float shade = randomRange(0.5f, 1.0f);
+        g.cubes.colors[slot] = (Color){ shade, shade, shade, 1 };
+    }
+}
+
+void updateCubeField(FramePacket *packet)
+{
+    if (!g.simulationStarted)
+    {
+        startSimulation();
+        g.simulationStarted = true;
+    }
+
+    uint64_t startTime = SDL_GetPerformanceCounter();
+
+    g.angle += FRAME_TIME * 0.05f;
+    g.angle = fmodf(g.angle, 2 * PI);
+
+    runEntitySystem(&g.cubes, moveEntities, FRAME_TIME);
+    runEntitySystem(&g.cubes, wrapEntities, FRAME_TIME);
+    runEntitySystem(&g.cubes, spinEntities, FRAME_TIME);
+
+    CubeFieldFrame *frame = allocatePacketData(packet, sizeof(*frame));
+    packet->data = frame;
+
+    // Set up projection:
+    Matrix4 view = matrixOrbit(g.angle, 20 * TO_RADIANS, (Vector3){ 0, 0, -2.5f * FIELD_SIZE });
+    frame->projectionAndView = matrixViewPerspective(&view, 0.1f, 70.0f * TO_RADIANS);
+
+    // The mesh is only created once the render thread gets to it, but it stays in the same place:
+    drawEntities(&g.cubes, &g.cube, 1, packet);
+
+    // The time to update everything and fill in the packet, for the GL log:
+    g.cpuTime += SDL_GetPerformanceCounter() - startTime;
+    if (DEBUG_GRAPHICS && ++g.frames == REPORT_FRAMES)
+    {
+        double milliseconds = 1000.0 * g.cpuTime / SDL_GetPerformanceFrequency() / g.frames;
+        fprintf(GLLog, "cube field: %d cubes, %.2f ms of CPU time per frame\n", (int)g.cubes.count, milliseconds);
+        fflush(GLLog);
+        g.cpuTime = 0;
+        g.frames = 0;
+    }
+}
+
+void renderCubeField(FramePacket *packet)
+{
+    if (!g.renderingStarted)
+    {
+        startRendering();
+        g.renderingStarted = true;
+    }
+
+    CubeFieldFrame *frame = packet->data;
+
+    glClearColor(0.1f, 0.1f, 0.12f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    useShaderProgram(g.shader);
+    setUniformMatrix4(UNIFORM_PROJECTION, &frame->projectionAndView);
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 1.0f);
+    queuePacketDraws(packet);
+    submitDraws();
+}
@@ -0,0 +1,251 @@
+#include "common.h"
+#include <string.h>
+
+// Marks the end of the free ID list:
+#define NO_ENTITY UINT32_MAX
+
+// How many different meshes drawEntities can draw in one call:
+#define MAX_ENTITY_MESHES 16
+// Entities per job:
+#define ENTITY_BATCH 4096
+
+// A system and its arguments, for the jobs that run it:
+typedef struct SystemRun
+{
+    EntityStore *store;
+    EntitySystem system;
+    float timeStep;
+} SystemRun;
+
+// Where each batch of entities writes its instances for each mesh; see drawEntities:
+typedef struct EntityDraw
+{
+    EntityStore *store;
+    DrawInstance **cursors;
+} EntityDraw;
+
+static struct entityGlobals
+{
+    // For drawEntities, per batch and mesh:
+    size_t *drawCounts;
+    DrawInstance **drawCursors;
+    size_t drawCapacity;
+} g;
+
+//=============================================================================================
+// Entity stores
+//=============================================================================================
+
+// Every component of every entity is in a plain array, so that a system touches only the
+// components it needs, one after another. Removing an entity moves the last one into its slot to
+// keep the arrays dense; an entity's ID stays the same wherever it moves.
+void createEntityStore(EntityStore *store, size_t capacity)
+{
+    check(capacity < NO_ENTITY, "entity store is too big");
+    memset(store, 0, sizeof(*store));
+    store->capacity = capacity;
+    store->positions = xalloc(capacity * sizeof(store->positions[0]));
+    store->orientations = xalloc(capacity * sizeof(store->orientations[0]));
+    store->scales = xalloc(capacity * sizeof(store->scales[0]));
+    store->velocities = xalloc(capacity * sizeof(store->velocities[0]));
+    store->spins = xalloc(capacity * sizeof(store->spins[0]));
+    store->colors = xalloc(capacity * sizeof(store->colors[0]));
+    store->meshes = xalloc(capacity * sizeof(store->meshes[0]));
+    store->ids = xalloc(capacity * sizeof(store->ids[0]));
+    store->slots = xalloc(capacity * sizeof(store->slots[0]));
+
+    // All of the IDs start out free:
+    for (size_t id = 0; id < capacity; id++)
+    {
+        store->slots[id] = (id + 1 < capacity) ? (uint32_t)(id + 1) : NO_ENTITY;
+    }
+    store->firstFree = (capacity > 0) ? 0 : NO_ENTITY;
+}
+
+// Adds an entity at the origin, at rest, white, and drawn with the first mesh. Returns its ID.
+uint32_t addEntity(EntityStore *store)
+{
+    check(store->firstFree != NO_ENTITY, "entity store is full");
+    uint32_t id = store->firstFree;
+    store->firstFree = store->slots[id];
+
+    size_t slot = store->count++;
+    store->ids[slot] = id;
+    store->slots[id] = (uint32_t)slot;
+
+    store->positions[slot] = (Vector3){ 0, 0, 0 };
+    store->orientations[slot] = quaternionIdentity();
+    store->scales[slot] = 1;
+    store->velocities[slot] = (Vector3){ 0, 0, 0 };
+    store->spins[slot] = (Vector3){ 0, 0, 0 };
+    store->colors[slot] = (Color){ 1, 1, 1, 1 };
+    store->meshes[slot] = 0;
+    return id;
+}
+
+// Where an entity's components are, until the next removeEntity.
+size_t getEntitySlot(EntityStore *store, uint32_t id)
+{
+    check(id < store->capacity, "no such entity");
+    size_t slot = store->slots[id];
+    check(slot < store->count && store->ids[slot] == id, "no such entity");
+    return slot;
+}
+
+void removeEntity(EntityStore *store, uint32_t id)
+{
+    size_t slot = getEntitySlot(store, id);
+    size_t last = --store->count;
+    if (slot != last)
+    {
+        store->positions[slot] = store->positions[last];
+        store->orientations[slot] = store->orientations[last];
+        store->scales[slot] = store->scales[last];
+        store->velocities[slot] = store->velocities[last];
+        store->spins[slot] = store->spins[last];
+        store->colors[slot] = store->colors[last];
+        store->meshes[slot] = store->meshes[last];
+        store->ids[slot] = store->ids[last];
+        store->slots[store->ids[slot]] = (uint32_t)slot;
+    }
+
+    store->slots[id] = store->firstFree;
+    store->firstFree = id;
+}
+
+//=============================================================================================
+// Systems
+//=============================================================================================
+
+static void runSystemJob(void *data, size_t start, size_t end)
+{
+    SystemRun *run = data;
+    run->system(run->store, start, end, run->timeStep);
+}
+
+// Runs a system over every entity in the store, split across the job threads, and waits for it
+// to finish. A system must only touch the entities in the range it is given.
+void runEntitySystem(EntityStore *store, EntitySystem system, float timeStep)
+{
+    if (store->count <= ENTITY_BATCH)
+    {
+        system(store, 0, store->count, timeStep);
+        return;
+    }
+
+    SystemRun run = { store, system, timeStep };
+    JobCounter done = { 0 };
+    parallelFor(runSystemJob, &run, store->count, ENTITY_BATCH, &done, NULL);
+    waitForJobs(&done);
+}
+
+void moveEntities(EntityStore *store, size_t start, size_t end, float timeStep)
+{
+    Vector3 *positions = store->positions;
+    Vector3 *velocities = store->velocities;
+    for (size_t i = start; i < end; i++)
+    {
+        positions[i].x += velocities[i].x * timeStep;
+        positions[i].y += velocities[i].y * timeStep;
+        positions[i].z += velocities[i].z * timeStep;
+    }
+}
+
+// Turns each entity about its spin axis, which is in world space.
+void spinEntities(EntityStore *store, size_t start, size_t end, float timeStep)
+{
+    Quaternion *orientations = store->orientations;
+    Vector3 *spins = store->spins;
+    for (size_t i = start; i < end; i++)
+    {
+        // q += (spin * q) * timeStep / 2, then back to unit length. Good enough for small steps,
+        // and no trigonometry:
+        Quaternion q = orientations[i];
+        float h = timeStep / 2;
+        Vector3 s = { spins[i].x * h, spins[i].y * h, spins[i].z * h };
+        Quaternion r = {
+            q.x + s.x * q.w + s.y * q.z - s.z * q.y,
+            q.y + s.y * q.w + s.z * q.x - s.x * q.z,
+            q.z + s.z * q.w + s.x * q.y - s.y * q.x,
+            q.w - s.x * q.x - s.y * q.y - s.z * q.z,
+        };
+        float scale = 1 / sqrtf(r.x * r.x + r.y * r.y + r.z * r.z + r.w * r.w);
+        orientations[i] = (Quaternion){ r.x * scale, r.y * scale, r.z * scale, r.w * scale };
+    }
+}
+
+//=============================================================================================
+// Drawing
+//=============================================================================================
+
+static void fillInstancesJob(void *data, size_t start, size_t end)
+{
+    EntityDraw *draw = data;
+    EntityStore *store = draw->store;
+    for (size_t batch = start; batch < end; batch++)
+    {
+        DrawInstance **cursors = &draw->cursors[batch * MAX_ENTITY_MESHES];
+        size_t last = (batch + 1) * ENTITY_BATCH;
+        last = (last < store->count) ? last : store->count;
+        for (size_t i = batch * ENTITY_BATCH; i < last; i++)
+        {
+            float scale = store->scales[i];
+            DrawInstance *instance = cursors[store->meshes[i]]++;
+            instance->transform = matrixTRS(store->positions[i], store->orientations[i], (Vector3){ scale, scale, scale });
+            instance->color = store->colors[i];
+        }
+    }
+}
+
+// Records every entity in the packet, with one instanced draw per mesh. The program that draws
+// them must be a variant built with INSTANCED.
+void drawEntities(EntityStore *store, Mesh *meshes, int meshCount, FramePacket *packet)
+{
+    check(meshCount <= MAX_ENTITY_MESHES, "too many entity meshes");
+
+    // Count each batch's entities per mesh, as the place where the next batch starts:
+    size_t batches = (store->count + ENTITY_BATCH - 1) / ENTITY_BATCH;
+    size_t cursorCount = (batches + 1) * MAX_ENTITY_MESHES;
+    if (g.drawCapacity < cursorCount)
+    {
+        free(g.drawCounts);
+        free(g.drawCursors);
+        g.drawCounts = xalloc(cursorCount * sizeof(g.drawCounts[0]));
+        g.drawCursors = xalloc(cursorCount * sizeof(g.drawCursors[0]));
+        g.drawCapacity = cursorCount;
+    }
+    size_t *counts = g.drawCounts;
+    memset(counts, 0, cursorCount * sizeof(counts[0]));
+    for (size_t i = 0; i < store->count; i++)
+    {
+        check(store->meshes[i] < meshCount, "entity has no mesh");
+        counts[(i / ENTITY_BATCH + 1) * MAX_ENTITY_MESHES + store->meshes[i]]++;
+    }
+    for (size_t batch = 1; batch <= batches; batch++)
+    {
+        for (int m = 0; m < meshCount; m++)
+        {
+            counts[batch * MAX_ENTITY_MESHES + m] += counts[(batch - 1) * MAX_ENTITY_MESHES + m];
+        }
+    }
+
+    for (int m = 0; m < meshCount; m++)
+    {
+        size_t total = counts[batches * MAX_ENTITY_MESHES + m];
+        if (total == 0)
+        {
+            continue;
+        }
+        DrawInstance *instances = addPacketDraw(packet, &meshes[m], total);
+        for (size_t batch = 0; batch < batches; batch++)
+        {
+            g.drawCursors[batch * MAX_ENTITY_MESHES + m] = instances + counts[batch * MAX_ENTITY_MESHES + m];
+        }
+    }
+
+    // Each batch of entities fills in its own part of the packet's instances:
+    EntityDraw draw = { store, g.drawCursors };
+    JobCounter done = { 0 };
+    parallelFor(fillInstancesJob, &draw, batches, 1, &done, NULL);
+    waitForJobs(&done);
+}
@@ -0,0 +1,127 @@
+#include "common.h"
+
+#define PARTICLE_COUNT 262144
+#define PARTICLE_LIFETIME 3.0f
+
+// What updateFountain hands to renderFountain:
+typedef struct FountainFrame
+{
+    Matrix4 projectionAndView;
+    Vector3 cameraRight, cameraUp;
+    ParticleAttractor wind;
+} FountainFrame;
+
+static struct fountainGlobals
+{
+    bool simulationStarted, renderingStarted;
+
+    ShaderProgram *flatShader;
+
+    Mesh plane;
+    ParticleSystem particles;
+
+    float angle;
+    float time;
+} g;
+
+static void startSimulation()
+{
+    g.angle = 0;
+    g.time = 0;
+}
+
+static void startRendering()
+{
+    //=============================================================================================
+    // Data
+    //=============================================================================================
+
+    BasicVertex planeVertices[] =
+    {
+        { { -1, 0, -1 }, 0, { 0, 1, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { +1, 0, -1 }, 0, { 0, 1, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { -1, 0, +1 }, 0, { 0, 1, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+        { { +1, 0, +1 }, 0, { 0, 1, 0 }, { 0xFF, 0xFF, 0xFF, 0xFF } },
+    };
+
+    uint16_t planeIndices[] =
+    {
+        0, 1, 3, 0, 3, 2,
+    };
+
+    //=============================================================================================
+    // GL resources
+    //=============================================================================================
+
+    g.flatShader = requestBasicShader("");
+
+    createMesh(&g.plane);
+    setMeshData(&g.plane, COUNTOF(planeVertices), planeVertices, COUNTOF(planeIndices), planeIndices);
+
+    createParticleSystem(&g.particles, PARTICLE_COUNT, PARTICLE_LIFETIME);
+
+    // A tall jet of water in the middle, and a wide spray around its base:
+    ParticleSystem *p = &g.particles;
+    p->emitters[0] = (ParticleEmitter){ { 0, 0, 0 }, 0.05f, { 0, 7, 0 }, 0.6f, { 0.3f, 0.5f, 1.0f, 0.15f }, PARTICLE_LIFETIME, 3 };
+    p->emitters[1] = (ParticleEmitter){ { 0, 0.1f, 0 }, 0.3f, { 0, 2, 0 }, 2.0f, { 0.7f, 0.8f, 1.0f, 0.1f }, PARTICLE_LIFETIME / 2, 1 };
+    p->emitterCount = 2;
+    p->gravity = (Vector3){ 0, -4, 0 };
+    p->drag = 0.2f;
+    p->attractorCount = 1;
+    p->size = 0.04f;
+}
+
+void updateFountain(FramePacket *packet)
+{
+    if (!g.simulationStarted)
+    {
+        startSimulation();
+        g.simulationStarted = true;
+    }
+
+    g.angle += FRAME_TIME * 0.05f;
+    g.angle = fmodf(g.angle, 2 * PI);
+    g.time += FRAME_TIME;
+
+    FountainFrame *frame = allocatePacketData(packet, sizeof(*frame));
+    packet->data = frame;
+
+    // A wind that circles the fountain and bends the jet with it:
+    float windAngle = 0.3f * g.time;
+    frame->wind = (ParticleAttractor){ { 3 * cosf(windAngle), 4, 3 * sinf(windAngle) }, 2.0f };
+
+    // Set up projection:
+    Matrix4 view = matrixOrbit(g.angle, 15 * TO_RADIANS, (Vector3){ 0, -3, -9 });
+    frame->projectionAndView = matrixViewPerspective(&view, 0.1f, 90.0f * TO_RADIANS);
+    frame->cameraRight = matrixViewRight(&view);
+    frame->cameraUp = matrixViewUp(&view);
+}
+
+void renderFountain(FramePacket *packet)
+{
+    if (!g.renderingStarted)
+    {
+        startRendering();
+        g.renderingStarted = true;
+    }
+
+    FountainFrame *frame = packet->data;
+
+    // The particles only live on the GPU, so they are stepped here rather than in updateFountain:
+    g.particles.attractors[0] = frame->wind;
+    updateParticleSystem(&g.particles, FRAME_TIME);
+
+    glClearColor(0.02f, 0.02f, 0.05f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Draw the ground:
+    useShaderProgram(g.flatShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, &frame->projectionAndView);
+    setUniformFloat(UNIFORM_AMBIENT_LIGHT, 1.0f);
+    Matrix4 groundTransform = matrixScaleUniform(6);
+    setUniformMatrix4(UNIFORM_MODEL_TRANSFORM, &groundTransform);
+    setUniformColor(UNIFORM_MODEL_COLOR, (Color){ 0.05f, 0.06f, 0.08f, 1 });
+    drawMesh(&g.plane);
+
+    drawParticleSystem(&g.particles, &frame->projectionAndView, frame->cameraRight, frame->cameraUp);
+}
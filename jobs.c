@@ -0,0 +1,316 @@
+#include "common.h"
+#include <string.h>
+
+// Jobs that one thread's queue can hold; a job added to a full queue runs right away instead:
+#define JOB_QUEUE_SIZE 4096
+#define MAX_JOB_THREADS 64
+// Jobs that can be waiting on dependencies at once:
+#define MAX_DEFERRED_JOBS 1024
+// Times a waiting thread looks for work before it yields the CPU:
+#define JOB_SPINS 64
+// Set in a counter's pending count while jobs are waiting on it as a dependency:
+#define HAS_DEPENDENTS 0x40000000
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+typedef struct Job
+{
+    JobFunction function;
+    void *data;
+    size_t start, end;
+    JobCounter *counter;
+    JobCounter *dependency;
+} Job;
+
+// A double-ended queue of jobs. Its thread adds and takes jobs at the bottom, where they are most
+// likely to still be in its cache, and other threads steal from the top. Jobs are coarse enough
+// that a spin lock costs nothing measurable here.
+typedef struct JobQueue
+{
+    SDL_SpinLock lock;
+    size_t top, bottom;
+    Job jobs[JOB_QUEUE_SIZE];
+} JobQueue;
+
+static struct jobGlobals
+{
+    bool started;
+
+    // One queue per thread; the main thread has the first:
+    JobQueue *queues[MAX_JOB_THREADS];
+    int threadCount;
+
+    // Workers that found nothing to do wait for this:
+    SDL_sem *wake;
+    SDL_atomic_t sleepers;
+
+    SDL_SpinLock deferredLock;
+    Job deferred[MAX_DEFERRED_JOBS];
+    int deferredCount;
+} g;
+
+// The queue of the thread that is running. Threads outside of the pool share the main thread's:
+static THREAD_LOCAL int CurrentQueue;
+
+//=============================================================================================
+// Queues
+//=============================================================================================
+
+static bool pushJob(JobQueue *queue, Job *job)
+{
+    SDL_AtomicLock(&queue->lock);
+    bool pushed = queue->bottom - queue->top < JOB_QUEUE_SIZE;
+    if (pushed)
+    {
+        queue->jobs[queue->bottom++ % JOB_QUEUE_SIZE] = *job;
+    }
+    SDL_AtomicUnlock(&queue->lock);
+    return pushed;
+}
+
+static bool popJob(JobQueue *queue, Job *job)
+{
+    SDL_AtomicLock(&queue->lock);
+    bool popped = queue->bottom > queue->top;
+    if (popped)
+    {
+        *job = queue->jobs[--queue->bottom % JOB_QUEUE_SIZE];
+    }
+    SDL_AtomicUnlock(&queue->lock);
+    return popped;
+}
+
+static bool stealJob(JobQueue *queue, Job *job)
+{
+    SDL_AtomicLock(&queue->lock);
+    bool stolen = queue->bottom > queue->top;
+    if (stolen)
+    {
+        *job = queue->jobs[queue->top++ % JOB_QUEUE_SIZE];
+    }
+    SDL_AtomicUnlock(&queue->lock);
+    return stolen;
+}
+
+//=============================================================================================
+// Running jobs
+//=============================================================================================
+
+static void queueJob(Job *job);
+
+static void finishJob(Job *job)
+{
+    JobCounter *counter = job->counter;
+    if (!counter || SDL_AtomicAdd(&counter->pending, -1) != (HAS_DEPENDENTS | 1))
+    {
+        return;
+    }
+
+    // That was the last one, so the jobs that were waiting for it can go. The counter is not
+    // clear until they have been found, so whoever waits on it cannot reuse it too early. They are
+    // queued outside of the lock, because a full queue runs them on the spot:
+    for (;;)
+    {
+        Job ready;
+        bool found = false;
+        SDL_AtomicLock(&g.deferredLock);
+        for (int i = 0; i < g.deferredCount && !found; i++)
+        {
+            if (g.deferred[i].dependency == counter)
+            {
+                ready = g.deferred[i];
+                g.deferred[i] = g.deferred[--g.deferredCount];
+                found = true;
+            }
+        }
+        SDL_AtomicUnlock(&g.deferredLock);
+        if (!found)
+        {
+            break;
+        }
+        ready.dependency = NULL;
+        queueJob(&ready);
+    }
+    SDL_AtomicAdd(&counter->pending, -HAS_DEPENDENTS);
+}
+
+static void runJob(Job *job)
+{
+    job->function(job->data, job->start, job->end);
+    finishJob(job);
+}
+
+// Runs one job from this thread's queue, or failing that, one stolen from another thread.
+static bool runOneJob()
+{
+    Job job;
+    int self = CurrentQueue;
+    bool found = popJob(g.queues[self], &job);
+    for (int i = 1; i < g.threadCount && !found; i++)
+    {
+        found = stealJob(g.queues[(self + i) % g.threadCount], &job);
+    }
+    if (found)
+    {
+        runJob(&job);
+    }
+    return found;
+}
+
+static void queueJob(Job *job)
+{
+    if (!pushJob(g.queues[CurrentQueue], job))
+    {
+        runJob(job);
+        return;
+    }
+
+    // The read has to be a full barrier, so that a worker that is about to sleep either sees the
+    // job or is counted here:
+    if (SDL_AtomicAdd(&g.sleepers, 0) > 0)
+    {
+        SDL_SemPost(g.wake);
+    }
+}
+
+static int runWorker(void *data)
+{
+    CurrentQueue = (int)(intptr_t)data;
+    for (;;)
+    {
+        if (runOneJob())
+        {
+            continue;
+        }
+
+        // Look once more after saying that this thread is going to sleep:
+        SDL_AtomicAdd(&g.sleepers, 1);
+        if (!runOneJob())
+        {
+            SDL_SemWait(g.wake);
+        }
+        SDL_AtomicAdd(&g.sleepers, -1);
+    }
+    return 0;
+}
+
+//=============================================================================================
+// Jobs
+//=============================================================================================
+
+// Starts the worker threads. With a thread count of zero or less, there is one thread per CPU,
+// counting the main thread, which runs jobs while it waits for them.
+void startJobs(int threadCount)
+{
+    check(!g.started, "jobs are already started");
+    g.started = true;
+
+    if (threadCount <= 0)
+    {
+        threadCount = SDL_GetCPUCount();
+    }
+    threadCount = (threadCount < 1) ? 1 : (threadCount > MAX_JOB_THREADS) ? MAX_JOB_THREADS : threadCount;
+    g.threadCount = threadCount;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        g.queues[i] = xalloc(sizeof(JobQueue));
+    }
+    g.wake = SDL_CreateSemaphore(0);
+    check(g.wake != NULL, "SDL_CreateSemaphore");
+    for (int i = 1; i < threadCount; i++)
+    {
+        SDL_Thread *thread = SDL_CreateThread(runWorker, "job worker", (void *)(intptr_t)i);
+        check(thread != NULL, "SDL_CreateThread");
+        SDL_DetachThread(thread);
+    }
+}
+
+// Counting the main thread:
+int getJobThreadCount()
+{
+    return g.threadCount;
+}
+
+// Queues a call to `function` for the items [start, end) of `data`. The job is counted against
+// `counter`, if there is one, until it finishes. If `dependency` is given, the job does not start
+// until every job counted against it has finished.
+void addJob(JobFunction function, void *data, size_t start, size_t end, JobCounter *counter, JobCounter *dependency)
+{
+    check(g.started, "startJobs must be called before addJob");
+    Job job = { function, data, start, end, counter, dependency };
+    if (counter)
+    {
+        SDL_AtomicAdd(&counter->pending, 1);
+    }
+
+    if (dependency)
+    {
+        // Either the dependency's last job sees the flag and looks for this one in the list, or
+        // it has already finished:
+        SDL_AtomicLock(&g.deferredLock);
+        bool waiting = false;
+        for (;;)
+        {
+            int pending = SDL_AtomicGet(&dependency->pending);
+            if ((pending & ~HAS_DEPENDENTS) == 0)
+            {
+                break;
+            }
+            if (SDL_AtomicCAS(&dependency->pending, pending, pending | HAS_DEPENDENTS))
+            {
+                waiting = true;
+                break;
+            }
+        }
+        if (waiting)
+        {
+            check(g.deferredCount < MAX_DEFERRED_JOBS, "too many jobs waiting on dependencies");
+            g.deferred[g.deferredCount++] = job;
+        }
+        SDL_AtomicUnlock(&g.deferredLock);
+        if (waiting)
+        {
+            return;
+        }
+        job.dependency = NULL;
+    }
+
+    queueJob(&job);
+}
+
+// Splits the items [0, count) of `data` into jobs of at least `grain` items each, with a few jobs
+// per thread so that threads that finish early can steal the rest.
+void parallelFor(JobFunction function, void *data, size_t count, size_t grain, JobCounter *counter, JobCounter *dependency)
+{
+    size_t size = count / (4 * (size_t)g.threadCount) + 1;
+    size = (size < grain) ? grain : size;
+    for (size_t start = 0; start < count; start += size)
+    {
+        size_t end = (count - start < size) ? count : start + size;
+        addJob(function, data, start, end, counter, dependency);
+    }
+}
+
+// Runs jobs until every job counted against `counter` has finished.
+void waitForJobs(JobCounter *counter)
+{
+    int misses = 0;
+    while (SDL_AtomicGet(&counter->pending) > 0)
+    {
+        if (runOneJob())
+        {
+            misses = 0;
+        }
+        else if (++misses >= JOB_SPINS)
+        {
+            // The rest are running on other threads:
+            SDL_Delay(0);
+            misses = 0;
+        }
+    }
+}
@@ -1,11 +1,11 @@
-#include "Common.h"
+#include "common.h"
 #include <stdio.h>
 #include <string.h>
 
 #pragma comment(lib, "SDL2main")
 #pragma comment(lib, "SDL2")
 
-static FILE *GLLog;
+FILE *GLLog;
 
 //=============================================================================================
 // Basics
@@ -27,258 +27,66 @@ void *xalloc(size_t size)
     return p;
 }
 
-char *readTextFile(char *path)
+// Returns NULL if the file cannot be read. The contents are followed by a NUL byte.
+char *tryReadFile(char *path, size_t *size)
 {
     FILE *f = fopen(path, "rb");
-    if (fseek(f, 0, SEEK_END) != 0)
-    {
-        fprintf(stderr, "error: cannot read file: %s\n", path);
-        exit(1);
-    }
-    long len = ftell(f);
-    check(len >= 0, "ftell");
-    check(fseek(f, 0, SEEK_SET) == 0, "fseek");
-    char *text = xalloc(len + 1);
-    check(fread(text, len, 1, f) == 1, "fread");
-    text[len] = '\0';
-    return text;
-}
-
-//=============================================================================================
-// GL
-//=============================================================================================
-
-void printShaderLog(
-    GLuint object, char *label,
-    GLPROC_glGetShaderiv get, GLenum status,
-    GLPROC_glGetShaderInfoLog getLog)
-{
-    GLint success;
-    get(object, status, &success);
-    if (!success)
+    if (!f)
     {
-        fprintf(GLLog, "compiled/linked %s: FAILED\n", label);
+        return NULL;
     }
 
-    static char errors[4096];
-    GLsizei length;
-    getLog(object, sizeof(errors), &length, errors);
-    if (length > 0)
+    char *text = NULL;
+    long len;
+    if (fseek(f, 0, SEEK_END) == 0 &&
+        (len = ftell(f)) >= 0 &&
+        fseek(f, 0, SEEK_SET) == 0)
     {
-        fprintf(GLLog, "%s: %s\n\n", label, errors);
-    }
-
-    fflush(GLLog);
-    check(success, "compiling shader/program");
-}
-
-GLuint compileShader(GLenum type, char *label, const char *source)
-{
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-    printShaderLog(shader, label, glGetShaderiv, GL_COMPILE_STATUS, glGetShaderInfoLog);
-    return shader;
-}
-
-GLuint linkShaderProgram(GLuint vertexShader, GLuint fragmentShader)
-{
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    printShaderLog(program, "program", glGetProgramiv, GL_LINK_STATUS, glGetProgramInfoLog);
-
-    glValidateProgram(program);
-    printShaderLog(program, "program validation", glGetProgramiv, GL_VALIDATE_STATUS, glGetProgramInfoLog);
-
-    glDetachShader(program, vertexShader);
-    glDeleteShader(vertexShader);
-    glDetachShader(program, fragmentShader);
-    glDeleteShader(fragmentShader);
-
-    return program;
-}
-
-GLuint compileShaderProgram(char *vertexShaderSource, char *fragmentShaderSource)
-{
-    GLuint vs = compileShader(GL_VERTEX_SHADER, "vertex shader", vertexShaderSource);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, "fragment shader", fragmentShaderSource);
-    return linkShaderProgram(vs, fs);
-}
-
-void createMesh(Mesh *mesh)
-{
-    memset(mesh, 0, sizeof(*mesh));
-
-    glGenVertexArrays(1, &mesh->vao);
-    glBindVertexArray(mesh->vao);
-
-    glGenBuffers(1, &mesh->vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-
-    glGenBuffers(1, &mesh->indexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-
-    // Vertex layout:
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, position));
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, normal));
-    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, color));
-
-    mesh->primitiveCount = 0;
-}
-
-void setMeshData(
-    Mesh *mesh,
-    size_t vertexCount, BasicVertex *vertexData,
-    size_t indexCount, uint16_t *indexData)
-{
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(vertexData[0]), vertexData, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(indexData[0]), indexData, GL_STATIC_DRAW);
-    mesh->primitiveCount = indexCount;
-}
-
-//=============================================================================================
-// Matrices (4x4)
-//=============================================================================================
-
-float *matrixElement(Matrix4 *matrix, int row, int column)
-{
-    return matrix->e + column * 4 + row;
-}
-
-Matrix4 matrixMultiply(Matrix4 left, Matrix4 right)
-{
-    Matrix4 m;
-    for (int col = 0; col < 4; col++)
-    {
-        for (int row = 0; row < 4; row++)
+        text = xalloc(len + 1);
+        if (len > 0 && fread(text, len, 1, f) != 1)
         {
-            float elem = 0;
-            for (int i = 0; i < 4; i++)
-            {
-                elem += *matrixElement(&left, row, i) * *matrixElement(&right, i, col);
-            }
-            *matrixElement(&m, row, col) = elem;
+            free(text);
+            text = NULL;
         }
+        *size = len;
     }
-    return m;
-}
 
-void matrixConcat(Matrix4 *left, Matrix4 right)
-{
-    *left = matrixMultiply(*left, right);
-}
-
-Matrix4 matrixPixelPerfect()
-{
-    Matrix4 m = {
-        2.0f / WINDOW_WIDTH, 0, 0, -1,
-        0, 2.0f / WINDOW_HEIGHT, 0, -1,
-        0, 0, -0.001f, 0,
-        0, 0, 0, 1,
-    };
-    return m;
-}
-
-Matrix4 matrixPerspective(float near, float fov)
-{
-    float e = 1 / (float)tan(fov / 2);
-    float a = (float)WINDOW_HEIGHT / WINDOW_WIDTH;
-    Matrix4 m = {
-        e, 0, 0, 0,
-        0, e / a, 0, 0,
-        0, 0, -1, -2 * near,
-        0, 0, -1, 0,
-    };
-    return m;
-}
-
-Matrix4 matrixTranslation(Vector3 v)
-{
-    Matrix4 m = {
-        1, 0, 0, v.x,
-        0, 1, 0, v.y,
-        0, 0, 1, v.z,
-        0, 0, 0, 1,
-    };
-    return m;
-}
-
-Matrix4 matrixTranslationF(float x, float y, float z)
-{
-    return matrixTranslation((Vector3){ x, y, z });
-}
-
-Matrix4 matrixRotationX(float radians)
-{
-    float sinx = (float)sin(radians);
-    float cosx = (float)cos(radians);
-    Matrix4 m = {
-        1, 0, 0, 0,
-        0, cosx, -sinx, 0,
-        0, sinx, cosx, 0,
-        0, 0, 0, 1,
-    };
-    return m;
-}
-
-Matrix4 matrixRotationY(float radians)
-{
-    float sinx = (float)sin(radians);
-    float cosx = (float)cos(radians);
-    Matrix4 m = {
-        cosx, 0, sinx, 0,
-        0, 1, 0, 0,
-        -sinx, 0, cosx, 0,
-        0, 0, 0, 1,
-    };
-    return m;
+    fclose(f);
+    return text;
 }
 
-Matrix4 matrixRotationZ(float radians)
+char *tryReadTextFile(char *path)
 {
-    float sinx = (float)sin(radians);
-    float cosx = (float)cos(radians);
-    Matrix4 m = {
-        cosx, -sinx, 0, 0,
-        sinx, cosx, 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1,
-    };
-    return m;
+    size_t size;
+    return tryReadFile(path, &size);
 }
 
-Matrix4 matrixScaleF(float x, float y, float z)
+char *readTextFile(char *path)
 {
-    Matrix4 m = {
-        x, 0, 0, 0,
-        0, y, 0, 0,
-        0, 0, z, 0,
-        0, 0, 0, 1,
-    };
-    return m;
+    char *text = tryReadTextFile(path);
+    if (!text)
+    {
+        fprintf(stderr, "error: cannot read file: %s\n", path);
+        exit(1);
+    }
+    return text;
 }
 
-Matrix4 matrixScaleUniform(float s)
+// FNV-1a; chain calls by passing the previous result as the seed.
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
 {
-    return matrixScaleF(s, s, s);
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
 }
 
-Vector3 matrixTransformPoint(Matrix4 transform, Vector3 point)
+uint64_t hashString(uint64_t hash, const char *text)
 {
-    float *m = transform.e;
-    Vector3 p = point;
-    Vector3 result;
-    result.x = m[0] * p.x + m[1] * p.y + m[2] * p.z + m[4];
-    result.y = m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7];
-    result.z = m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11];
-    return result;
+    return hashBytes(hash, text, strlen(text));
 }
 
 //=============================================================================================
@@ -330,15 +138,63 @@ void onGLDebugMessage(GLenum source, GLenum type, unsigned id, GLenum severity,
     }
 }
 
+// Each mode's update fills in frame packets on the main thread, and its render draws them on the
+// render thread. Modes with threads of their own end them in stop, which can be NULL:
+typedef struct Screensaver
+{
+    char *name;
+    FrameFunction update;
+    FrameFunction render;
+    void (*stop)();
+} Screensaver;
+
+static Screensaver Screensavers[] =
+{
+    { "checkers", updateCheckers, renderCheckers, stopCheckers },
+    { "cube", updateCube, renderCube, NULL },
+    { "fountain", updateFountain, renderFountain, NULL },
+    { "cubefield", updateCubeField, renderCubeField, NULL },
+};
+
 int main(int argc, char *argv[])
 {
-    UNUSED(argc);
-    UNUSED(argv);
+    bool hotReload = false;
+    bool renderThread = true;
+    Screensaver *screensaver = &Screensavers[0];
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--hot-reload") == 0)
+        {
+            hotReload = true;
+        }
+        else if (strcmp(argv[i], "--basic-renderer") == 0)
+        {
+            useBasicRenderer();
+        }
+        else if (strcmp(argv[i], "--no-render-thread") == 0)
+        {
+            renderThread = false;
+        }
+        else
+        {
+            screensaver = NULL;
+            for (int s = 0; s < (int)COUNTOF(Screensavers); s++)
+            {
+                if (strcmp(argv[i], Screensavers[s].name) == 0)
+                {
+                    screensaver = &Screensavers[s];
+                }
+            }
+            if (!screensaver)
+            {
+                fprintf(stderr, "usage: %s [--hot-reload] [--basic-renderer] [--no-render-thread] [checkers | cube | fountain | cubefield]\n", argv[0]);
+                exit(1);
+            }
+        }
+    }
 
     check(SDL_Init(SDL_INIT_EVERYTHING) == 0, "SDL_Init");
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
@@ -379,15 +235,24 @@ int main(int argc, char *argv[])
     check(window != NULL, "SDL_CreateWindow");
     SDL_ShowCursor(SDL_DISABLE);
 
-    SDL_GLContext context = SDL_GL_CreateContext(window);
+    // Ask for the newest version first; the renderer uses whatever the context turns out to support:
+    int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+    SDL_GLContext context = 0;
+    for (int i = 0; i < (int)COUNTOF(versions) && !context; i++)
+    {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, versions[i][0]);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, versions[i][1]);
+        context = SDL_GL_CreateContext(window);
+    }
     check(context != 0, "SDL_GL_CreateContext");
     LoadGL();
+    check(GLSupported.VERSION_3_3, "OpenGL 3.3 is required");
     if (SDL_GL_SetSwapInterval(1) != 0)
     {
         fprintf(stderr, "warning: cannot set GL swap interval\n");
     }
 
-    if (DEBUG_GRAPHICS)
+    if (DEBUG_GRAPHICS && GLSupported.KHR_debug)
     {
         glEnable(GL_DEBUG_OUTPUT);
         glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
@@ -398,6 +263,17 @@ int main(int argc, char *argv[])
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
+    startRenderer();
+    startJobs(0);
+
+    if (hotReload)
+    {
+        startShaderHotReload();
+    }
+
+    // The context moves to the render thread, so that waiting on the swap does not hold up the
+    // next frame's simulation:
+    startRenderThread(window, context, screensaver->render, renderThread);
 
     for (;;)
     {
@@ -406,12 +282,17 @@ int main(int argc, char *argv[])
         {
             if (ev.type == SDL_QUIT)
             {
+                stopRenderThread();
+                if (screensaver->stop)
+                {
+                    screensaver->stop();
+                }
                 exit(0);
             }
         }
 
-        screensaverCheckers();
-
-        SDL_GL_SwapWindow(window);
+        FramePacket *packet = beginFramePacket();
+        screensaver->update(packet);
+        submitFramePacket(packet);
     }
 }
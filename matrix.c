@@ -0,0 +1,556 @@
+#include "common.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATRIX_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MATRIX_SSE 1
+#endif
+
+//=============================================================================================
+// Trigonometry
+//=============================================================================================
+
+// Both at once, sharing the range reduction. Accurate to a few units in the last place for
+// angles within a few thousand radians of zero, which covers anything animated here.
+void sinCos(float radians, float *sine, float *cosine)
+{
+    // Reduce to [-pi/4, pi/4] and a quadrant, in double so the reduction itself loses nothing:
+    double quadrant = floor(radians * (2 / M_PI) + 0.5);
+    float r = (float)(radians - quadrant * (M_PI / 2));
+    float r2 = r * r;
+    float s = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    float c = 1 - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    switch ((int64_t)quadrant & 3)
+    {
+    case 0: *sine = s; *cosine = c; break;
+    case 1: *sine = c; *cosine = -s; break;
+    case 2: *sine = -s; *cosine = -c; break;
+    default: *sine = -c; *cosine = s; break;
+    }
+}
+
+//=============================================================================================
+// Matrices (4x4)
+//=============================================================================================
+
+// Matrices are stored column-major, the way GL expects them, and transform column vectors. In the
+// initializers below, each line is a column.
+
+float *matrixElement(Matrix4 *matrix, int row, int column)
+{
+    return matrix->e + column * 4 + row;
+}
+
+// result = a * b, so b is applied first. The result may be the same matrix as either input.
+static void multiplyColumnMajor(Matrix4 *result, const Matrix4 *a, const Matrix4 *b)
+{
+#if defined(MATRIX_AVX)
+    // Two columns of the result at a time; each column of a is repeated in both halves:
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *)(a->e + 0));
+    __m256 a1 = _mm256_broadcast_ps((const __m128 *)(a->e + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128 *)(a->e + 8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128 *)(a->e + 12));
+    __m256 b01 = _mm256_loadu_ps(b->e + 0);
+    __m256 b23 = _mm256_loadu_ps(b->e + 8);
+
+    __m256 c01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+    c01 = _mm256_add_ps(c01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)));
+    c01 = _mm256_add_ps(c01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)));
+    c01 = _mm256_add_ps(c01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)));
+    __m256 c23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+    c23 = _mm256_add_ps(c23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55)));
+    c23 = _mm256_add_ps(c23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA)));
+    c23 = _mm256_add_ps(c23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF)));
+
+    _mm256_storeu_ps(result->e + 0, c01);
+    _mm256_storeu_ps(result->e + 8, c23);
+#elif defined(MATRIX_SSE)
+    __m128 a0 = _mm_loadu_ps(a->e + 0);
+    __m128 a1 = _mm_loadu_ps(a->e + 4);
+    __m128 a2 = _mm_loadu_ps(a->e + 8);
+    __m128 a3 = _mm_loadu_ps(a->e + 12);
+
+    // Column j of b is read before column j of the result is written, so b may be the result:
+    for (int j = 0; j < 4; j++)
+    {
+        __m128 bj = _mm_loadu_ps(b->e + 4 * j);
+        __m128 c = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, 0x00));
+        c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, 0x55)));
+        c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, 0xAA)));
+        c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, 0xFF)));
+        _mm_storeu_ps(result->e + 4 * j, c);
+    }
+#else
+    Matrix4 m;
+    for (int j = 0; j < 4; j++)
+    {
+        const float *bj = b->e + 4 * j;
+        for (int row = 0; row < 4; row++)
+        {
+            m.e[4 * j + row] =
+                a->e[row] * bj[0] +
+                a->e[4 + row] * bj[1] +
+                a->e[8 + row] * bj[2] +
+                a->e[12 + row] * bj[3];
+        }
+    }
+    *result = m;
+#endif
+}
+
+// Sets result to the transform that applies `left` and then `right`. The result may be the same
+// matrix as either input.
+void matrixMultiplyTo(Matrix4 *result, const Matrix4 *left, const Matrix4 *right)
+{
+    multiplyColumnMajor(result, right, left);
+}
+
+// The transform that applies `left` and then `right`.
+Matrix4 matrixMultiply(Matrix4 left, Matrix4 right)
+{
+    Matrix4 m;
+    multiplyColumnMajor(&m, &right, &left);
+    return m;
+}
+
+// Appends `right` to `left` in place.
+void matrixConcat(Matrix4 *left, Matrix4 right)
+{
+    multiplyColumnMajor(left, &right, left);
+}
+
+Matrix4 matrixIdentity()
+{
+    Matrix4 m = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixPixelPerfect()
+{
+    Matrix4 m = {
+        2.0f / WINDOW_WIDTH, 0, 0, 0,
+        0, 2.0f / WINDOW_HEIGHT, 0, 0,
+        0, 0, -0.001f, 0,
+        -1, -1, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixPerspective(float near, float fov)
+{
+    float e = 1 / (float)tan(fov / 2);
+    float a = (float)WINDOW_HEIGHT / WINDOW_WIDTH;
+    Matrix4 m = {
+        e, 0, 0, 0,
+        0, e / a, 0, 0,
+        0, 0, -1, -1,
+        0, 0, -2 * near, 0,
+    };
+    return m;
+}
+
+Matrix4 matrixTranslation(Vector3 v)
+{
+    Matrix4 m = {
+        1, 0, 0, 0,
+        0, 1, 0, 0,
+        0, 0, 1, 0,
+        v.x, v.y, v.z, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixTranslationF(float x, float y, float z)
+{
+    return matrixTranslation((Vector3){ x, y, z });
+}
+
+Matrix4 matrixRotationX(float radians)
+{
+    float sinx, cosx;
+    sinCos(radians, &sinx, &cosx);
+    Matrix4 m = {
+        1, 0, 0, 0,
+        0, cosx, sinx, 0,
+        0, -sinx, cosx, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixRotationY(float radians)
+{
+    float sinx, cosx;
+    sinCos(radians, &sinx, &cosx);
+    Matrix4 m = {
+        cosx, 0, -sinx, 0,
+        0, 1, 0, 0,
+        sinx, 0, cosx, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixRotationZ(float radians)
+{
+    float sinx, cosx;
+    sinCos(radians, &sinx, &cosx);
+    Matrix4 m = {
+        cosx, sinx, 0, 0,
+        -sinx, cosx, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixScaleF(float x, float y, float z)
+{
+    Matrix4 m = {
+        x, 0, 0, 0,
+        0, y, 0, 0,
+        0, 0, z, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+Matrix4 matrixScaleUniform(float s)
+{
+    return matrixScaleF(s, s, s);
+}
+
+Vector3 matrixTransformPoint(Matrix4 transform, Vector3 point)
+{
+    float *m = transform.e;
+    Vector3 p = point;
+    Vector3 result;
+    result.x = m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12];
+    result.y = m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13];
+    result.z = m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14];
+    return result;
+}
+
+//=============================================================================================
+// Transforms
+//=============================================================================================
+
+// These build whole transforms directly instead of multiplying one 4x4 matrix per step.
+
+Quaternion quaternionIdentity()
+{
+    return (Quaternion){ 0, 0, 0, 1 };
+}
+
+// A rotation about a unit-length axis.
+Quaternion quaternionAxisAngle(Vector3 axis, float radians)
+{
+    float s, c;
+    sinCos(radians / 2, &s, &c);
+    return (Quaternion){ axis.x * s, axis.y * s, axis.z * s, c };
+}
+
+// The rotation that applies `left` and then `right`, like matrixMultiply.
+Quaternion quaternionMultiply(Quaternion left, Quaternion right)
+{
+    Quaternion a = right, b = left;
+    return (Quaternion){
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+
+// Scales, then rotates, then translates. The rotation must be unit length.
+Matrix4 matrixTRS(Vector3 translation, Quaternion rotation, Vector3 scale)
+{
+    Quaternion q = rotation;
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    Matrix4 m = {
+        scale.x * (1 - 2 * (yy + zz)), scale.x * 2 * (xy + wz), scale.x * 2 * (xz - wy), 0,
+        scale.y * 2 * (xy - wz), scale.y * (1 - 2 * (xx + zz)), scale.y * 2 * (yz + wx), 0,
+        scale.z * 2 * (xz + wy), scale.z * 2 * (yz - wx), scale.z * (1 - 2 * (xx + yy)), 0,
+        translation.x, translation.y, translation.z, 1,
+    };
+    return m;
+}
+
+// A view transform for a camera at `eye` looking at `target`.
+Matrix4 matrixLookAt(Vector3 eye, Vector3 target, Vector3 up)
+{
+    Vector3 f = { target.x - eye.x, target.y - eye.y, target.z - eye.z };
+    float fLength = sqrtf(f.x * f.x + f.y * f.y + f.z * f.z);
+    f = (Vector3){ f.x / fLength, f.y / fLength, f.z / fLength };
+    Vector3 s = { f.y * up.z - f.z * up.y, f.z * up.x - f.x * up.z, f.x * up.y - f.y * up.x };
+    float sLength = sqrtf(s.x * s.x + s.y * s.y + s.z * s.z);
+    s = (Vector3){ s.x / sLength, s.y / sLength, s.z / sLength };
+    Vector3 u = { s.y * f.z - s.z * f.y, s.z * f.x - s.x * f.z, s.x * f.y - s.y * f.x };
+    Matrix4 m = {
+        s.x, u.x, -f.x, 0,
+        s.y, u.y, -f.y, 0,
+        s.z, u.z, -f.z, 0,
+        -(s.x * eye.x + s.y * eye.y + s.z * eye.z),
+        -(u.x * eye.x + u.y * eye.y + u.z * eye.z),
+        f.x * eye.x + f.y * eye.y + f.z * eye.z, 1,
+    };
+    return m;
+}
+
+// A view transform that turns the world by `yaw` about Y, tilts it by `pitch` about X, and then
+// moves it by `offset`: the same as chaining matrixRotationY, matrixRotationX and
+// matrixTranslation.
+Matrix4 matrixOrbit(float yaw, float pitch, Vector3 offset)
+{
+    float sy, cy, sp, cp;
+    sinCos(yaw, &sy, &cy);
+    sinCos(pitch, &sp, &cp);
+    Matrix4 m = {
+        cy, sp * sy, -cp * sy, 0,
+        0, cp, sp, 0,
+        sy, -sp * cy, cp * cy, 0,
+        offset.x, offset.y, offset.z, 1,
+    };
+    return m;
+}
+
+// The same as appending matrixPerspective to the view, without the general multiply.
+Matrix4 matrixViewPerspective(const Matrix4 *view, float near, float fov)
+{
+    float e = 1 / (float)tan(fov / 2);
+    float a = (float)WINDOW_HEIGHT / WINDOW_WIDTH;
+    Matrix4 m;
+    for (int column = 0; column < 4; column++)
+    {
+        const float *v = view->e + column * 4;
+        m.e[column * 4 + 0] = e * v[0];
+        m.e[column * 4 + 1] = e / a * v[1];
+        m.e[column * 4 + 2] = -v[2] - 2 * near * v[3];
+        m.e[column * 4 + 3] = -v[2];
+    }
+    return m;
+}
+
+// The camera's position and axes in world space, from a view transform without scaling:
+
+Vector3 matrixViewPosition(const Matrix4 *view)
+{
+    const float *e = view->e;
+    return (Vector3){
+        -(e[0] * e[12] + e[1] * e[13] + e[2] * e[14]),
+        -(e[4] * e[12] + e[5] * e[13] + e[6] * e[14]),
+        -(e[8] * e[12] + e[9] * e[13] + e[10] * e[14]),
+    };
+}
+
+Vector3 matrixViewRight(const Matrix4 *view)
+{
+    return (Vector3){ view->e[0], view->e[4], view->e[8] };
+}
+
+Vector3 matrixViewUp(const Matrix4 *view)
+{
+    return (Vector3){ view->e[1], view->e[5], view->e[9] };
+}
+
+//=============================================================================================
+// Batch transforms
+//=============================================================================================
+
+// out = rows * (x, y, z, 1) for each point, dividing by w if `project` is set. The rows are the
+// first three rows of the matrix, plus the fourth when projecting. `out` may be the same as `in`.
+static void transformArrays(float rows[4][4], Vector3Arrays in, Vector3Arrays out, size_t count, bool project)
+{
+    size_t i = 0;
+
+#if defined(MATRIX_AVX)
+    __m256 r[4][4];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            r[row][column] = _mm256_set1_ps(rows[row][column]);
+        }
+    }
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(in.x + i);
+        __m256 y = _mm256_loadu_ps(in.y + i);
+        __m256 z = _mm256_loadu_ps(in.z + i);
+        __m256 o[4];
+        for (int row = 0; row < (project ? 4 : 3); row++)
+        {
+            o[row] = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(r[row][0], x), _mm256_mul_ps(r[row][1], y)),
+                _mm256_add_ps(_mm256_mul_ps(r[row][2], z), r[row][3]));
+        }
+        if (project)
+        {
+            __m256 invW = _mm256_div_ps(_mm256_set1_ps(1), o[3]);
+            o[0] = _mm256_mul_ps(o[0], invW);
+            o[1] = _mm256_mul_ps(o[1], invW);
+            o[2] = _mm256_mul_ps(o[2], invW);
+        }
+        _mm256_storeu_ps(out.x + i, o[0]);
+        _mm256_storeu_ps(out.y + i, o[1]);
+        _mm256_storeu_ps(out.z + i, o[2]);
+    }
+#endif
+
+#if defined(MATRIX_AVX) || defined(MATRIX_SSE)
+    __m128 s[4][4];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            s[row][column] = _mm_set1_ps(rows[row][column]);
+        }
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(in.x + i);
+        __m128 y = _mm_loadu_ps(in.y + i);
+        __m128 z = _mm_loadu_ps(in.z + i);
+        __m128 o[4];
+        for (int row = 0; row < (project ? 4 : 3); row++)
+        {
+            o[row] = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(s[row][0], x), _mm_mul_ps(s[row][1], y)),
+                _mm_add_ps(_mm_mul_ps(s[row][2], z), s[row][3]));
+        }
+        if (project)
+        {
+            __m128 invW = _mm_div_ps(_mm_set1_ps(1), o[3]);
+            o[0] = _mm_mul_ps(o[0], invW);
+            o[1] = _mm_mul_ps(o[1], invW);
+            o[2] = _mm_mul_ps(o[2], invW);
+        }
+        _mm_storeu_ps(out.x + i, o[0]);
+        _mm_storeu_ps(out.y + i, o[1]);
+        _mm_storeu_ps(out.z + i, o[2]);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        float x = in.x[i], y = in.y[i], z = in.z[i];
+        float o[4];
+        for (int row = 0; row < (project ? 4 : 3); row++)
+        {
+            o[row] = rows[row][0] * x + rows[row][1] * y + rows[row][2] * z + rows[row][3];
+        }
+        float invW = project ? 1 / o[3] : 1;
+        out.x[i] = o[0] * invW;
+        out.y[i] = o[1] * invW;
+        out.z[i] = o[2] * invW;
+    }
+}
+
+static void matrixRows(const Matrix4 *m, float rows[4][4])
+{
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            rows[row][column] = m->e[column * 4 + row];
+        }
+    }
+}
+
+// Transforms points by an affine matrix; the bottom row is taken to be (0, 0, 0, 1), which saves
+// the divide. `out` may be the same arrays as `in`.
+void matrixTransformPoints(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count)
+{
+    float rows[4][4];
+    matrixRows(transform, rows);
+    transformArrays(rows, in, out, count, false);
+}
+
+// Transforms points by any matrix, including projections, and divides by w.
+void matrixProjectPoints(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count)
+{
+    float rows[4][4];
+    matrixRows(transform, rows);
+    transformArrays(rows, in, out, count, true);
+}
+
+// Transforms directions, which ignore the translation.
+void matrixTransformVectors(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count)
+{
+    float rows[4][4];
+    matrixRows(transform, rows);
+    rows[0][3] = rows[1][3] = rows[2][3] = 0;
+    transformArrays(rows, in, out, count, false);
+}
+
+// Transforms surface normals, which stay perpendicular to the transformed surface under scaling
+// and shearing, and normalizes them.
+void matrixTransformNormals(const Matrix4 *transform, Vector3Arrays in, Vector3Arrays out, size_t count)
+{
+    // The normal matrix is the inverse transpose of the upper 3x3. The cofactor matrix is that
+    // times the determinant, which only changes the length, apart from flipping for mirrors:
+    float a[3][3];
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            a[row][column] = transform->e[column * 4 + row];
+        }
+    }
+    float rows[4][4] = { 0 };
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            int r0 = (row + 1) % 3, r1 = (row + 2) % 3;
+            int c0 = (column + 1) % 3, c1 = (column + 2) % 3;
+            rows[row][column] = a[r0][c0] * a[r1][c1] - a[r0][c1] * a[r1][c0];
+        }
+    }
+    float determinant = a[0][0] * rows[0][0] + a[0][1] * rows[0][1] + a[0][2] * rows[0][2];
+    if (determinant < 0)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            for (int column = 0; column < 3; column++)
+            {
+                rows[row][column] = -rows[row][column];
+            }
+        }
+    }
+    transformArrays(rows, in, out, count, false);
+
+    size_t i = 0;
+#if defined(MATRIX_AVX) || defined(MATRIX_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(out.x + i);
+        __m128 y = _mm_loadu_ps(out.y + i);
+        __m128 z = _mm_loadu_ps(out.z + i);
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        // Zero-length normals stay zero:
+        __m128 scale = _mm_div_ps(_mm_set1_ps(1), _mm_sqrt_ps(_mm_max_ps(lengthSquared, _mm_set1_ps(1e-30f))));
+        _mm_storeu_ps(out.x + i, _mm_mul_ps(x, scale));
+        _mm_storeu_ps(out.y + i, _mm_mul_ps(y, scale));
+        _mm_storeu_ps(out.z + i, _mm_mul_ps(z, scale));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float lengthSquared = out.x[i] * out.x[i] + out.y[i] * out.y[i] + out.z[i] * out.z[i];
+        float scale = 1 / sqrtf(lengthSquared > 1e-30f ? lengthSquared : 1e-30f);
+        out.x[i] *= scale;
+        out.y[i] *= scale;
+        out.z[i] *= scale;
+    }
+}
@@ -0,0 +1,183 @@
+#include "common.h"
+#include <string.h>
+
+// Vertex attributes of the particle state, for both programs:
+#define PARTICLE_POSITION_ATTRIBUTE 0
+#define PARTICLE_VELOCITY_ATTRIBUTE 1
+#define PARTICLE_COLOR_ATTRIBUTE 2
+
+// The transform feedback output of particlestep.v.glsl, which is also its input:
+typedef struct Particle
+{
+    // The age is in w and is negative until the particle is first born:
+    Vector4 position;
+    // The lifetime is in w:
+    Vector4 velocity;
+    Color color;
+} Particle;
+
+static struct particleGlobals
+{
+    bool started;
+    ShaderProgram *stepShader;
+    ShaderProgram *spriteShader;
+} g;
+
+//=============================================================================================
+// Programs
+//=============================================================================================
+
+static void startParticles()
+{
+    g.started = true;
+    g.stepShader = requestFeedbackVariant("particlestep.v.glsl", "outPosition outVelocity outColor", "");
+    g.spriteShader = requestShaderVariant("particles.v.glsl", "particles.f.glsl", "");
+}
+
+//=============================================================================================
+// Particle systems
+//=============================================================================================
+
+static void attachParticles(GLuint buffer, GLuint divisor)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glEnableVertexAttribArray(PARTICLE_POSITION_ATTRIBUTE);
+    glEnableVertexAttribArray(PARTICLE_VELOCITY_ATTRIBUTE);
+    glEnableVertexAttribArray(PARTICLE_COLOR_ATTRIBUTE);
+    glVertexAttribPointer(PARTICLE_POSITION_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void *)offsetof(Particle, position));
+    glVertexAttribPointer(PARTICLE_VELOCITY_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void *)offsetof(Particle, velocity));
+    glVertexAttribPointer(PARTICLE_COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void *)offsetof(Particle, color));
+    glVertexAttribDivisor(PARTICLE_POSITION_ATTRIBUTE, divisor);
+    glVertexAttribDivisor(PARTICLE_VELOCITY_ATTRIBUTE, divisor);
+    glVertexAttribDivisor(PARTICLE_COLOR_ATTRIBUTE, divisor);
+}
+
+// Particles live entirely in GPU buffers: each step reads the state from one buffer and captures
+// the next state into the other with transform feedback, so the CPU never touches a particle after
+// this. Only needs GL 3.3. The particles are born at an even rate over the first `startTime`
+// seconds, which should be about the emitters' lifetime to reach a steady state right away.
+void createParticleSystem(ParticleSystem *system, size_t count, float startTime)
+{
+    if (!g.started)
+    {
+        startParticles();
+    }
+
+    memset(system, 0, sizeof(*system));
+    system->count = count;
+    system->size = 0.05f;
+
+    // Not born yet, and waiting their turn:
+    Particle *particles = xalloc(count * sizeof(particles[0]));
+    memset(particles, 0, count * sizeof(particles[0]));
+    for (size_t i = 0; i < count; i++)
+    {
+        particles[i].position.w = -startTime * ((float)i / count);
+    }
+
+    glGenBuffers(2, system->buffers);
+    glGenVertexArrays(2, system->stepVertexArrays);
+    glGenVertexArrays(2, system->drawVertexArrays);
+    for (int i = 0; i < 2; i++)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, system->buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(particles[0]), particles, GL_STREAM_COPY);
+
+        glBindVertexArray(system->stepVertexArrays[i]);
+        attachParticles(system->buffers[i], 0);
+        glBindVertexArray(system->drawVertexArrays[i]);
+        attachParticles(system->buffers[i], 1);
+    }
+    glBindVertexArray(0);
+
+    free(particles);
+}
+
+void updateParticleSystem(ParticleSystem *system, float timeStep)
+{
+    // There is no stand-in for this program, so the particles wait for it:
+    if (!isShaderProgramReady(g.stepShader))
+    {
+        return;
+    }
+    useShaderProgram(g.stepShader);
+
+    Vector4 emitterPositions[MAX_PARTICLE_EMITTERS];
+    Vector4 emitterVelocities[MAX_PARTICLE_EMITTERS];
+    Vector4 emitterColors[MAX_PARTICLE_EMITTERS];
+    float emitterLives[MAX_PARTICLE_EMITTERS][2];
+    float totalShare = 0;
+    for (int i = 0; i < system->emitterCount; i++)
+    {
+        totalShare += system->emitters[i].share;
+    }
+    float share = 0;
+    for (int i = 0; i < system->emitterCount; i++)
+    {
+        ParticleEmitter *e = &system->emitters[i];
+        share += e->share;
+        emitterPositions[i] = (Vector4){ e->position.x, e->position.y, e->position.z, e->radius };
+        emitterVelocities[i] = (Vector4){ e->velocity.x, e->velocity.y, e->velocity.z, e->spread };
+        emitterColors[i] = (Vector4){ e->color.r, e->color.g, e->color.b, e->color.a };
+        emitterLives[i][0] = e->lifetime;
+        emitterLives[i][1] = (totalShare > 0) ? share / totalShare : 1;
+    }
+
+    setUniformFloat(UNIFORM_TIME_STEP, timeStep);
+    // A different sequence of random numbers for every step:
+    setUniformUint(UNIFORM_SEED, (GLuint)hashBytes(HASH_SEED, &system->stepCount, sizeof(system->stepCount)));
+    setUniformInt(UNIFORM_EMITTER_COUNT, system->emitterCount);
+    if (system->emitterCount > 0)
+    {
+        setUniformFloats(UNIFORM_EMITTER_POSITION, 4, system->emitterCount, &emitterPositions[0].x);
+        setUniformFloats(UNIFORM_EMITTER_VELOCITY, 4, system->emitterCount, &emitterVelocities[0].x);
+        setUniformFloats(UNIFORM_EMITTER_COLOR, 4, system->emitterCount, &emitterColors[0].x);
+        setUniformFloats(UNIFORM_EMITTER_LIFE, 2, system->emitterCount, &emitterLives[0][0]);
+    }
+    setUniformVector4(UNIFORM_GRAVITY, (Vector4){ system->gravity.x, system->gravity.y, system->gravity.z, system->drag });
+    setUniformInt(UNIFORM_ATTRACTOR_COUNT, system->attractorCount);
+    if (system->attractorCount > 0)
+    {
+        setUniformFloats(UNIFORM_ATTRACTOR, 4, system->attractorCount, &system->attractors[0].position.x);
+    }
+
+    int next = 1 - system->current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(system->stepVertexArrays[system->current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, system->buffers[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)system->count);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    system->current = next;
+    system->stepCount++;
+}
+
+// Draws the particles as additive sprites that face the camera. They are depth tested against
+// what has already been drawn but do not write depth, so draw them last.
+void drawParticleSystem(ParticleSystem *system, Matrix4 *viewProjection, Vector3 cameraRight, Vector3 cameraUp)
+{
+    if (!isShaderProgramReady(g.spriteShader))
+    {
+        return;
+    }
+
+    useShaderProgram(g.spriteShader);
+    setUniformMatrix4(UNIFORM_PROJECTION, viewProjection);
+    setUniformVector3(UNIFORM_CAMERA_RIGHT, cameraRight);
+    setUniformVector3(UNIFORM_CAMERA_UP, cameraUp);
+    setUniformFloat(UNIFORM_PARTICLE_SIZE, system->size);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(system->drawVertexArrays[system->current]);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)system->count);
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
@@ -0,0 +1,932 @@
+#include "common.h"
+#include <string.h>
+
+#define INITIAL_MESH_VERTICES 16384
+#define INITIAL_MESH_INDICES 65536
+#define MAX_FRAME_DRAWS 16384
+#define MAX_FRAME_INSTANCES 131072
+
+// Frames that may be in flight on the GPU while the CPU writes the next one:
+#define STREAM_FRAMES 3
+
+// Vertex buffer binding points and attribute locations; see cube.v.glsl:
+#define MESH_BINDING 0
+#define INSTANCE_BINDING 1
+#define INSTANCE_TRANSFORM_ATTRIBUTE 3
+#define INSTANCE_COLOR_ATTRIBUTE 7
+
+// Where DRAW_ID shaders find the per-draw data. Samplers default to unit zero, so the shaders do
+// not need a uniform set for it:
+#define DRAW_DATA_TEXTURE_UNIT 0
+#define DRAW_DATA_TEXELS (sizeof(DrawInstance) / (4 * sizeof(float)))
+
+// Storage buffer bindings and work group size; see cull.c.glsl:
+#define CULL_OBJECT_BINDING 0
+#define CULL_COMMAND_BINDING 1
+#define CULL_INSTANCE_BINDING 2
+#define CULL_COUNTER_BINDING 3
+#define CULL_GROUP_SIZE 64
+
+// A buffer that is rewritten every frame. It is split into one region per frame in flight, and a
+// region is only reused once the fence for the frame that last used it has passed.
+typedef struct StreamBuffer
+{
+    GLuint buffer;
+    size_t frameSize;
+    // The persistent mapping, or memory that is copied into the buffer when the draws are submitted:
+    uint8_t *data;
+    size_t start, cursor;
+} StreamBuffer;
+
+static struct renderGlobals
+{
+    bool started;
+    bool basic;
+
+    // The paths in use; see startRenderer:
+    bool directStateAccess;
+    bool bufferStorage;
+    bool baseInstance;
+    bool multiDrawIndirect;
+    bool drawID;
+    bool computeCulling;
+    bool indirectCount;
+
+    // Every mesh lives in the same buffers, so that any set of them can be drawn with one call:
+    GLuint vao;
+    GLuint vertexBuffer, indexBuffer;
+    size_t vertexCount, vertexCapacity;
+    size_t indexCount, indexCapacity;
+
+    StreamBuffer instances, commands;
+    DrawCommand *drawList;
+    size_t drawCount;
+    // Each submitDraws starts its instance data at a multiple of this, for glTexBufferRange:
+    size_t instanceAlignment;
+    GLuint instanceTexture;
+
+    ShaderProgram *cullShader;
+
+    int frame;
+    GLsync frameFences[STREAM_FRAMES];
+} g;
+
+//=============================================================================================
+// Buffers
+//=============================================================================================
+
+// Buffers that are only written with writeBuffer get immutable storage when the driver has it.
+static GLuint createBuffer(size_t size, const void *data, GLbitfield storageFlags, GLenum usage)
+{
+    GLuint buffer;
+    if (g.directStateAccess)
+    {
+        glCreateBuffers(1, &buffer);
+        if (g.bufferStorage)
+        {
+            glNamedBufferStorage(buffer, size, data, storageFlags);
+        }
+        else
+        {
+            glNamedBufferData(buffer, size, data, usage);
+        }
+    }
+    else
+    {
+        // The copy targets are not part of any VAO, so binding them changes no other state:
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        if (g.bufferStorage)
+        {
+            glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, storageFlags);
+        }
+        else
+        {
+            glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+        }
+    }
+    return buffer;
+}
+
+static void writeBuffer(GLuint buffer, size_t offset, size_t size, const void *data)
+{
+    if (g.directStateAccess)
+    {
+        glNamedBufferSubData(buffer, offset, size, data);
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    }
+}
+
+static void clearBuffer(GLuint buffer)
+{
+    if (g.directStateAccess)
+    {
+        glClearNamedBufferData(buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    }
+}
+
+static void copyBuffer(GLuint from, GLuint to, size_t size)
+{
+    if (g.directStateAccess)
+    {
+        glCopyNamedBufferSubData(from, to, 0, 0, size);
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, from);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+    }
+}
+
+static void createStreamBuffer(StreamBuffer *stream, size_t frameSize)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->frameSize = frameSize;
+    size_t size = STREAM_FRAMES * frameSize;
+
+    if (g.bufferStorage)
+    {
+        // Mapped once for the life of the program; the fences take care of synchronization:
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        stream->buffer = createBuffer(size, NULL, flags, 0);
+        if (g.directStateAccess)
+        {
+            stream->data = glMapNamedBufferRange(stream->buffer, 0, size, flags);
+        }
+        else
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer);
+            stream->data = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+        }
+        check(stream->data != NULL, "cannot map stream buffer");
+    }
+    else
+    {
+        stream->buffer = createBuffer(size, NULL, 0, GL_STREAM_DRAW);
+        stream->data = xalloc(size);
+    }
+}
+
+// Returns space for `size` more bytes in this frame's region.
+static void *appendStreamBuffer(StreamBuffer *stream, size_t size)
+{
+    size_t end = (g.frame + 1) * stream->frameSize;
+    check(stream->cursor + size <= end, "too many draws in one frame");
+    void *p = stream->data + stream->cursor;
+    stream->cursor += size;
+    return p;
+}
+
+// Makes everything appended since the last flush visible to the GPU. Returns its offset.
+static size_t flushStreamBuffer(StreamBuffer *stream)
+{
+    size_t start = stream->start;
+    if (!g.bufferStorage && stream->cursor > start)
+    {
+        writeBuffer(stream->buffer, start, stream->cursor - start, stream->data + start);
+    }
+    stream->start = stream->cursor;
+    return start;
+}
+
+static void alignStreamBuffer(StreamBuffer *stream, size_t alignment)
+{
+    stream->cursor = (stream->cursor + alignment - 1) / alignment * alignment;
+    stream->start = stream->cursor;
+}
+
+static void resetStreamBuffer(StreamBuffer *stream)
+{
+    stream->start = stream->cursor = g.frame * stream->frameSize;
+}
+
+//=============================================================================================
+// Renderer
+//=============================================================================================
+
+static void attachMeshBuffers()
+{
+    if (g.directStateAccess)
+    {
+        glVertexArrayVertexBuffer(g.vao, MESH_BINDING, g.vertexBuffer, 0, sizeof(BasicVertex));
+        glVertexArrayElementBuffer(g.vao, g.indexBuffer);
+    }
+    else
+    {
+        glBindVertexArray(g.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, g.vertexBuffer);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, position));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, normal));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BasicVertex), (void*)offsetof(BasicVertex, color));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g.indexBuffer);
+    }
+}
+
+// Points the per-draw attributes at the instance data starting at `offset`.
+static void attachInstances(GLuint buffer, size_t offset)
+{
+    if (g.directStateAccess)
+    {
+        glVertexArrayVertexBuffer(g.vao, INSTANCE_BINDING, buffer, offset, sizeof(DrawInstance));
+    }
+    else
+    {
+        glBindVertexArray(g.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (int row = 0; row < 4; row++)
+        {
+            size_t rowOffset = offset + offsetof(DrawInstance, transform) + row * 4 * sizeof(float);
+            glVertexAttribPointer(INSTANCE_TRANSFORM_ATTRIBUTE + row, 4, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (void*)rowOffset);
+        }
+        glVertexAttribPointer(INSTANCE_COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(DrawInstance), (void*)(offset + offsetof(DrawInstance, color)));
+    }
+}
+
+static void createVertexArray()
+{
+    if (g.directStateAccess)
+    {
+        glCreateVertexArrays(1, &g.vao);
+
+        // Vertex layout:
+        glVertexArrayAttribFormat(g.vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(BasicVertex, position));
+        glVertexArrayAttribFormat(g.vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(BasicVertex, normal));
+        glVertexArrayAttribFormat(g.vao, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(BasicVertex, color));
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glEnableVertexArrayAttrib(g.vao, i);
+            glVertexArrayAttribBinding(g.vao, i, MESH_BINDING);
+        }
+
+        // Instance layout:
+        for (GLuint row = 0; row < 4; row++)
+        {
+            glVertexArrayAttribFormat(g.vao, INSTANCE_TRANSFORM_ATTRIBUTE + row, 4, GL_FLOAT, GL_FALSE,
+                (GLuint)(offsetof(DrawInstance, transform) + row * 4 * sizeof(float)));
+        }
+        glVertexArrayAttribFormat(g.vao, INSTANCE_COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, offsetof(DrawInstance, color));
+        for (GLuint i = INSTANCE_TRANSFORM_ATTRIBUTE; i <= INSTANCE_COLOR_ATTRIBUTE; i++)
+        {
+            glEnableVertexArrayAttrib(g.vao, i);
+            glVertexArrayAttribBinding(g.vao, i, INSTANCE_BINDING);
+        }
+        glVertexArrayBindingDivisor(g.vao, INSTANCE_BINDING, 1);
+    }
+    else
+    {
+        glGenVertexArrays(1, &g.vao);
+        glBindVertexArray(g.vao);
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glEnableVertexAttribArray(i);
+        }
+        for (GLuint i = INSTANCE_TRANSFORM_ATTRIBUTE; i <= INSTANCE_COLOR_ATTRIBUTE; i++)
+        {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+    }
+
+    attachMeshBuffers();
+    attachInstances(g.instances.buffer, 0);
+}
+
+static size_t greatestCommonDivisor(size_t a, size_t b)
+{
+    while (b)
+    {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Call once the context is current, and before any shader is requested, since the choice of path
+// adds shader defines.
+void startRenderer()
+{
+    g.started = true;
+
+    // Pick the fastest path for each feature that the context supports:
+    g.directStateAccess = !g.basic && GLSupported.ARB_direct_state_access;
+    g.bufferStorage = !g.basic && GLSupported.ARB_buffer_storage;
+    g.baseInstance = !g.basic && GLSupported.ARB_base_instance;
+    g.multiDrawIndirect = g.baseInstance && GLSupported.ARB_draw_indirect && GLSupported.ARB_multi_draw_indirect;
+
+    // With draw parameters, INSTANCED shaders fetch the per-draw data by gl_DrawIDARB instead of
+    // from vertex attributes:
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    g.drawID = g.multiDrawIndirect &&
+        GLSupported.ARB_shader_draw_parameters &&
+        GLSupported.ARB_texture_buffer_range &&
+        (size_t)maxTexels >= MAX_FRAME_INSTANCES * DRAW_DATA_TEXELS;
+    g.instanceAlignment = sizeof(DrawInstance);
+    if (g.drawID)
+    {
+        GLint alignment = 1;
+        glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        g.instanceAlignment = sizeof(DrawInstance) / greatestCommonDivisor(sizeof(DrawInstance), alignment) * alignment;
+        addShaderDefines("DRAW_ID");
+    }
+
+    // Culling on the GPU writes indirect commands, and needs GLSL 4.30 for the compute shader:
+    int glslMajor = 0, glslMinor = 0;
+    const char *glslVersion = (const char *)glGetString(GL_SHADING_LANGUAGE_VERSION);
+    if (glslVersion)
+    {
+        sscanf(glslVersion, "%d.%d", &glslMajor, &glslMinor);
+    }
+    g.computeCulling = g.multiDrawIndirect &&
+        GLSupported.ARB_compute_shader &&
+        GLSupported.ARB_shader_storage_buffer_object &&
+        GLSupported.ARB_shader_image_load_store &&
+        GLSupported.ARB_clear_buffer_object &&
+        glslMajor * 100 + glslMinor >= 430;
+    // With indirect parameters, a culled draw only reads as many commands as the shader wrote:
+    g.indirectCount = g.computeCulling && GLSupported.ARB_indirect_parameters;
+
+    if (DEBUG_GRAPHICS)
+    {
+        fprintf(GLLog, "renderer: %s, direct state access %s, buffer storage %s, base instance %s, multi-draw indirect %s, draw ID %s, compute culling %s, indirect count %s\n",
+            (const char *)glGetString(GL_VERSION),
+            g.directStateAccess ? "yes" : "no",
+            g.bufferStorage ? "yes" : "no",
+            g.baseInstance ? "yes" : "no",
+            g.multiDrawIndirect ? "yes" : "no",
+            g.drawID ? "yes" : "no",
+            g.computeCulling ? "yes" : "no",
+            g.indirectCount ? "yes" : "no");
+        fflush(GLLog);
+    }
+
+    g.vertexCapacity = INITIAL_MESH_VERTICES;
+    g.indexCapacity = INITIAL_MESH_INDICES;
+    g.vertexBuffer = createBuffer(g.vertexCapacity * sizeof(BasicVertex), NULL, GL_DYNAMIC_STORAGE_BIT, GL_STATIC_DRAW);
+    g.indexBuffer = createBuffer(g.indexCapacity * sizeof(uint16_t), NULL, GL_DYNAMIC_STORAGE_BIT, GL_STATIC_DRAW);
+
+    createStreamBuffer(&g.instances, MAX_FRAME_INSTANCES * sizeof(DrawInstance));
+    if (g.multiDrawIndirect)
+    {
+        createStreamBuffer(&g.commands, MAX_FRAME_DRAWS * sizeof(DrawCommand));
+    }
+    g.drawList = xalloc(MAX_FRAME_DRAWS * sizeof(g.drawList[0]));
+    if (g.drawID)
+    {
+        glGenTextures(1, &g.instanceTexture);
+    }
+
+    createVertexArray();
+}
+
+// Restricts the renderer to GL 3.3 features, to test the path that older drivers get. Call before
+// startRenderer.
+void useBasicRenderer()
+{
+    check(!g.started, "useBasicRenderer must be called before startRenderer");
+    g.basic = true;
+}
+
+// Moves the mesh data to buffers with at least the given capacities.
+static void growMeshBuffers(size_t vertexCapacity, size_t indexCapacity)
+{
+    while (g.vertexCapacity < vertexCapacity)
+    {
+        g.vertexCapacity *= 2;
+    }
+    while (g.indexCapacity < indexCapacity)
+    {
+        g.indexCapacity *= 2;
+    }
+
+    GLuint vertexBuffer = createBuffer(g.vertexCapacity * sizeof(BasicVertex), NULL, GL_DYNAMIC_STORAGE_BIT, GL_STATIC_DRAW);
+    GLuint indexBuffer = createBuffer(g.indexCapacity * sizeof(uint16_t), NULL, GL_DYNAMIC_STORAGE_BIT, GL_STATIC_DRAW);
+    copyBuffer(g.vertexBuffer, vertexBuffer, g.vertexCount * sizeof(BasicVertex));
+    copyBuffer(g.indexBuffer, indexBuffer, g.indexCount * sizeof(uint16_t));
+    glDeleteBuffers(1, &g.vertexBuffer);
+    glDeleteBuffers(1, &g.indexBuffer);
+    g.vertexBuffer = vertexBuffer;
+    g.indexBuffer = indexBuffer;
+
+    attachMeshBuffers();
+}
+
+void createMesh(Mesh *mesh)
+{
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+// Mesh data is appended to the shared buffers, so each mesh should only be given data once.
+void setMeshData(
+    Mesh *mesh,
+    size_t vertexCount, BasicVertex *vertexData,
+    size_t indexCount, uint16_t *indexData)
+{
+    if (g.vertexCount + vertexCount > g.vertexCapacity || g.indexCount + indexCount > g.indexCapacity)
+    {
+        growMeshBuffers(g.vertexCount + vertexCount, g.indexCount + indexCount);
+    }
+
+    writeBuffer(g.vertexBuffer, g.vertexCount * sizeof(BasicVertex), vertexCount * sizeof(BasicVertex), vertexData);
+    writeBuffer(g.indexBuffer, g.indexCount * sizeof(uint16_t), indexCount * sizeof(uint16_t), indexData);
+
+    mesh->baseVertex = (GLint)g.vertexCount;
+    mesh->firstIndex = (GLuint)g.indexCount;
+    mesh->primitiveCount = indexCount;
+    g.vertexCount += vertexCount;
+    g.indexCount += indexCount;
+}
+
+// Draws a mesh with the model transform and color in the bound program's uniforms.
+void drawMesh(Mesh *mesh)
+{
+    glBindVertexArray(g.vao);
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)mesh->primitiveCount, GL_UNSIGNED_SHORT,
+        (void*)(mesh->firstIndex * sizeof(uint16_t)), mesh->baseVertex);
+}
+
+static void setDrawCommand(DrawCommand *command, Mesh *mesh, size_t instance)
+{
+    // A draw without a mesh is skipped, but keeps its place in the list:
+    command->count = mesh ? (GLuint)mesh->primitiveCount : 0;
+    command->instanceCount = mesh ? 1 : 0;
+    command->firstIndex = mesh ? mesh->firstIndex : 0;
+    command->baseVertex = mesh ? mesh->baseVertex : 0;
+    command->baseInstance = (GLuint)instance;
+}
+
+// Points DRAW_ID shaders at `count` instances of per-draw data starting at `offset`.
+static void bindDrawData(GLuint texture, GLuint buffer, size_t offset, size_t count)
+{
+    glActiveTexture(GL_TEXTURE0 + DRAW_DATA_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBufferRange(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer, offset, count * sizeof(DrawInstance));
+}
+
+// Issues a list of draws with the fastest path available. Each command's baseInstance indexes the
+// instance data that starts at `instanceOffset` in `instanceBuffer`, and `commandOffset` is where
+// the same commands are in the bound indirect buffer.
+static void issueDraws(DrawCommand *commands, size_t count, GLuint instanceBuffer, size_t instanceOffset, size_t commandOffset)
+{
+    glBindVertexArray(g.vao);
+
+    if (g.multiDrawIndirect)
+    {
+        // One call for the whole list:
+        if (!g.drawID)
+        {
+            attachInstances(instanceBuffer, instanceOffset);
+        }
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*)commandOffset, (GLsizei)count, 0);
+    }
+    else if (g.baseInstance)
+    {
+        attachInstances(instanceBuffer, instanceOffset);
+        for (size_t i = 0; i < count; i++)
+        {
+            DrawCommand *c = &commands[i];
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, c->count, GL_UNSIGNED_SHORT,
+                (void*)(c->firstIndex * sizeof(uint16_t)), c->instanceCount, c->baseVertex, c->baseInstance);
+        }
+    }
+    else
+    {
+        // Without a base instance, the attributes have to be moved to each draw's data:
+        for (size_t i = 0; i < count; i++)
+        {
+            DrawCommand *c = &commands[i];
+            if (c->instanceCount > 0)
+            {
+                attachInstances(instanceBuffer, instanceOffset + c->baseInstance * sizeof(DrawInstance));
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, c->count, GL_UNSIGNED_SHORT,
+                    (void*)(c->firstIndex * sizeof(uint16_t)), c->instanceCount, c->baseVertex);
+            }
+        }
+    }
+}
+
+//=============================================================================================
+// Draw lists
+//=============================================================================================
+
+// Queues a draw for the next submitDraws. The transform and color are per-draw data, so the
+// program must be a variant built with INSTANCED.
+void addDraw(Mesh *mesh, Matrix4 *transform, Color color)
+{
+    if (g.drawCount == 0)
+    {
+        alignStreamBuffer(&g.instances, g.instanceAlignment);
+    }
+    check(g.drawCount < MAX_FRAME_DRAWS, "too many draws in one frame");
+
+    DrawInstance *instance = appendStreamBuffer(&g.instances, sizeof(DrawInstance));
+    instance->transform = *transform;
+    instance->color = color;
+
+    // Instances are numbered from the start of this list's data:
+    setDrawCommand(&g.drawList[g.drawCount++], mesh, instance - (DrawInstance *)(g.instances.data + g.instances.start));
+}
+
+// Queues one draw of `count` copies of a mesh for the next submitDraws, and returns their per-draw
+// data for the caller to fill in. Like addDraw, the program must be a variant built with
+// INSTANCED.
+DrawInstance *addInstancedDraw(Mesh *mesh, size_t count)
+{
+    if (g.drawCount == 0)
+    {
+        alignStreamBuffer(&g.instances, g.instanceAlignment);
+    }
+    check(g.drawCount < MAX_FRAME_DRAWS, "too many draws in one frame");
+
+    DrawInstance *instances = appendStreamBuffer(&g.instances, count * sizeof(DrawInstance));
+    DrawCommand *command = &g.drawList[g.drawCount++];
+    setDrawCommand(command, mesh, instances - (DrawInstance *)(g.instances.data + g.instances.start));
+    command->instanceCount = mesh ? (GLuint)count : 0;
+    return instances;
+}
+
+// Draws everything queued with addDraw and addInstancedDraw using the bound program.
+void submitDraws()
+{
+    if (g.drawCount == 0)
+    {
+        return;
+    }
+
+    size_t instanceCount = (g.instances.cursor - g.instances.start) / sizeof(DrawInstance);
+    size_t instanceOffset = flushStreamBuffer(&g.instances);
+    size_t commandOffset = 0;
+    if (g.multiDrawIndirect)
+    {
+        memcpy(appendStreamBuffer(&g.commands, g.drawCount * sizeof(DrawCommand)), g.drawList, g.drawCount * sizeof(DrawCommand));
+        commandOffset = flushStreamBuffer(&g.commands);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, g.commands.buffer);
+    }
+    if (g.drawID)
+    {
+        bindDrawData(g.instanceTexture, g.instances.buffer, instanceOffset, instanceCount);
+    }
+
+    issueDraws(g.drawList, g.drawCount, g.instances.buffer, instanceOffset, commandOffset);
+
+    g.drawCount = 0;
+}
+
+// Call once per frame, after the last draw. Waits until the GPU is done with the stream buffer
+// region that the next frame will write to.
+void endRenderFrame()
+{
+    check(g.drawCount == 0, "draws were added but not submitted");
+
+    g.frameFences[g.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    g.frame = (g.frame + 1) % STREAM_FRAMES;
+
+    GLsync fence = g.frameFences[g.frame];
+    if (fence)
+    {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(fence);
+        g.frameFences[g.frame] = NULL;
+    }
+
+    resetStreamBuffer(&g.instances);
+    resetStreamBuffer(&g.commands);
+}
+
+//=============================================================================================
+// Draw sets
+//=============================================================================================
+
+// Grows a range of changed items to include one more.
+static void markDirty(size_t *start, size_t *end, size_t index)
+{
+    if (*start >= *end)
+    {
+        *start = index;
+        *end = index + 1;
+    }
+    else
+    {
+        *start = (index < *start) ? index : *start;
+        *end = (index + 1 > *end) ? index + 1 : *end;
+    }
+}
+
+// A draw set keeps its commands and per-draw data in GPU buffers from one frame to the next, so
+// drawing it is a single call no matter how many objects it holds, and only the draws that
+// change are uploaded again.
+void createDrawSet(DrawSet *set, size_t capacity)
+{
+    memset(set, 0, sizeof(*set));
+    set->capacity = capacity;
+    set->commands = xalloc(capacity * sizeof(set->commands[0]));
+    set->instances = xalloc(capacity * sizeof(set->instances[0]));
+    set->instanceBuffer = createBuffer(capacity * sizeof(DrawInstance), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+    if (g.multiDrawIndirect)
+    {
+        set->commandBuffer = createBuffer(capacity * sizeof(DrawCommand), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+    }
+    if (g.drawID)
+    {
+        glGenTextures(1, &set->instanceTexture);
+    }
+}
+
+// Sets a draw in the set; a NULL mesh hides it. The draw is uploaded the next time the set is drawn.
+void setDraw(DrawSet *set, size_t index, Mesh *mesh, Matrix4 *transform, Color color)
+{
+    check(index < set->capacity, "draw set is full");
+    setDrawCommand(&set->commands[index], mesh, index);
+    set->instances[index].transform = *transform;
+    set->instances[index].color = color;
+
+    markDirty(&set->dirtyStart, &set->dirtyEnd, index);
+    if (index >= set->count)
+    {
+        // Fill any gap with draws that are skipped:
+        for (size_t i = set->count; i < index; i++)
+        {
+            setDrawCommand(&set->commands[i], NULL, i);
+        }
+        set->count = index + 1;
+    }
+}
+
+// Moves a draw that is already in the set.
+void setDrawTransform(DrawSet *set, size_t index, Matrix4 *transform)
+{
+    check(index < set->count, "no such draw");
+    set->instances[index].transform = *transform;
+    markDirty(&set->dirtyStart, &set->dirtyEnd, index);
+}
+
+size_t addToDrawSet(DrawSet *set, Mesh *mesh, Matrix4 *transform, Color color)
+{
+    size_t index = set->count;
+    setDraw(set, index, mesh, transform, color);
+    return index;
+}
+
+// Draws the whole set using the bound program, which must be a variant built with INSTANCED.
+void drawDrawSet(DrawSet *set)
+{
+    if (set->dirtyStart < set->dirtyEnd)
+    {
+        size_t start = set->dirtyStart;
+        size_t count = set->dirtyEnd - set->dirtyStart;
+        writeBuffer(set->instanceBuffer, start * sizeof(DrawInstance), count * sizeof(DrawInstance), &set->instances[start]);
+        if (g.multiDrawIndirect)
+        {
+            writeBuffer(set->commandBuffer, start * sizeof(DrawCommand), count * sizeof(DrawCommand), &set->commands[start]);
+        }
+        set->dirtyStart = set->dirtyEnd = 0;
+    }
+    if (set->count == 0)
+    {
+        return;
+    }
+
+    if (g.multiDrawIndirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, set->commandBuffer);
+    }
+    if (g.drawID)
+    {
+        bindDrawData(set->instanceTexture, set->instanceBuffer, 0, set->count);
+    }
+
+    issueDraws(set->commands, set->count, set->instanceBuffer, 0, 0);
+}
+
+//=============================================================================================
+// Cull sets
+//=============================================================================================
+
+// Extracts the planes of the view frustum from a world-to-clip transform, normalized so that a
+// point's distance from each plane is positive inside the frustum.
+static void frustumPlanes(Matrix4 *viewProjection, Vector4 planes[6])
+{
+    float *e = viewProjection->e;
+    for (int i = 0; i < 6; i++)
+    {
+        // Each plane is the w row plus or minus the x, y or z row:
+        int row = i / 2;
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        Vector4 p =
+        {
+            e[3] + sign * e[row],
+            e[7] + sign * e[4 + row],
+            e[11] + sign * e[8 + row],
+            e[15] + sign * e[12 + row],
+        };
+        float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+        planes[i] = (Vector4){ p.x / length, p.y / length, p.z / length, p.w / length };
+    }
+}
+
+// Returns the level of detail to draw the object with, or -1 if it should not be drawn.
+static int cullObject(CullSet *set, Vector4 bounds, Vector4 planes[6], Vector3 cameraPosition)
+{
+    if (bounds.w <= 0)
+    {
+        return -1;
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        if (planes[i].x * bounds.x + planes[i].y * bounds.y + planes[i].z * bounds.z + planes[i].w < -bounds.w)
+        {
+            return -1;
+        }
+    }
+
+    Vector3 d = { bounds.x - cameraPosition.x, bounds.y - cameraPosition.y, bounds.z - cameraPosition.z };
+    float distance = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+    for (int lod = 0; lod < set->lodCount; lod++)
+    {
+        if (distance < set->lodDistances[lod])
+        {
+            return lod;
+        }
+    }
+    return -1;
+}
+
+// A cull set holds objects whose visibility and level of detail are decided every frame: on the
+// GPU with a compute shader that writes indirect commands when the context has one, and otherwise
+// on the CPU. Level i is used for objects closer than lodDistances[i]; objects beyond the last
+// distance are not drawn.
+void createCullSet(CullSet *set, size_t capacity, Mesh *lods, float *lodDistances, int lodCount)
+{
+    check(lodCount >= 1 && lodCount <= MAX_LODS, "bad level of detail count");
+    memset(set, 0, sizeof(*set));
+    set->capacity = capacity;
+    set->objects = xalloc(capacity * sizeof(set->objects[0]));
+    set->lodCount = lodCount;
+    for (int i = 0; i < lodCount; i++)
+    {
+        set->lods[i] = lods[i];
+        set->lodDistances[i] = lodDistances[i];
+    }
+
+    if (g.computeCulling)
+    {
+        if (!g.cullShader)
+        {
+            g.cullShader = requestComputeVariant("cull.c.glsl", "");
+        }
+
+        set->objectBuffer = createBuffer(capacity * sizeof(CullObject), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+        set->commandBuffer = createBuffer(capacity * sizeof(DrawCommand), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+        set->instanceBuffer = createBuffer(capacity * sizeof(DrawInstance), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+        set->counterBuffer = createBuffer(sizeof(GLuint), NULL, GL_DYNAMIC_STORAGE_BIT, GL_DYNAMIC_DRAW);
+        if (g.drawID)
+        {
+            glGenTextures(1, &set->instanceTexture);
+        }
+    }
+}
+
+// Sets an object's draw and the radius of a sphere around its origin that contains it. A radius
+// of zero removes the object.
+void setCullObject(CullSet *set, size_t index, Matrix4 *transform, Color color, float radius)
+{
+    check(index < set->capacity, "cull set is full");
+    CullObject *object = &set->objects[index];
+    object->instance.transform = *transform;
+    object->instance.color = color;
+    object->bounds = (Vector4){ transform->e[12], transform->e[13], transform->e[14], radius };
+
+    markDirty(&set->dirtyStart, &set->dirtyEnd, index);
+    if (index >= set->count)
+    {
+        set->count = index + 1;
+    }
+}
+
+// Moves an object that is already in the set, keeping its radius.
+void setCullObjectTransform(CullSet *set, size_t index, Matrix4 *transform)
+{
+    check(index < set->count, "no such cull object");
+    CullObject *object = &set->objects[index];
+    object->instance.transform = *transform;
+    object->bounds.x = transform->e[12];
+    object->bounds.y = transform->e[13];
+    object->bounds.z = transform->e[14];
+    markDirty(&set->dirtyStart, &set->dirtyEnd, index);
+}
+
+size_t addToCullSet(CullSet *set, Matrix4 *transform, Color color, float radius)
+{
+    size_t index = set->count;
+    setCullObject(set, index, transform, color, radius);
+    return index;
+}
+
+// Culls the set and draws what is left using the bound program, which must be a variant built
+// with INSTANCED.
+void drawCullSet(CullSet *set, Matrix4 *viewProjection, Vector3 cameraPosition)
+{
+    if (set->count == 0)
+    {
+        return;
+    }
+
+    Vector4 planes[6];
+    frustumPlanes(viewProjection, planes);
+
+    // The CPU also fills in while the culling program is still being built:
+    if (!g.computeCulling || !isShaderProgramReady(g.cullShader))
+    {
+        for (size_t i = 0; i < set->count; i++)
+        {
+            CullObject *object = &set->objects[i];
+            int lod = cullObject(set, object->bounds, planes, cameraPosition);
+            if (lod >= 0)
+            {
+                addDraw(&set->lods[lod], &object->instance.transform, object->instance.color);
+            }
+        }
+        submitDraws();
+        return;
+    }
+
+    if (set->dirtyStart < set->dirtyEnd)
+    {
+        size_t start = set->dirtyStart;
+        size_t count = set->dirtyEnd - set->dirtyStart;
+        writeBuffer(set->objectBuffer, start * sizeof(CullObject), count * sizeof(CullObject), &set->objects[start]);
+        set->dirtyStart = set->dirtyEnd = 0;
+    }
+
+    // The shader packs the visible objects' commands at the start of the buffer and counts them.
+    // Without indirect parameters every command is drawn, and the ones it does not write stay
+    // zero, which draws nothing:
+    if (!g.indirectCount)
+    {
+        clearBuffer(set->commandBuffer);
+    }
+    clearBuffer(set->counterBuffer);
+
+    GLuint drawProgram = getCurrentProgram();
+    useShaderProgram(g.cullShader);
+
+    GLint lodMeshes[MAX_LODS][3];
+    for (int i = 0; i < set->lodCount; i++)
+    {
+        lodMeshes[i][0] = (GLint)set->lods[i].primitiveCount;
+        lodMeshes[i][1] = (GLint)set->lods[i].firstIndex;
+        lodMeshes[i][2] = set->lods[i].baseVertex;
+    }
+    setUniformUint(UNIFORM_OBJECT_COUNT, (GLuint)set->count);
+    setUniformFloats(UNIFORM_FRUSTUM, 4, 6, &planes[0].x);
+    setUniformVector3(UNIFORM_CAMERA_POSITION, cameraPosition);
+    setUniformInt(UNIFORM_LOD_COUNT, set->lodCount);
+    setUniformFloats(UNIFORM_LOD_DISTANCE, 1, set->lodCount, set->lodDistances);
+    setUniformInts(UNIFORM_LOD_MESH, 3, set->lodCount, &lodMeshes[0][0]);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OBJECT_BINDING, set->objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_BINDING, set->commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCE_BINDING, set->instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COUNTER_BINDING, set->counterBuffer);
+    glDispatchCompute((GLuint)((set->count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+
+    // The draw reads the shader's output as commands and a count, as vertex attributes or as a
+    // texture:
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    useProgram(drawProgram);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, set->commandBuffer);
+    if (g.drawID)
+    {
+        bindDrawData(set->instanceTexture, set->instanceBuffer, 0, set->count);
+    }
+    if (g.indirectCount)
+    {
+        glBindVertexArray(g.vao);
+        if (!g.drawID)
+        {
+            attachInstances(set->instanceBuffer, 0);
+        }
+        glBindBuffer(GL_PARAMETER_BUFFER, set->counterBuffer);
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_SHORT, NULL, 0, (GLsizei)set->count, 0);
+        // Mesa draws later indirect draws wrong while a parameter buffer is still bound:
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+    else
+    {
+        issueDraws(NULL, set->count, set->instanceBuffer, 0, 0);
+    }
+}
@@ -0,0 +1,201 @@
+#include "common.h"
+#include <string.h>
+
+// How many frames the simulation can get ahead of the frame being drawn:
+#define FRAME_PACKETS 2
+// Room for the instances of a full frame of draws, plus the modes' own data:
+#define PACKET_ARENA_SIZE (16 * 1024 * 1024)
+#define PACKET_ALIGNMENT 16
+
+static struct renderThreadGlobals
+{
+    SDL_Window *window;
+    SDL_GLContext context;
+    FrameFunction render;
+    bool threaded;
+    SDL_Thread *thread;
+
+    // Packet n is packets[n % FRAME_PACKETS]. Both counts only go up, and are guarded by the lock:
+    FramePacket packets[FRAME_PACKETS];
+    uint64_t submitted, drawn;
+    bool stopping;
+    SDL_mutex *lock;
+    SDL_cond *changed;
+} g;
+
+//=============================================================================================
+// Packets
+//=============================================================================================
+
+// The memory lasts until the packet is reused, so nothing on the render side should keep a
+// pointer into it.
+void *allocatePacketData(FramePacket *packet, size_t size)
+{
+    size_t start = (packet->used + PACKET_ALIGNMENT - 1) & ~(size_t)(PACKET_ALIGNMENT - 1);
+    check(start <= packet->capacity && size <= packet->capacity - start, "frame packet is full");
+    packet->used = start + size;
+    return packet->arena + start;
+}
+
+// Records an instanced draw of `count` instances; fill them in before submitting the packet.
+DrawInstance *addPacketDraw(FramePacket *packet, Mesh *mesh, size_t count)
+{
+    check(packet->drawCount < MAX_PACKET_DRAWS, "too many draws in one frame packet");
+    PacketDraw *draw = &packet->draws[packet->drawCount++];
+    draw->mesh = mesh;
+    draw->count = count;
+    draw->instances = allocatePacketData(packet, count * sizeof(DrawInstance));
+    return draw->instances;
+}
+
+// Queues the packet's draws for the next submitDraws, on the render thread.
+void queuePacketDraws(FramePacket *packet)
+{
+    for (int i = 0; i < packet->drawCount; i++)
+    {
+        PacketDraw *draw = &packet->draws[i];
+        memcpy(addInstancedDraw(draw->mesh, draw->count), draw->instances, draw->count * sizeof(DrawInstance));
+    }
+}
+
+//=============================================================================================
+// Render thread
+//=============================================================================================
+
+static void drawFrame(FramePacket *packet)
+{
+    updateShaderHotReload();
+    g.render(packet);
+    endRenderFrame();
+
+    // Everything in the packet has been read, so the simulation can have it back before the swap,
+    // which can block for most of a frame:
+    if (g.threaded)
+    {
+        SDL_LockMutex(g.lock);
+        g.drawn++;
+        SDL_CondBroadcast(g.changed);
+        SDL_UnlockMutex(g.lock);
+    }
+    else
+    {
+        g.drawn++;
+    }
+
+    SDL_GL_SwapWindow(g.window);
+}
+
+static int runRenderThread(void *data)
+{
+    UNUSED(data);
+    check(SDL_GL_MakeCurrent(g.window, g.context) == 0, "SDL_GL_MakeCurrent");
+    for (;;)
+    {
+        SDL_LockMutex(g.lock);
+        while (g.drawn == g.submitted && !g.stopping)
+        {
+            SDL_CondWait(g.changed, g.lock);
+        }
+        bool done = (g.drawn == g.submitted);
+        SDL_UnlockMutex(g.lock);
+
+        if (done)
+        {
+            break;
+        }
+        // Only this thread changes the drawn count:
+        drawFrame(&g.packets[g.drawn % FRAME_PACKETS]);
+    }
+    SDL_GL_MakeCurrent(g.window, NULL);
+    return 0;
+}
+
+// From here on, the GL context belongs to the render thread, which calls `render` with each packet
+// and then swaps. The context must be current on the calling thread. If `threaded` is false, the
+// frames are drawn on this thread instead, as each packet is submitted.
+void startRenderThread(SDL_Window *window, SDL_GLContext context, FrameFunction render, bool threaded)
+{
+    check(!g.render, "the render thread is already started");
+    g.window = window;
+    g.context = context;
+    g.render = render;
+    g.threaded = threaded;
+
+    for (int i = 0; i < FRAME_PACKETS; i++)
+    {
+        g.packets[i].arena = xalloc(PACKET_ARENA_SIZE);
+        g.packets[i].capacity = PACKET_ARENA_SIZE;
+    }
+
+    if (threaded)
+    {
+        g.lock = SDL_CreateMutex();
+        check(g.lock != NULL, "SDL_CreateMutex");
+        g.changed = SDL_CreateCond();
+        check(g.changed != NULL, "SDL_CreateCond");
+
+        // A context can only be current on one thread at a time:
+        check(SDL_GL_MakeCurrent(window, NULL) == 0, "SDL_GL_MakeCurrent");
+        g.thread = SDL_CreateThread(runRenderThread, "render", NULL);
+        check(g.thread != NULL, "SDL_CreateThread");
+    }
+}
+
+// Draws whatever has been submitted and waits for the render thread to finish.
+void stopRenderThread()
+{
+    if (g.thread)
+    {
+        SDL_LockMutex(g.lock);
+        g.stopping = true;
+        SDL_CondBroadcast(g.changed);
+        SDL_UnlockMutex(g.lock);
+
+        SDL_WaitThread(g.thread, NULL);
+        g.thread = NULL;
+    }
+}
+
+//=============================================================================================
+// Simulation thread
+//=============================================================================================
+
+// Returns an empty packet, once one is free. This is what keeps the simulation from getting more
+// than FRAME_PACKETS frames ahead of the screen.
+FramePacket *beginFramePacket()
+{
+    if (g.threaded)
+    {
+        SDL_LockMutex(g.lock);
+        while (g.submitted - g.drawn >= FRAME_PACKETS)
+        {
+            SDL_CondWait(g.changed, g.lock);
+        }
+        SDL_UnlockMutex(g.lock);
+    }
+
+    // Only this thread changes the submitted count:
+    FramePacket *packet = &g.packets[g.submitted % FRAME_PACKETS];
+    packet->data = NULL;
+    packet->drawCount = 0;
+    packet->used = 0;
+    return packet;
+}
+
+// Hands the packet to the render thread, which draws the packets in the order they came.
+void submitFramePacket(FramePacket *packet)
+{
+    check(packet == &g.packets[g.submitted % FRAME_PACKETS], "frame packets must be submitted in order");
+    if (g.threaded)
+    {
+        SDL_LockMutex(g.lock);
+        g.submitted++;
+        SDL_CondBroadcast(g.changed);
+        SDL_UnlockMutex(g.lock);
+    }
+    else
+    {
+        g.submitted++;
+        drawFrame(packet);
+    }
+}
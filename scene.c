@@ -0,0 +1,136 @@
+#include "common.h"
+#include <string.h>
+
+//=============================================================================================
+// Scenes
+//=============================================================================================
+
+// Each node has a transform relative to its parent, and a world transform that is only worked
+// out again when it or one of its ancestors changes. Because parents come before their children,
+// one pass in order is enough to bring every world transform up to date. A scene that does not
+// change costs nothing to update.
+void createScene(Scene *scene, size_t capacity)
+{
+    memset(scene, 0, sizeof(*scene));
+    scene->capacity = capacity;
+    scene->parents = xalloc(capacity * sizeof(scene->parents[0]));
+    scene->positions = xalloc(capacity * sizeof(scene->positions[0]));
+    scene->rotations = xalloc(capacity * sizeof(scene->rotations[0]));
+    scene->scales = xalloc(capacity * sizeof(scene->scales[0]));
+    scene->worlds = xalloc(capacity * sizeof(scene->worlds[0]));
+    scene->dirty = xalloc(capacity * sizeof(scene->dirty[0]));
+    scene->updated = xalloc(capacity * sizeof(scene->updated[0]));
+    scene->draws = xalloc(capacity * sizeof(scene->draws[0]));
+}
+
+static void markNodeDirty(Scene *scene, size_t node)
+{
+    scene->dirty[node] = true;
+    if (node < scene->firstDirty)
+    {
+        scene->firstDirty = node;
+    }
+}
+
+static void updateWorld(Scene *scene, size_t node)
+{
+    Matrix4 local = matrixTRS(scene->positions[node], scene->rotations[node], scene->scales[node]);
+    int32_t parent = scene->parents[node];
+    if (parent < 0)
+    {
+        scene->worlds[node] = local;
+    }
+    else
+    {
+        matrixMultiplyTo(&scene->worlds[node], &local, &scene->worlds[parent]);
+    }
+}
+
+// Adds a node under `parent`, which must already be in the scene, or -1 for none. Its world
+// transform is ready to read right away.
+size_t addSceneNode(Scene *scene, int32_t parent, Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    check(scene->count < scene->capacity, "scene is full");
+    check(parent < (int32_t)scene->count, "a scene node's parent must come before it");
+    size_t node = scene->count++;
+    scene->parents[node] = parent;
+    scene->positions[node] = position;
+    scene->rotations[node] = rotation;
+    scene->scales[node] = scale;
+    scene->draws[node] = (SceneDraw){ NULL, NULL, 0 };
+    updateWorld(scene, node);
+    // If the parent is still waiting for an update, this node is too:
+    scene->dirty[node] = false;
+    scene->updated[node] = scene->updateCount;
+    if (parent >= 0 && scene->dirty[parent])
+    {
+        markNodeDirty(scene, node);
+    }
+    else if (scene->firstDirty == node)
+    {
+        scene->firstDirty = node + 1;
+    }
+    return node;
+}
+
+void setSceneNode(Scene *scene, size_t node, Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    scene->positions[node] = position;
+    scene->rotations[node] = rotation;
+    scene->scales[node] = scale;
+    markNodeDirty(scene, node);
+}
+
+void setSceneNodePosition(Scene *scene, size_t node, Vector3 position)
+{
+    scene->positions[node] = position;
+    markNodeDirty(scene, node);
+}
+
+// The node's world transform is copied into the draw whenever it changes, starting now.
+void attachSceneDraw(Scene *scene, size_t node, DrawSet *set, size_t index)
+{
+    scene->draws[node] = (SceneDraw){ set, NULL, index };
+    setDrawTransform(set, index, &scene->worlds[node]);
+}
+
+void attachSceneCullObject(Scene *scene, size_t node, CullSet *set, size_t index)
+{
+    scene->draws[node] = (SceneDraw){ NULL, set, index };
+    setCullObjectTransform(set, index, &scene->worlds[node]);
+}
+
+// Updates the world transforms of the dirty nodes and everything below them, and passes them on
+// to the draws they are attached to.
+void updateScene(Scene *scene)
+{
+    if (scene->firstDirty >= scene->count)
+    {
+        return;
+    }
+
+    uint32_t update = ++scene->updateCount;
+    for (size_t node = scene->firstDirty; node < scene->count; node++)
+    {
+        int32_t parent = scene->parents[node];
+        if (!scene->dirty[node] && (parent < 0 || scene->updated[parent] != update))
+        {
+            continue;
+        }
+
+        updateWorld(scene, node);
+        scene->dirty[node] = false;
+        scene->updated[node] = update;
+
+        SceneDraw *draw = &scene->draws[node];
+        if (draw->drawSet)
+        {
+            setDrawTransform(draw->drawSet, draw->index, &scene->worlds[node]);
+        }
+        else if (draw->cullSet)
+        {
+            setCullObjectTransform(draw->cullSet, draw->index, &scene->worlds[node]);
+        }
+    }
+    scene->firstDirty = scene->count;
+}
@@ -0,0 +1,1263 @@
+#include "common.h"
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define SHADER_DIRECTORY "shaders/"
+#define MAX_SHADER_VARIANTS 64
+#define MAX_SHADER_FILES 8
+#define MAX_INCLUDE_DEPTH 8
+#define MAX_FEEDBACK_VARYINGS 8
+// Both are powers of two:
+#define PROGRAM_TABLE_SIZE 256
+#define UNIFORM_NAME_TABLE_SIZE 64
+// Validates each program as it is linked and logs the result. This slows down startup:
+#define VALIDATE_SHADERS false
+
+#define PROGRAM_CACHE_MAGIC 0x50435353 // "SSCP"
+#define PROGRAM_CACHE_VERSION 1
+
+typedef struct ProgramCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+} ProgramCacheHeader;
+
+// The files a program was built from, for hot reload.
+typedef struct ShaderFileList
+{
+    char names[MAX_SHADER_FILES][64];
+    int count;
+} ShaderFileList;
+
+// Compute variants only have a vertexShaderName, which is the name of the compute shader.
+// Transform feedback variants have no fragment shader, and capture feedbackVaryings instead.
+typedef struct ShaderVariant
+{
+    uint64_t key;
+    bool compute;
+    char vertexShaderName[64];
+    char fragmentShaderName[64];
+    char feedbackVaryings[64];
+    char defines[128];
+    ShaderProgram shader;
+
+    ShaderFileList files;
+    ShaderProgram reload;
+    bool reloading;
+} ShaderVariant;
+
+typedef struct UniformSlot
+{
+    // The location, or the block index for a uniform block; -1 if the program does not use it:
+    GLint location;
+    bool block;
+    // The type the setters must use, which is GL_INT for samplers and booleans:
+    GLenum type;
+    GLint arraySize;
+    // Where the last value is kept, and how much of it has been set so far:
+    uint32_t valueOffset, valueSize, knownSize;
+} UniformSlot;
+
+// The uniforms of a program, found when it is first bound, and the values it was last given.
+// Deleted programs leave their entry in the table with a zero program, to be reused.
+typedef struct ProgramUniforms
+{
+    GLuint program;
+    UniformSlot slots[UNIFORM_COUNT];
+    uint8_t *values;
+} ProgramUniforms;
+
+typedef struct TextBuilder
+{
+    char *text;
+    size_t length, capacity;
+} TextBuilder;
+
+static struct shaderGlobals
+{
+    bool started;
+    bool parallelCompile;
+    GLuint placeholder;
+
+    bool cacheEnabled;
+    char *cacheDirectory;
+    uint64_t driverHash;
+
+    ShaderVariant variants[MAX_SHADER_VARIANTS];
+    int variantCount;
+    char commonDefines[64];
+
+    bool hotReload;
+    int watchFile;
+
+    ProgramUniforms *programs[PROGRAM_TABLE_SIZE];
+    int programCount;
+    // Uniform numbers plus one, by the hash of their names:
+    int uniformNameTable[UNIFORM_NAME_TABLE_SIZE];
+    bool uniformNamesReady;
+    GLuint currentProgram;
+    ProgramUniforms *currentUniforms;
+} g;
+
+// The names of the UNIFORM_* numbers in the shaders:
+static char *UniformNames[UNIFORM_COUNT] =
+{
+    [UNIFORM_PROJECTION] = "uniProjection",
+    [UNIFORM_MODEL_TRANSFORM] = "uniModelTransform",
+    [UNIFORM_MODEL_COLOR] = "uniModelColor",
+    [UNIFORM_AMBIENT_LIGHT] = "uniAmbientLight",
+    [UNIFORM_DRAW_DATA] = "uniDrawData",
+    [UNIFORM_OBJECT_COUNT] = "uniObjectCount",
+    [UNIFORM_FRUSTUM] = "uniFrustum",
+    [UNIFORM_CAMERA_POSITION] = "uniCameraPosition",
+    [UNIFORM_LOD_COUNT] = "uniLodCount",
+    [UNIFORM_LOD_DISTANCE] = "uniLodDistance",
+    [UNIFORM_LOD_MESH] = "uniLodMesh",
+    [UNIFORM_TIME_STEP] = "uniTimeStep",
+    [UNIFORM_SEED] = "uniSeed",
+    [UNIFORM_EMITTER_COUNT] = "uniEmitterCount",
+    [UNIFORM_EMITTER_POSITION] = "uniEmitterPosition",
+    [UNIFORM_EMITTER_VELOCITY] = "uniEmitterVelocity",
+    [UNIFORM_EMITTER_COLOR] = "uniEmitterColor",
+    [UNIFORM_EMITTER_LIFE] = "uniEmitterLife",
+    [UNIFORM_GRAVITY] = "uniGravity",
+    [UNIFORM_ATTRACTOR_COUNT] = "uniAttractorCount",
+    [UNIFORM_ATTRACTOR] = "uniAttractor",
+    [UNIFORM_CAMERA_RIGHT] = "uniCameraRight",
+    [UNIFORM_CAMERA_UP] = "uniCameraUp",
+    [UNIFORM_PARTICLE_SIZE] = "uniParticleSize",
+};
+
+static char PlaceholderVertexShader[] =
+    "#version 330\n"
+    "uniform mat4 uniProjection;\n"
+    "uniform mat4 uniModelTransform;\n"
+    "layout(location = 0) in vec4 inPosition;\n"
+    "void main() {\n"
+    "    gl_Position = uniProjection * uniModelTransform * vec4(inPosition.xyz, 1.0);\n"
+    "}\n";
+
+static char PlaceholderFragmentShader[] =
+    "#version 330\n"
+    "uniform vec4 uniModelColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = uniModelColor;\n"
+    "}\n";
+
+//=============================================================================================
+// Program binary cache
+//=============================================================================================
+
+static void startProgramCache()
+{
+    GLint formatCount = 0;
+    if (GLSupported.ARB_get_program_binary)
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+
+    g.cacheDirectory = SDL_GetPrefPath("holmak", "screensavers");
+    g.cacheEnabled = (formatCount > 0) && (g.cacheDirectory != NULL);
+    if (!g.cacheEnabled)
+    {
+        return;
+    }
+
+    // A binary is only usable with the exact driver that produced it:
+    uint64_t hash = HASH_SEED;
+    hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+    hash = hashString(hash, (const char *)glGetString(GL_SHADING_LANGUAGE_VERSION));
+    g.driverHash = hash;
+}
+
+static uint64_t programCacheKey(char *vertexShaderSource, char *fragmentShaderSource)
+{
+    uint64_t key = g.driverHash;
+    key = hashString(key, vertexShaderSource);
+    // Include the terminator so the boundary between the two sources is part of the key:
+    key = hashBytes(key, "", 1);
+    key = hashString(key, fragmentShaderSource);
+    return key;
+}
+
+static void programCachePath(char *path, size_t size, uint64_t key)
+{
+    snprintf(path, size, "%sprogram-%016llx.bin", g.cacheDirectory, (unsigned long long)key);
+}
+
+// Returns zero if there is no usable cached binary for this key.
+static GLuint loadCachedProgram(uint64_t key)
+{
+    char path[1024];
+    programCachePath(path, sizeof(path), key);
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        return 0;
+    }
+
+    ProgramCacheHeader header;
+    void *binary = NULL;
+    GLuint program = 0;
+    if (fread(&header, sizeof(header), 1, f) == 1 &&
+        header.magic == PROGRAM_CACHE_MAGIC &&
+        header.version == PROGRAM_CACHE_VERSION &&
+        header.key == key &&
+        header.binaryLength > 0)
+    {
+        binary = xalloc(header.binaryLength);
+        if (fread(binary, header.binaryLength, 1, f) == 1)
+        {
+            program = glCreateProgram();
+            glProgramBinary(program, header.binaryFormat, binary, header.binaryLength);
+
+            // Drivers may reject binaries after an update even if the version string is unchanged:
+            GLint success;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+    }
+
+    free(binary);
+    fclose(f);
+    return program;
+}
+
+static void saveCachedProgram(GLuint program, uint64_t key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    ProgramCacheHeader header = { PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, key, 0, 0 };
+    void *binary = xalloc(length);
+    GLenum format;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary);
+    header.binaryFormat = format;
+    header.binaryLength = written;
+
+    // Write to a temporary file first so that a crash never leaves a truncated cache entry:
+    char path[1024], tempPath[1040];
+    programCachePath(path, sizeof(path), key);
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE *f = fopen(tempPath, "wb");
+    if (f)
+    {
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(binary, written, 1, f) == 1;
+        ok = (fclose(f) == 0) && ok;
+        remove(path);
+        if (!ok || rename(tempPath, path) != 0)
+        {
+            remove(tempPath);
+        }
+    }
+
+    free(binary);
+}
+
+//=============================================================================================
+// Compiling and linking
+//=============================================================================================
+
+static bool printShaderLog(
+    GLuint object, char *label,
+    GLPROC_glGetShaderiv get, GLenum status,
+    GLPROC_glGetShaderInfoLog getLog)
+{
+    GLint success;
+    get(object, status, &success);
+    if (!success)
+    {
+        fprintf(GLLog, "compiled/linked %s: FAILED\n", label);
+    }
+
+    static char errors[4096];
+    GLsizei length;
+    getLog(object, sizeof(errors), &length, errors);
+    if (length > 0)
+    {
+        fprintf(GLLog, "%s: %s\n\n", label, errors);
+    }
+
+    fflush(GLLog);
+    return success;
+}
+
+static GLuint startShaderCompile(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+// Issues the link without asking for the result, so the driver is free to finish it in the background.
+static GLuint startProgramLink(ShaderProgram *shader, char *feedbackVaryings)
+{
+    GLuint program = glCreateProgram();
+    GLuint stages[] = { shader->vertexShader, shader->fragmentShader, shader->computeShader };
+    for (int i = 0; i < (int)COUNTOF(stages); i++)
+    {
+        if (stages[i])
+        {
+            glAttachShader(program, stages[i]);
+        }
+    }
+    if (feedbackVaryings)
+    {
+        // Space-separated, like shader defines:
+        char names[256];
+        const char *varyings[MAX_FEEDBACK_VARYINGS];
+        int count = 0;
+        check(strlen(feedbackVaryings) < sizeof(names), "too many transform feedback varyings");
+        strcpy(names, feedbackVaryings);
+        for (char *name = strtok(names, " "); name; name = strtok(NULL, " "))
+        {
+            check(count < MAX_FEEDBACK_VARYINGS, "too many transform feedback varyings");
+            varyings[count++] = name;
+        }
+        glTransformFeedbackVaryings(program, count, varyings, GL_INTERLEAVED_ATTRIBS);
+    }
+    if (g.cacheEnabled)
+    {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+// Blocks until the compile and link are done, unless the completion query already said they are.
+// On failure the program is deleted and the errors are in the GL log.
+static bool finishProgramLink(ShaderProgram *shader)
+{
+    GLuint program = shader->pending;
+    GLuint stages[] = { shader->vertexShader, shader->fragmentShader, shader->computeShader };
+    char *stageNames[] = { "vertex shader", "fragment shader", "compute shader" };
+    bool ok = true;
+    for (int i = 0; i < (int)COUNTOF(stages); i++)
+    {
+        if (stages[i])
+        {
+            ok = printShaderLog(stages[i], stageNames[i], glGetShaderiv, GL_COMPILE_STATUS, glGetShaderInfoLog) && ok;
+        }
+    }
+    ok = printShaderLog(program, "program", glGetProgramiv, GL_LINK_STATUS, glGetProgramInfoLog) && ok;
+
+    // Validation depends on the GL state at the time of the call, so it is only a debugging aid and
+    // a failure is only logged:
+    if (VALIDATE_SHADERS && ok)
+    {
+        glValidateProgram(program);
+        printShaderLog(program, "program validation", glGetProgramiv, GL_VALIDATE_STATUS, glGetProgramInfoLog);
+    }
+
+    for (int i = 0; i < (int)COUNTOF(stages); i++)
+    {
+        if (stages[i])
+        {
+            glDetachShader(program, stages[i]);
+            glDeleteShader(stages[i]);
+        }
+    }
+    shader->vertexShader = 0;
+    shader->fragmentShader = 0;
+    shader->computeShader = 0;
+
+    shader->pending = 0;
+    if (!ok)
+    {
+        glDeleteProgram(program);
+        return false;
+    }
+
+    if (g.cacheEnabled)
+    {
+        saveCachedProgram(program, shader->cacheKey);
+    }
+
+    shader->program = program;
+    return true;
+}
+
+//=============================================================================================
+// Programs
+//=============================================================================================
+
+static void startShaderPrograms()
+{
+    g.started = true;
+    startProgramCache();
+
+    g.parallelCompile = GLSupported.KHR_parallel_shader_compile;
+    if (g.parallelCompile)
+    {
+        // Let the driver pick how many threads to use:
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+}
+
+void requestShaderProgram(ShaderProgram *shader, char *vertexShaderSource, char *fragmentShaderSource)
+{
+    if (!g.started)
+    {
+        startShaderPrograms();
+    }
+
+    memset(shader, 0, sizeof(*shader));
+
+    if (g.cacheEnabled)
+    {
+        shader->cacheKey = programCacheKey(vertexShaderSource, fragmentShaderSource);
+        shader->program = loadCachedProgram(shader->cacheKey);
+        if (shader->program)
+        {
+            return;
+        }
+    }
+
+    shader->vertexShader = startShaderCompile(GL_VERTEX_SHADER, vertexShaderSource);
+    shader->fragmentShader = startShaderCompile(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    shader->pending = startProgramLink(shader, NULL);
+}
+
+// Needs ARB_compute_shader.
+void requestComputeProgram(ShaderProgram *shader, char *computeShaderSource)
+{
+    if (!g.started)
+    {
+        startShaderPrograms();
+    }
+
+    memset(shader, 0, sizeof(*shader));
+
+    if (g.cacheEnabled)
+    {
+        shader->cacheKey = programCacheKey(computeShaderSource, "");
+        shader->program = loadCachedProgram(shader->cacheKey);
+        if (shader->program)
+        {
+            return;
+        }
+    }
+
+    shader->computeShader = startShaderCompile(GL_COMPUTE_SHADER, computeShaderSource);
+    shader->pending = startProgramLink(shader, NULL);
+}
+
+// A vertex shader whose outputs are captured with transform feedback instead of being drawn. The
+// space-separated varyings are written, in order, interleaved into the buffer bound to index 0.
+void requestFeedbackProgram(ShaderProgram *shader, char *vertexShaderSource, char *feedbackVaryings)
+{
+    if (!g.started)
+    {
+        startShaderPrograms();
+    }
+
+    memset(shader, 0, sizeof(*shader));
+
+    if (g.cacheEnabled)
+    {
+        // The captured varyings are part of the binary, so they stand in for the fragment shader:
+        shader->cacheKey = programCacheKey(vertexShaderSource, feedbackVaryings);
+        shader->program = loadCachedProgram(shader->cacheKey);
+        if (shader->program)
+        {
+            return;
+        }
+    }
+
+    shader->vertexShader = startShaderCompile(GL_VERTEX_SHADER, vertexShaderSource);
+    shader->pending = startProgramLink(shader, feedbackVaryings);
+}
+
+// Without KHR_parallel_shader_compile there is no way to ask without blocking, so this reports
+// "ready" and the first use waits for the driver.
+bool isShaderProgramReady(ShaderProgram *shader)
+{
+    if (shader->program || !g.parallelCompile)
+    {
+        return true;
+    }
+
+    GLint done;
+    glGetProgramiv(shader->pending, GL_COMPLETION_STATUS_KHR, &done);
+    return done;
+}
+
+GLuint getShaderProgram(ShaderProgram *shader)
+{
+    if (!shader->program)
+    {
+        check(finishProgramLink(shader), "compiling shader/program");
+    }
+    return shader->program;
+}
+
+GLuint compileShaderProgram(char *vertexShaderSource, char *fragmentShaderSource)
+{
+    ShaderProgram shader;
+    requestShaderProgram(&shader, vertexShaderSource, fragmentShaderSource);
+    return getShaderProgram(&shader);
+}
+
+// Binds the program if it has finished building, or else a flat-shaded stand-in that has the same
+// vertex inputs and uniforms. Returns the program that was bound.
+GLuint useShaderProgram(ShaderProgram *shader)
+{
+    if (!isShaderProgramReady(shader))
+    {
+        if (!g.placeholder)
+        {
+            g.placeholder = compileShaderProgram(PlaceholderVertexShader, PlaceholderFragmentShader);
+        }
+        useProgram(g.placeholder);
+        return g.placeholder;
+    }
+
+    GLuint program = getShaderProgram(shader);
+    useProgram(program);
+    return program;
+}
+
+//=============================================================================================
+// Uniforms
+//=============================================================================================
+
+static uint32_t hashProgram(GLuint program)
+{
+    return (uint32_t)hashBytes(HASH_SEED, &program, sizeof(program));
+}
+
+// Returns the UNIFORM_* number for a name, or -1 if there is none.
+static int findUniformName(const char *name)
+{
+    if (!g.uniformNamesReady)
+    {
+        g.uniformNamesReady = true;
+        for (int i = 0; i < UNIFORM_COUNT; i++)
+        {
+            uint64_t h = hashString(HASH_SEED, UniformNames[i]);
+            while (g.uniformNameTable[h & (UNIFORM_NAME_TABLE_SIZE - 1)])
+            {
+                h++;
+            }
+            g.uniformNameTable[h & (UNIFORM_NAME_TABLE_SIZE - 1)] = i + 1;
+        }
+    }
+
+    for (uint64_t h = hashString(HASH_SEED, name);; h++)
+    {
+        int entry = g.uniformNameTable[h & (UNIFORM_NAME_TABLE_SIZE - 1)];
+        if (!entry)
+        {
+            return -1;
+        }
+        if (strcmp(UniformNames[entry - 1], name) == 0)
+        {
+            return entry - 1;
+        }
+    }
+}
+
+static int uniformComponents(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 2;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 3;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: return 4;
+    case GL_FLOAT_MAT2: return 4;
+    case GL_FLOAT_MAT3: return 9;
+    case GL_FLOAT_MAT4: return 16;
+    default: return 1;
+    }
+}
+
+static GLenum uniformSetterType(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+    case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+    case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+    case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+        return type;
+    case GL_BOOL_VEC2: return GL_INT_VEC2;
+    case GL_BOOL_VEC3: return GL_INT_VEC3;
+    case GL_BOOL_VEC4: return GL_INT_VEC4;
+    // Booleans and samplers:
+    default: return GL_INT;
+    }
+}
+
+static void addUniformSlot(ProgramUniforms *uniforms, char *name, GLint location, bool block, GLenum type, GLint arraySize, uint32_t *valuesSize)
+{
+    // Arrays are listed by their first element:
+    char *bracket = strchr(name, '[');
+    if (bracket)
+    {
+        *bracket = '\0';
+    }
+
+    int uniform = findUniformName(name);
+    if (uniform < 0)
+    {
+        fprintf(stderr, "warning: uniform %s has no UNIFORM_* number, so it cannot be set\n", name);
+        return;
+    }
+
+    UniformSlot *slot = &uniforms->slots[uniform];
+    slot->location = location;
+    slot->block = block;
+    slot->type = block ? 0 : uniformSetterType(type);
+    slot->arraySize = arraySize;
+    slot->valueOffset = *valuesSize;
+    slot->valueSize = block ? (uint32_t)sizeof(GLuint) : (uint32_t)(arraySize * uniformComponents(type) * 4);
+    *valuesSize += slot->valueSize;
+}
+
+static void reflectProgram(ProgramUniforms *uniforms, GLuint program)
+{
+    uniforms->program = program;
+    for (int i = 0; i < UNIFORM_COUNT; i++)
+    {
+        uniforms->slots[i] = (UniformSlot){ .location = -1 };
+    }
+
+    uint32_t valuesSize = 0;
+    char name[64];
+    GLsizei length;
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLuint i = 0; i < (GLuint)count; i++)
+    {
+        // Uniforms in blocks are set through the block's buffer:
+        GLint block;
+        glGetActiveUniformsiv(program, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block);
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+        if (block < 0 && strncmp(name, "gl_", 3) != 0)
+        {
+            addUniformSlot(uniforms, name, glGetUniformLocation(program, name), false, type, size, &valuesSize);
+        }
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for (GLuint i = 0; i < (GLuint)count; i++)
+    {
+        glGetActiveUniformBlockName(program, i, sizeof(name), &length, name);
+        addUniformSlot(uniforms, name, i, true, 0, 1, &valuesSize);
+    }
+
+    free(uniforms->values);
+    uniforms->values = xalloc(valuesSize ? valuesSize : 1);
+}
+
+// Finds the program's uniforms, looking them up the first time.
+static ProgramUniforms *getProgramUniforms(GLuint program)
+{
+    ProgramUniforms **reuse = NULL;
+    for (uint32_t i = hashProgram(program);; i++)
+    {
+        ProgramUniforms **entry = &g.programs[i & (PROGRAM_TABLE_SIZE - 1)];
+        if (*entry && (*entry)->program == program)
+        {
+            return *entry;
+        }
+        if (*entry && (*entry)->program == 0 && !reuse)
+        {
+            reuse = entry;
+        }
+        if (!*entry)
+        {
+            if (!reuse)
+            {
+                check(g.programCount < PROGRAM_TABLE_SIZE / 2, "too many shader programs");
+                g.programCount++;
+                *entry = xalloc(sizeof(ProgramUniforms));
+                (*entry)->values = NULL;
+                reuse = entry;
+            }
+            reflectProgram(*reuse, program);
+            return *reuse;
+        }
+    }
+}
+
+static void deleteProgram(GLuint program)
+{
+    for (uint32_t i = hashProgram(program); g.programs[i & (PROGRAM_TABLE_SIZE - 1)]; i++)
+    {
+        ProgramUniforms *uniforms = g.programs[i & (PROGRAM_TABLE_SIZE - 1)];
+        if (uniforms->program == program)
+        {
+            uniforms->program = 0;
+            break;
+        }
+    }
+
+    if (g.currentProgram == program)
+    {
+        g.currentProgram = 0;
+        g.currentUniforms = NULL;
+    }
+    glDeleteProgram(program);
+}
+
+// Binds a program for drawing and for the uniform setters. Use this instead of glUseProgram, which
+// would leave the setters pointing at the previous program.
+void useProgram(GLuint program)
+{
+    if (program == g.currentProgram)
+    {
+        return;
+    }
+    glUseProgram(program);
+    g.currentProgram = program;
+    g.currentUniforms = program ? getProgramUniforms(program) : NULL;
+}
+
+GLuint getCurrentProgram()
+{
+    return g.currentProgram;
+}
+
+// Returns the slot to upload the value to, or NULL if the bound program does not use the uniform
+// or already has this value.
+static UniformSlot *changeUniform(int uniform, GLenum type, int count, const void *value, size_t size)
+{
+    check(g.currentUniforms != NULL, "setting a uniform with no program bound");
+    UniformSlot *slot = &g.currentUniforms->slots[uniform];
+    if (slot->location < 0)
+    {
+        return NULL;
+    }
+    check(slot->type == type && count <= slot->arraySize, "uniform set with the wrong type or size");
+
+    uint8_t *last = g.currentUniforms->values + slot->valueOffset;
+    if (size <= slot->knownSize && memcmp(last, value, size) == 0)
+    {
+        return NULL;
+    }
+    memcpy(last, value, size);
+    slot->knownSize = (size > slot->knownSize) ? (uint32_t)size : slot->knownSize;
+    return slot;
+}
+
+// Sets the first `count` elements of a float, vec2, vec3 or vec4 uniform, which has `components`
+// components per element.
+void setUniformFloats(int uniform, int components, int count, const float *values)
+{
+    GLenum types[] = { GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4 };
+    UniformSlot *slot = changeUniform(uniform, types[components - 1], count, values, count * components * sizeof(float));
+    if (!slot)
+    {
+        return;
+    }
+    switch (components)
+    {
+    case 1: glUniform1fv(slot->location, count, values); break;
+    case 2: glUniform2fv(slot->location, count, values); break;
+    case 3: glUniform3fv(slot->location, count, values); break;
+    case 4: glUniform4fv(slot->location, count, values); break;
+    }
+}
+
+// The same for int, ivec2, ivec3 and ivec4 uniforms, and for samplers.
+void setUniformInts(int uniform, int components, int count, const GLint *values)
+{
+    GLenum types[] = { GL_INT, GL_INT_VEC2, GL_INT_VEC3, GL_INT_VEC4 };
+    UniformSlot *slot = changeUniform(uniform, types[components - 1], count, values, count * components * sizeof(GLint));
+    if (!slot)
+    {
+        return;
+    }
+    switch (components)
+    {
+    case 1: glUniform1iv(slot->location, count, values); break;
+    case 2: glUniform2iv(slot->location, count, values); break;
+    case 3: glUniform3iv(slot->location, count, values); break;
+    case 4: glUniform4iv(slot->location, count, values); break;
+    }
+}
+
+void setUniformFloat(int uniform, float value)
+{
+    setUniformFloats(uniform, 1, 1, &value);
+}
+
+void setUniformInt(int uniform, GLint value)
+{
+    setUniformInts(uniform, 1, 1, &value);
+}
+
+void setUniformUint(int uniform, GLuint value)
+{
+    UniformSlot *slot = changeUniform(uniform, GL_UNSIGNED_INT, 1, &value, sizeof(value));
+    if (slot)
+    {
+        glUniform1ui(slot->location, value);
+    }
+}
+
+void setUniformVector3(int uniform, Vector3 value)
+{
+    setUniformFloats(uniform, 3, 1, &value.x);
+}
+
+void setUniformVector4(int uniform, Vector4 value)
+{
+    setUniformFloats(uniform, 4, 1, &value.x);
+}
+
+void setUniformColor(int uniform, Color value)
+{
+    setUniformFloats(uniform, 4, 1, &value.r);
+}
+
+void setUniformMatrix4(int uniform, Matrix4 *value)
+{
+    UniformSlot *slot = changeUniform(uniform, GL_FLOAT_MAT4, 1, value->e, sizeof(value->e));
+    if (slot)
+    {
+        glUniformMatrix4fv(slot->location, 1, GL_FALSE, value->e);
+    }
+}
+
+void setUniformBlockBinding(int uniform, GLuint binding)
+{
+    check(g.currentUniforms != NULL, "setting a uniform with no program bound");
+    UniformSlot *slot = &g.currentUniforms->slots[uniform];
+    if (slot->location < 0)
+    {
+        return;
+    }
+    check(slot->block, "uniform is not a block");
+
+    GLuint *last = (GLuint *)(g.currentUniforms->values + slot->valueOffset);
+    if (slot->knownSize == 0 || *last != binding)
+    {
+        *last = binding;
+        slot->knownSize = sizeof(binding);
+        glUniformBlockBinding(g.currentProgram, slot->location, binding);
+    }
+}
+
+//=============================================================================================
+// Preprocessor
+//=============================================================================================
+
+static void appendText(TextBuilder *builder, const char *text, size_t length)
+{
+    if (builder->length + length + 1 > builder->capacity)
+    {
+        builder->capacity = 2 * (builder->length + length + 1);
+        builder->text = realloc(builder->text, builder->capacity);
+        check(builder->text != NULL, "realloc");
+    }
+    memcpy(builder->text + builder->length, text, length);
+    builder->length += length;
+    builder->text[builder->length] = '\0';
+}
+
+static void appendFormat(TextBuilder *builder, const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    check(length >= 0 && length < (int)sizeof(line), "shader preprocessor: line too long");
+    appendText(builder, line, length);
+}
+
+static bool preprocessorError(char *name, char *message)
+{
+    fprintf(stderr, "error: %s: %s\n", name, message);
+    return false;
+}
+
+// Each file gets its own GLSL source string number, in include order, so that compiler errors
+// can be traced back to the right file. The numbering is written to the GL log.
+static bool appendShaderFile(TextBuilder *out, char *name, char *defines, int depth, ShaderFileList *files)
+{
+    if (depth >= MAX_INCLUDE_DEPTH)
+    {
+        return preprocessorError(name, "includes nested too deeply");
+    }
+    if (files->count >= MAX_SHADER_FILES || strlen(name) >= sizeof(files->names[0]))
+    {
+        return preprocessorError(name, "too many included files");
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), SHADER_DIRECTORY "%s", name);
+    Asset asset;
+    if (!loadAsset(path, &asset))
+    {
+        return preprocessorError(name, "cannot read file");
+    }
+    const char *source = asset.data;
+
+    int fileNumber = files->count++;
+    strcpy(files->names[fileNumber], name);
+    if (GLLog)
+    {
+        fprintf(GLLog, "shader source %d: %s\n", fileNumber, name);
+    }
+
+    bool ok = true;
+    int lineNumber = 1;
+    for (const char *line = source; *line && ok; lineNumber++)
+    {
+        const char *end = strchr(line, '\n');
+        end = end ? end + 1 : line + strlen(line);
+        const char *directive = line + strspn(line, " \t");
+
+        if (strncmp(directive, "#include", 8) == 0)
+        {
+            const char *open = strchr(directive, '"');
+            const char *close = open ? strchr(open + 1, '"') : NULL;
+            char included[64];
+            size_t includedLength = close ? close - (open + 1) : 0;
+            if (!close || close >= end || includedLength >= sizeof(included))
+            {
+                ok = preprocessorError(name, "malformed #include");
+                break;
+            }
+            memcpy(included, open + 1, includedLength);
+            included[includedLength] = '\0';
+
+            appendFormat(out, "#line 1 %d\n", files->count);
+            ok = appendShaderFile(out, included, NULL, depth + 1, files);
+            appendFormat(out, "#line %d %d\n", lineNumber + 1, fileNumber);
+        }
+        else
+        {
+            appendText(out, line, end - line);
+        }
+
+        // The defines go right after #version, which has to come before anything else:
+        if (defines && strncmp(directive, "#version", 8) == 0)
+        {
+            for (char *d = defines + strspn(defines, " "); *d; d += strspn(d, " "))
+            {
+                int nameLength = (int)strcspn(d, " ");
+                appendFormat(out, "#define %.*s\n", nameLength, d);
+                d += nameLength;
+            }
+            appendFormat(out, "#line %d %d\n", lineNumber + 1, fileNumber);
+        }
+
+        line = end;
+    }
+
+    // Keep directives that follow an included file on their own line:
+    if (out->length > 0 && out->text[out->length - 1] != '\n')
+    {
+        appendText(out, "\n", 1);
+    }
+
+    releaseAsset(&asset);
+    return ok;
+}
+
+// Reads a shader from the shader directory, expanding #include "name" and adding a #define for
+// each space-separated name in `defines`. The result is allocated with malloc. Returns NULL (after
+// printing the reason) if a file is missing or an #include is malformed.
+static char *preprocessShaderFiles(char *name, char *defines, ShaderFileList *files)
+{
+    TextBuilder out = { 0 };
+    if (!appendShaderFile(&out, name, defines, 0, files))
+    {
+        free(out.text);
+        return NULL;
+    }
+    return out.text;
+}
+
+char *preprocessShader(char *name, char *defines)
+{
+    ShaderFileList files = { 0 };
+    return preprocessShaderFiles(name, defines, &files);
+}
+
+//=============================================================================================
+// Variants
+//=============================================================================================
+
+// Builds the variant's program from its files again. On failure, the variant keeps its program.
+static bool buildShaderVariant(ShaderVariant *variant, ShaderProgram *shader)
+{
+    ShaderFileList files = { 0 };
+    char *vertexShaderSource = preprocessShaderFiles(variant->vertexShaderName, variant->defines, &files);
+    bool vertexOnly = variant->compute || variant->feedbackVaryings[0];
+    char *fragmentShaderSource = vertexOnly ? NULL : preprocessShaderFiles(variant->fragmentShaderName, variant->defines, &files);
+    bool ok = vertexShaderSource && (fragmentShaderSource || vertexOnly);
+    if (ok)
+    {
+        if (variant->compute)
+        {
+            requestComputeProgram(shader, vertexShaderSource);
+        }
+        else if (variant->feedbackVaryings[0])
+        {
+            requestFeedbackProgram(shader, vertexShaderSource, variant->feedbackVaryings);
+        }
+        else
+        {
+            requestShaderProgram(shader, vertexShaderSource, fragmentShaderSource);
+        }
+        variant->files = files;
+    }
+    free(vertexShaderSource);
+    free(fragmentShaderSource);
+    return ok;
+}
+
+// Adds defines to every shader variant, for choices that depend on the context rather than the
+// mode. Call before any variant is requested.
+void addShaderDefines(char *defines)
+{
+    check(g.variantCount == 0, "addShaderDefines must be called before any shader is requested");
+    size_t length = strlen(g.commonDefines);
+    check(length + 1 + strlen(defines) < sizeof(g.commonDefines), "too many common shader defines");
+    snprintf(g.commonDefines + length, sizeof(g.commonDefines) - length, " %s", defines);
+}
+
+static ShaderProgram *requestVariant(
+    char *vertexShaderName, char *fragmentShaderName, char *feedbackVaryings, char *modeDefines, bool compute)
+{
+    char defines[sizeof(g.variants[0].defines)];
+    check(strlen(modeDefines) + strlen(g.commonDefines) < sizeof(defines), "shader variant name too long");
+    snprintf(defines, sizeof(defines), "%s%s", modeDefines, g.commonDefines);
+
+    uint64_t key = HASH_SEED;
+    key = hashString(key, vertexShaderName);
+    key = hashBytes(key, "", 1);
+    key = hashString(key, fragmentShaderName);
+    key = hashBytes(key, "", 1);
+    key = hashString(key, feedbackVaryings);
+    key = hashBytes(key, "", 1);
+    key = hashString(key, defines);
+
+    for (int i = 0; i < g.variantCount; i++)
+    {
+        if (g.variants[i].key == key)
+        {
+            return &g.variants[i].shader;
+        }
+    }
+
+    check(g.variantCount < MAX_SHADER_VARIANTS, "too many shader variants");
+    check(strlen(vertexShaderName) < sizeof(g.variants[0].vertexShaderName) &&
+        strlen(fragmentShaderName) < sizeof(g.variants[0].fragmentShaderName) &&
+        strlen(feedbackVaryings) < sizeof(g.variants[0].feedbackVaryings), "shader variant name too long");
+    ShaderVariant *variant = &g.variants[g.variantCount++];
+    variant->key = key;
+    variant->compute = compute;
+    strcpy(variant->vertexShaderName, vertexShaderName);
+    strcpy(variant->fragmentShaderName, fragmentShaderName);
+    strcpy(variant->feedbackVaryings, feedbackVaryings);
+    strcpy(variant->defines, defines);
+
+    check(buildShaderVariant(variant, &variant->shader), "preprocessing shader");
+    return &variant->shader;
+}
+
+// Returns the program built from the two shader files with the given set of defines. Each
+// combination is only preprocessed and compiled once; later calls return the same program.
+ShaderProgram *requestShaderVariant(char *vertexShaderName, char *fragmentShaderName, char *modeDefines)
+{
+    return requestVariant(vertexShaderName, fragmentShaderName, "", modeDefines, false);
+}
+
+// The same for a compute program; the fragment shader name is empty, so the two never collide.
+ShaderProgram *requestComputeVariant(char *computeShaderName, char *modeDefines)
+{
+    return requestVariant(computeShaderName, "", "", modeDefines, true);
+}
+
+// The same for a transform feedback program; see requestFeedbackProgram.
+ShaderProgram *requestFeedbackVariant(char *vertexShaderName, char *feedbackVaryings, char *modeDefines)
+{
+    return requestVariant(vertexShaderName, "", feedbackVaryings, modeDefines, false);
+}
+
+//=============================================================================================
+// Hot reload
+//=============================================================================================
+
+// Deletes a program that has not finished building, without waiting for it.
+static void abandonShaderProgram(ShaderProgram *shader)
+{
+    glDeleteProgram(shader->pending);
+    glDeleteShader(shader->vertexShader);
+    glDeleteShader(shader->fragmentShader);
+    glDeleteShader(shader->computeShader);
+    memset(shader, 0, sizeof(*shader));
+}
+
+static void reloadShaderVariant(ShaderVariant *variant)
+{
+    if (variant->reloading)
+    {
+        abandonShaderProgram(&variant->reload);
+        variant->reloading = false;
+    }
+
+    if (buildShaderVariant(variant, &variant->reload))
+    {
+        variant->reloading = true;
+    }
+    else
+    {
+        fprintf(stderr, "error: reloading %s/%s [%s]: keeping the previous program\n",
+            variant->vertexShaderName, variant->fragmentShaderName, variant->defines);
+    }
+}
+
+// Swaps in reloaded programs that have finished building. Call between frames.
+static void finishShaderReloads()
+{
+    for (int i = 0; i < g.variantCount; i++)
+    {
+        ShaderVariant *variant = &g.variants[i];
+        if (!variant->reloading || !isShaderProgramReady(&variant->reload))
+        {
+            continue;
+        }
+
+        variant->reloading = false;
+        if (variant->reload.program || finishProgramLink(&variant->reload))
+        {
+            if (variant->shader.program)
+            {
+                deleteProgram(variant->shader.program);
+            }
+            else
+            {
+                abandonShaderProgram(&variant->shader);
+            }
+            variant->shader = variant->reload;
+            fprintf(stderr, "reloaded %s/%s [%s]\n",
+                variant->vertexShaderName, variant->fragmentShaderName, variant->defines);
+        }
+        else
+        {
+            fprintf(stderr, "error: compiling %s/%s [%s]: keeping the previous program (see gl.log)\n",
+                variant->vertexShaderName, variant->fragmentShaderName, variant->defines);
+        }
+        memset(&variant->reload, 0, sizeof(variant->reload));
+    }
+}
+
+#ifdef __linux__
+
+void startShaderHotReload()
+{
+    useLooseAssets();
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s" SHADER_DIRECTORY, getAssetDirectory());
+    g.watchFile = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    check(g.watchFile >= 0, "inotify_init1");
+    // Editors either rewrite files in place or write a new file and rename it over the old one:
+    int watch = inotify_add_watch(g.watchFile, path, IN_CLOSE_WRITE | IN_MOVED_TO);
+    check(watch >= 0, "inotify_add_watch");
+    g.hotReload = true;
+}
+
+void updateShaderHotReload()
+{
+    if (!g.hotReload)
+    {
+        return;
+    }
+
+    bool changed[MAX_SHADER_VARIANTS] = { 0 };
+    for (;;)
+    {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length = read(g.watchFile, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            check(length == 0 || errno == EAGAIN, "reading inotify events");
+            break;
+        }
+
+        for (char *p = buffer; p < buffer + length; )
+        {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0)
+            {
+                continue;
+            }
+
+            for (int i = 0; i < g.variantCount; i++)
+            {
+                ShaderFileList *files = &g.variants[i].files;
+                for (int f = 0; f < files->count; f++)
+                {
+                    changed[i] |= strcmp(files->names[f], event->name) == 0;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < g.variantCount; i++)
+    {
+        if (changed[i])
+        {
+            reloadShaderVariant(&g.variants[i]);
+        }
+    }
+
+    finishShaderReloads();
+}
+
+#else
+
+void startShaderHotReload()
+{
+    fprintf(stderr, "warning: shader hot reload is only supported on Linux\n");
+}
+
+void updateShaderHotReload()
+{
+}
+
+#endif
+
+//=============================================================================================
+// Basic shader
+//=============================================================================================
+
+// One variant of the cube.v/cube.f shader family, which all have the same uniforms.
+ShaderProgram *requestBasicShader(char *defines)
+{
+    return requestShaderVariant("cube.v.glsl", "cube.f.glsl", defines);
+}
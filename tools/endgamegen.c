@@ -0,0 +1,423 @@
+// Makes the endgame databases in checkersendgames.h, for every position with up to a given number
+// of pieces, by retrograde analysis:
+//
+//     endgamegen [-t threads] [-o file] [pieces]
+//
+// Slices are made from the fewest pieces up, and among slices with the same number of pieces,
+// from the fewest men up, since a capture or a man being crowned always leads to a slice that is
+// already done. Other moves lead to a position with the same material and the colors swapped, so
+// each slice is made together with its mirror image. Every position starts out unknown, and each
+// pass over the slices settles the ones whose moves lead to a settled result: a win if any move
+// leaves the other side lost, and a loss if every move leaves it won. Threads share out each pass.
+// When a pass settles nothing more, the rest are draws.
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../checkersendgames.h"
+
+#define MAX_THREADS 64
+#define DEFAULT_PIECES 5
+#define DEFAULT_FILE_NAME "checkers.egdb"
+// How many positions a thread takes at a time:
+#define CHUNK_POSITIONS 4096
+
+// Values while a slice is being made. Unknown positions that are never settled are draws, which
+// is why it shares their value:
+#define UNKNOWN CHECKERS_DRAW
+#define IMPOSSIBLE 3
+
+// A slice that is being made, one byte per position:
+typedef struct WorkingSlice
+{
+    int material[4];
+    uint8_t *values;
+    uint64_t positionCount;
+} WorkingSlice;
+
+static struct endgamegenGlobals
+{
+    // Finished slices, packed as they are in the file:
+    CheckersEndgames done;
+    CheckersEndgameSlice *slices;
+    uint8_t **sliceData;
+    int sliceCount;
+
+    // The slices being made, and what each pass has reached:
+    WorkingSlice working[2];
+    int workingCount;
+    uint64_t nextChunk, chunkCount;
+    uint64_t settled;
+    bool firstPass;
+    pthread_mutex_t lock;
+} g;
+
+static void check(bool condition, char *message)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//=============================================================================================
+// Values
+//=============================================================================================
+
+static WorkingSlice *findWorkingSlice(const int *material)
+{
+    for (int i = 0; i < g.workingCount; i++)
+    {
+        if (memcmp(g.working[i].material, material, sizeof(g.working[i].material)) == 0)
+        {
+            return &g.working[i];
+        }
+    }
+    return NULL;
+}
+
+// For a position with red to move, after one of black's moves:
+static int getMoveValue(const CheckersBoard *board)
+{
+    CheckersBoard turned = *board;
+    turnCheckersBoard(&turned);
+    if (turned.pieces[CHECKERS_BLACK] == 0)
+    {
+        return CHECKERS_LOSS;
+    }
+
+    int material[4];
+    getCheckersMaterial(&turned, material);
+    uint64_t index = getEndgameIndex(material, &turned);
+    WorkingSlice *working = findWorkingSlice(material);
+    if (working)
+    {
+        // Other threads are settling positions as this one reads them, but a value only ever
+        // goes from unknown to settled, and either is right for this pass:
+        return __atomic_load_n(&working->values[index], __ATOMIC_RELAXED);
+    }
+    const uint8_t *slice = g.done.slices[material[0]][material[1]][material[2]][material[3]];
+    check(slice != NULL, "a move leads to a slice that has not been made");
+    return getEndgameValue(slice, index);
+}
+
+static int settlePosition(const CheckersBoard *board)
+{
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = generateCheckersMoves(board, moves);
+    bool allWon = true;
+    for (int i = 0; i < count; i++)
+    {
+        CheckersBoard next = *board;
+        makeCheckersMove(&next, &moves[i]);
+        int value = getMoveValue(&next);
+        if (value == CHECKERS_LOSS)
+        {
+            return CHECKERS_WIN;
+        }
+        allWon = allWon && (value == CHECKERS_WIN);
+    }
+    // This includes having no moves at all:
+    return allWon ? CHECKERS_LOSS : UNKNOWN;
+}
+
+//=============================================================================================
+// Passes
+//=============================================================================================
+
+static void *runWorker(void *data)
+{
+    (void)data;
+    uint64_t settled = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&g.lock);
+        uint64_t chunk = g.nextChunk++;
+        pthread_mutex_unlock(&g.lock);
+        if (chunk >= g.chunkCount)
+        {
+            break;
+        }
+
+        // Chunks run through the first working slice and on into the second:
+        WorkingSlice *working = &g.working[0];
+        uint64_t firstChunks = (working->positionCount + CHUNK_POSITIONS - 1) / CHUNK_POSITIONS;
+        if (chunk >= firstChunks)
+        {
+            chunk -= firstChunks;
+            working = &g.working[1];
+        }
+        uint64_t first = chunk * CHUNK_POSITIONS;
+        uint64_t last = first + CHUNK_POSITIONS;
+        last = (last < working->positionCount) ? last : working->positionCount;
+
+        // Only this thread writes these positions, though others read them:
+        for (uint64_t index = first; index < last; index++)
+        {
+            if (working->values[index] != UNKNOWN)
+            {
+                continue;
+            }
+            CheckersBoard board;
+            if (!setEndgamePosition(working->material, index, &board))
+            {
+                if (g.firstPass)
+                {
+                    __atomic_store_n(&working->values[index], (uint8_t)IMPOSSIBLE, __ATOMIC_RELAXED);
+                }
+                continue;
+            }
+            int value = settlePosition(&board);
+            if (value != UNKNOWN)
+            {
+                __atomic_store_n(&working->values[index], (uint8_t)value, __ATOMIC_RELAXED);
+                settled++;
+            }
+        }
+    }
+
+    pthread_mutex_lock(&g.lock);
+    g.settled += settled;
+    pthread_mutex_unlock(&g.lock);
+    return NULL;
+}
+
+// Returns how many positions the pass settled.
+static uint64_t runPass(int threadCount)
+{
+    uint64_t positions = 0;
+    for (int i = 0; i < g.workingCount; i++)
+    {
+        // Chunks must not straddle the two slices:
+        positions += (g.working[i].positionCount + CHUNK_POSITIONS - 1) / CHUNK_POSITIONS * CHUNK_POSITIONS;
+    }
+    g.nextChunk = 0;
+    g.chunkCount = positions / CHUNK_POSITIONS;
+    g.settled = 0;
+
+    pthread_t threads[MAX_THREADS];
+    for (int i = 0; i < threadCount; i++)
+    {
+        check(pthread_create(&threads[i], NULL, runWorker, NULL) == 0, "pthread_create");
+    }
+    for (int i = 0; i < threadCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    return g.settled;
+}
+
+//=============================================================================================
+// Slices
+//=============================================================================================
+
+static void printMaterial(const int *material)
+{
+    printf("black %d man %d king v red %d man %d king",
+        material[CHECKERS_BLACK_MEN], material[CHECKERS_BLACK_KINGS],
+        material[CHECKERS_RED_MEN], material[CHECKERS_RED_KINGS]);
+}
+
+// Packs a working slice four values to a byte, and adds it to the finished ones:
+static void finishSlice(WorkingSlice *working, int passes, double seconds)
+{
+    uint64_t counts[4] = { 0 };
+    uint64_t size = (working->positionCount + 3) / 4;
+    uint8_t *data = calloc(size, 1);
+    check(data != NULL, "not enough memory");
+    for (uint64_t index = 0; index < working->positionCount; index++)
+    {
+        int value = working->values[index];
+        counts[value]++;
+        value = (value == IMPOSSIBLE) ? CHECKERS_DRAW : value;
+        data[index >> 2] |= (uint8_t)(value << ((index & 3) * 2));
+    }
+
+    int *material = working->material;
+    g.slices = realloc(g.slices, (g.sliceCount + 1) * sizeof(g.slices[0]));
+    g.sliceData = realloc(g.sliceData, (g.sliceCount + 1) * sizeof(g.sliceData[0]));
+    check(g.slices && g.sliceData, "not enough memory");
+    CheckersEndgameSlice *slice = &g.slices[g.sliceCount];
+    memset(slice, 0, sizeof(*slice));
+    for (int kind = 0; kind < 4; kind++)
+    {
+        slice->material[kind] = (uint8_t)material[kind];
+    }
+    slice->positionCount = working->positionCount;
+    g.sliceData[g.sliceCount++] = data;
+    g.done.slices[material[0]][material[1]][material[2]][material[3]] = data;
+
+    printMaterial(material);
+    printf(": %llu wins, %llu losses, %llu draws, %d passes, %.2f s\n",
+        (unsigned long long)counts[CHECKERS_WIN], (unsigned long long)counts[CHECKERS_LOSS],
+        (unsigned long long)counts[CHECKERS_DRAW], passes, seconds);
+    fflush(stdout);
+}
+
+// Makes a slice, and its mirror image if that is a different slice:
+static void makeSlices(const int *material, int threadCount)
+{
+    int mirror[4] = { material[CHECKERS_RED_MEN], material[CHECKERS_RED_KINGS], material[CHECKERS_BLACK_MEN], material[CHECKERS_BLACK_KINGS] };
+    g.workingCount = (memcmp(material, mirror, sizeof(mirror)) == 0) ? 1 : 2;
+    for (int i = 0; i < g.workingCount; i++)
+    {
+        WorkingSlice *working = &g.working[i];
+        memcpy(working->material, (i == 0) ? material : mirror, sizeof(working->material));
+        working->positionCount = countEndgamePositions(working->material);
+        working->values = calloc(working->positionCount, 1);
+        check(working->values != NULL, "not enough memory");
+    }
+    if (g.workingCount == 1)
+    {
+        g.working[1].positionCount = 0;
+    }
+
+    // The first pass also finds the impossible positions:
+    double start = now();
+    int passes = 0;
+    uint64_t settled;
+    do
+    {
+        g.firstPass = (passes == 0);
+        settled = runPass(threadCount);
+        passes++;
+    } while (settled > 0);
+
+    for (int i = 0; i < g.workingCount; i++)
+    {
+        finishSlice(&g.working[i], passes, now() - start);
+        free(g.working[i].values);
+    }
+    g.workingCount = 0;
+}
+
+static bool isDone(const int *material)
+{
+    return g.done.slices[material[0]][material[1]][material[2]][material[3]] != NULL;
+}
+
+static void makeAllSlices(int maxPieces, int threadCount)
+{
+    for (int pieces = 2; pieces <= maxPieces; pieces++)
+    {
+        g.done.maxPieces = pieces;
+        for (int men = 0; men <= pieces; men++)
+        {
+            int kings = pieces - men;
+            for (int blackMen = 0; blackMen <= men; blackMen++)
+            {
+                for (int blackKings = 0; blackKings <= kings; blackKings++)
+                {
+                    int material[4] = { blackMen, blackKings, men - blackMen, kings - blackKings };
+                    if (blackMen + blackKings > 0 && blackMen + blackKings < pieces && !isDone(material))
+                    {
+                        makeSlices(material, threadCount);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//=============================================================================================
+// File
+//=============================================================================================
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + CHECKERS_ENDGAME_ALIGNMENT - 1) / CHECKERS_ENDGAME_ALIGNMENT * CHECKERS_ENDGAME_ALIGNMENT;
+}
+
+static void writeFile(const char *path, int maxPieces)
+{
+    uint64_t offset = sizeof(CheckersEndgameHeader) + g.sliceCount * sizeof(CheckersEndgameSlice);
+    for (int i = 0; i < g.sliceCount; i++)
+    {
+        offset = alignOffset(offset);
+        g.slices[i].dataOffset = offset;
+        offset += (g.slices[i].positionCount + 3) / 4;
+    }
+
+    FILE *file = fopen(path, "wb");
+    check(file != NULL, "cannot write the file");
+    CheckersEndgameHeader header = { CHECKERS_ENDGAME_MAGIC, CHECKERS_ENDGAME_VERSION, (uint32_t)maxPieces, (uint32_t)g.sliceCount };
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(g.slices, sizeof(g.slices[0]), g.sliceCount, file) == (size_t)g.sliceCount;
+    for (int i = 0; i < g.sliceCount && written; i++)
+    {
+        static const uint8_t padding[CHECKERS_ENDGAME_ALIGNMENT];
+        size_t paddingSize = (size_t)(g.slices[i].dataOffset - ftell(file));
+        size_t size = (size_t)((g.slices[i].positionCount + 3) / 4);
+        written = fwrite(padding, 1, paddingSize, file) == paddingSize &&
+            fwrite(g.sliceData[i], 1, size, file) == size;
+    }
+    written = (fclose(file) == 0) && written;
+    check(written, "cannot write the file");
+    printf("%d slices, %llu bytes, written to %s\n", g.sliceCount, (unsigned long long)offset, path);
+}
+
+// Reads the file back the way the game will, to be sure it says what was made:
+static void checkFile(const char *path)
+{
+    CheckersEndgames endgames;
+    check(openCheckersEndgames(&endgames, path), "the file that was written is not valid");
+    for (int i = 0; i < g.sliceCount; i++)
+    {
+        uint8_t *material = g.slices[i].material;
+        const uint8_t *slice = endgames.slices[material[0]][material[1]][material[2]][material[3]];
+        check(slice && memcmp(slice, g.sliceData[i], (size_t)((g.slices[i].positionCount + 3) / 4)) == 0,
+            "the file that was written does not match");
+    }
+    closeCheckersEndgames(&endgames);
+}
+
+int main(int argc, char *argv[])
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = (cpus < 1) ? 1 : (cpus > MAX_THREADS) ? MAX_THREADS : (int)cpus;
+    int maxPieces = DEFAULT_PIECES;
+    char *path = DEFAULT_FILE_NAME;
+    pthread_mutex_init(&g.lock, NULL);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            threadCount = atoi(argv[++i]);
+            threadCount = (threadCount < 1) ? 1 : (threadCount > MAX_THREADS) ? MAX_THREADS : threadCount;
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else if (atoi(argv[i]) >= 2 && atoi(argv[i]) <= CHECKERS_ENDGAME_MAX_PIECES)
+        {
+            maxPieces = atoi(argv[i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t threads] [-o file] [pieces]\n", argv[0]);
+            fprintf(stderr, "pieces can be from 2 to %d\n", CHECKERS_ENDGAME_MAX_PIECES);
+            return 1;
+        }
+    }
+
+    double start = now();
+    makeAllSlices(maxPieces, threadCount);
+    writeFile(path, maxPieces);
+    checkFile(path);
+    printf("done in %.1f s with %d thread%s\n", now() - start, threadCount, (threadCount == 1) ? "" : "s");
+    return 0;
+}
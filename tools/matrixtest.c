@@ -0,0 +1,782 @@
+// Checks the matrix functions in matrix.c against the scalar, row-major code they replaced, or
+// for what that code did not have, against what the results have to be; and times the old and new
+// code:
+//
+//     matrixtest          check, then time
+//     matrixtest -c       only check
+//
+// The old code wrote its matrices out row by row, where matrix.c writes them column by column, so
+// an old matrix's element [row * 4 + column] is a new one's [column * 4 + row]. Both multiply in
+// the same order: the product applies the left matrix first.
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../common.h"
+
+#define RANDOM_TESTS 10000
+// Big enough for the AVX, SSE and scalar loops in the batch transforms to all get some points:
+#define BATCH_POINTS 1003
+#define BENCHMARK_PRODUCTS 10000000
+#define BENCHMARK_MATRICES 256
+#define BENCHMARK_POINTS 4096
+#define BENCHMARK_BATCHES 2000
+// Relative to the size of the numbers involved:
+#define TOLERANCE 1e-5f
+#define SINCOS_TESTS 1000000
+#define SINCOS_RANGE 3000.0f
+// Absolute, against sinf and cosf:
+#define SINCOS_TOLERANCE 5e-7f
+// The old code was in main.c, where other files could not inline it, and matrix.c cannot be
+// inlined here either:
+#define NOINLINE __attribute__((noinline))
+
+static struct matrixtestGlobals
+{
+    uint32_t random;
+    int checks, failures;
+} g;
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static float randomFloat(float low, float high)
+{
+    g.random ^= g.random << 13;
+    g.random ^= g.random >> 17;
+    g.random ^= g.random << 5;
+    return low + (high - low) * (g.random >> 8) / (float)(1 << 24);
+}
+
+//=============================================================================================
+// The old code
+//=============================================================================================
+
+// These are the matrix functions as they were in main.c, except for oldTransformPoint, which
+// reads the translation from the right elements and can also project.
+
+static float *oldMatrixElement(Matrix4 *matrix, int row, int column)
+{
+    return matrix->e + column * 4 + row;
+}
+
+NOINLINE static Matrix4 oldMatrixMultiply(Matrix4 left, Matrix4 right)
+{
+    Matrix4 m;
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            float elem = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                elem += *oldMatrixElement(&left, row, i) * *oldMatrixElement(&right, i, col);
+            }
+            *oldMatrixElement(&m, row, col) = elem;
+        }
+    }
+    return m;
+}
+
+static Matrix4 oldMatrixPerspective(float near, float fov)
+{
+    float e = 1 / (float)tan(fov / 2);
+    float a = (float)WINDOW_HEIGHT / WINDOW_WIDTH;
+    Matrix4 m = {
+        e, 0, 0, 0,
+        0, e / a, 0, 0,
+        0, 0, -1, -2 * near,
+        0, 0, -1, 0,
+    };
+    return m;
+}
+
+static Matrix4 oldMatrixTranslation(Vector3 v)
+{
+    Matrix4 m = {
+        1, 0, 0, v.x,
+        0, 1, 0, v.y,
+        0, 0, 1, v.z,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+static Matrix4 oldMatrixRotationX(float radians)
+{
+    float sinx = (float)sin(radians);
+    float cosx = (float)cos(radians);
+    Matrix4 m = {
+        1, 0, 0, 0,
+        0, cosx, -sinx, 0,
+        0, sinx, cosx, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+static Matrix4 oldMatrixRotationY(float radians)
+{
+    float sinx = (float)sin(radians);
+    float cosx = (float)cos(radians);
+    Matrix4 m = {
+        cosx, 0, sinx, 0,
+        0, 1, 0, 0,
+        -sinx, 0, cosx, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+static Matrix4 oldMatrixRotationZ(float radians)
+{
+    float sinx = (float)sin(radians);
+    float cosx = (float)cos(radians);
+    Matrix4 m = {
+        cosx, -sinx, 0, 0,
+        sinx, cosx, 0, 0,
+        0, 0, 1, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+static Matrix4 oldMatrixScaleF(float x, float y, float z)
+{
+    Matrix4 m = {
+        x, 0, 0, 0,
+        0, y, 0, 0,
+        0, 0, z, 0,
+        0, 0, 0, 1,
+    };
+    return m;
+}
+
+// Divides by w if `project` is set.
+NOINLINE static Vector3 oldTransformPoint(Matrix4 transform, Vector3 point, bool project)
+{
+    float *m = transform.e;
+    Vector3 p = point;
+    float w = project ? m[12] * p.x + m[13] * p.y + m[14] * p.z + m[15] : 1;
+    Vector3 result;
+    result.x = (m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3]) / w;
+    result.y = (m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7]) / w;
+    result.z = (m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]) / w;
+    return result;
+}
+
+//=============================================================================================
+// Checks
+//=============================================================================================
+
+// `size` is how big the numbers that went into the result were, if that is more than 1:
+static bool closeEnoughAt(float actual, float expected, float size)
+{
+    size = fmaxf(size, fabsf(expected));
+    return fabsf(actual - expected) <= TOLERANCE * size;
+}
+
+static bool closeEnough(float actual, float expected)
+{
+    return closeEnoughAt(actual, expected, 1);
+}
+
+// Prints only the first failure of each kind, so one mistake does not bury the rest:
+static void checkMatrixAt(const char *name, Matrix4 actual, Matrix4 expectedOld, float size, bool *failed)
+{
+    g.checks++;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            float a = actual.e[column * 4 + row];
+            float e = expectedOld.e[row * 4 + column];
+            if (!closeEnoughAt(a, e, size))
+            {
+                g.failures++;
+                if (!*failed)
+                {
+                    printf("FAIL %s: row %d column %d is %g, expected %g\n", name, row, column, a, e);
+                }
+                *failed = true;
+                return;
+            }
+        }
+    }
+}
+
+static void checkMatrix(const char *name, Matrix4 actual, Matrix4 expectedOld, bool *failed)
+{
+    checkMatrixAt(name, actual, expectedOld, 1, failed);
+}
+
+static void checkPointAt(const char *name, Vector3 actual, Vector3 expected, float size, bool *failed)
+{
+    g.checks++;
+    if (!closeEnoughAt(actual.x, expected.x, size) || !closeEnoughAt(actual.y, expected.y, size) || !closeEnoughAt(actual.z, expected.z, size))
+    {
+        g.failures++;
+        if (!*failed)
+        {
+            printf("FAIL %s: (%g, %g, %g), expected (%g, %g, %g)\n", name,
+                actual.x, actual.y, actual.z, expected.x, expected.y, expected.z);
+        }
+        *failed = true;
+    }
+}
+
+static void checkPoint(const char *name, Vector3 actual, Vector3 expected, bool *failed)
+{
+    checkPointAt(name, actual, expected, 1, failed);
+}
+
+static void report(const char *name, bool failed)
+{
+    if (!failed)
+    {
+        printf("ok   %s\n", name);
+    }
+}
+
+// An old matrix and the same matrix in the new layout:
+static void randomMatrices(Matrix4 *old, Matrix4 *new)
+{
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            float value = randomFloat(-4, 4);
+            old->e[row * 4 + column] = value;
+            new->e[column * 4 + row] = value;
+        }
+    }
+}
+
+static Vector3 randomVector(float low, float high)
+{
+    return (Vector3){ randomFloat(low, high), randomFloat(low, high), randomFloat(low, high) };
+}
+
+static void checkProducts()
+{
+    bool multiplyFailed = false, multiplyToFailed = false, aliasFailed = false, concatFailed = false;
+    for (int i = 0; i < RANDOM_TESTS; i++)
+    {
+        Matrix4 oldA, oldB, a, b;
+        randomMatrices(&oldA, &a);
+        randomMatrices(&oldB, &b);
+        Matrix4 expected = oldMatrixMultiply(oldA, oldB);
+
+        checkMatrix("matrixMultiply", matrixMultiply(a, b), expected, &multiplyFailed);
+
+        Matrix4 result;
+        matrixMultiplyTo(&result, &a, &b);
+        checkMatrix("matrixMultiplyTo", result, expected, &multiplyToFailed);
+
+        Matrix4 left = a, right = b, both = a;
+        matrixMultiplyTo(&left, &left, &b);
+        matrixMultiplyTo(&right, &a, &right);
+        matrixMultiplyTo(&both, &both, &both);
+        checkMatrix("matrixMultiplyTo with the result as the left", left, expected, &aliasFailed);
+        checkMatrix("matrixMultiplyTo with the result as the right", right, expected, &aliasFailed);
+        checkMatrix("matrixMultiplyTo with the result as both", both, oldMatrixMultiply(oldA, oldA), &aliasFailed);
+
+        Matrix4 concat = a;
+        matrixConcat(&concat, b);
+        checkMatrix("matrixConcat", concat, expected, &concatFailed);
+        concat = a;
+        matrixConcat(&concat, concat);
+        checkMatrix("matrixConcat with itself", concat, oldMatrixMultiply(oldA, oldA), &concatFailed);
+    }
+    report("matrixMultiply", multiplyFailed);
+    report("matrixMultiplyTo", multiplyToFailed);
+    report("matrixMultiplyTo with the result as an input", aliasFailed);
+    report("matrixConcat", concatFailed);
+}
+
+static void checkConstructors()
+{
+    bool failed = false;
+    Matrix4 oldIdentity = oldMatrixScaleF(1, 1, 1);
+    checkMatrix("matrixIdentity", matrixIdentity(), oldIdentity, &failed);
+    for (int i = 0; i < RANDOM_TESTS; i++)
+    {
+        float angle = randomFloat(-10, 10);
+        Vector3 v = randomVector(-100, 100);
+        checkMatrix("matrixTranslation", matrixTranslation(v), oldMatrixTranslation(v), &failed);
+        checkMatrix("matrixTranslationF", matrixTranslationF(v.x, v.y, v.z), oldMatrixTranslation(v), &failed);
+        checkMatrix("matrixRotationX", matrixRotationX(angle), oldMatrixRotationX(angle), &failed);
+        checkMatrix("matrixRotationY", matrixRotationY(angle), oldMatrixRotationY(angle), &failed);
+        checkMatrix("matrixRotationZ", matrixRotationZ(angle), oldMatrixRotationZ(angle), &failed);
+        checkMatrix("matrixScaleF", matrixScaleF(v.x, v.y, v.z), oldMatrixScaleF(v.x, v.y, v.z), &failed);
+        checkMatrix("matrixScaleUniform", matrixScaleUniform(v.x), oldMatrixScaleF(v.x, v.x, v.x), &failed);
+        float near = randomFloat(0.01f, 1);
+        float fov = randomFloat(0.3f, 2);
+        checkMatrix("matrixPerspective", matrixPerspective(near, fov), oldMatrixPerspective(near, fov), &failed);
+    }
+    report("matrix constructors", failed);
+}
+
+static void checkTransforms()
+{
+    bool quaternionFailed = false, trsFailed = false, viewFailed = false;
+    Vector3 axes[3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    Matrix4 (*oldRotations[3])(float) = { oldMatrixRotationX, oldMatrixRotationY, oldMatrixRotationZ };
+    Vector3 zero = { 0, 0, 0 };
+    Vector3 one = { 1, 1, 1 };
+    checkMatrix("quaternionIdentity", matrixTRS(zero, quaternionIdentity(), one), oldMatrixScaleF(1, 1, 1), &quaternionFailed);
+
+    for (int i = 0; i < RANDOM_TESTS; i++)
+    {
+        // Rotations about each axis, and two of them chained:
+        int first = i % 3, second = (i / 3) % 3;
+        float angle1 = randomFloat(-10, 10), angle2 = randomFloat(-10, 10);
+        Quaternion q1 = quaternionAxisAngle(axes[first], angle1);
+        Quaternion q2 = quaternionAxisAngle(axes[second], angle2);
+        Matrix4 oldR1 = oldRotations[first](angle1);
+        Matrix4 oldR2 = oldRotations[second](angle2);
+        Matrix4 oldR = oldMatrixMultiply(oldR1, oldR2);
+        checkMatrix("quaternionAxisAngle", matrixTRS(zero, q1, one), oldR1, &quaternionFailed);
+        checkMatrix("quaternionMultiply", matrixTRS(zero, quaternionMultiply(q1, q2), one), oldR, &quaternionFailed);
+
+        // Scale, then rotate, then translate:
+        Vector3 t = randomVector(-100, 100);
+        Vector3 s = randomVector(-3, 3);
+        Matrix4 oldTRS = oldMatrixMultiply(oldMatrixMultiply(oldMatrixScaleF(s.x, s.y, s.z), oldR), oldMatrixTranslation(t));
+        checkMatrix("matrixTRS", matrixTRS(t, quaternionMultiply(q1, q2), s), oldTRS, &trsFailed);
+
+        // The camera shortcuts:
+        float yaw = randomFloat(-10, 10), pitch = randomFloat(-1.5f, 1.5f);
+        Matrix4 oldOrbit = oldMatrixMultiply(oldMatrixMultiply(oldMatrixRotationY(yaw), oldMatrixRotationX(pitch)), oldMatrixTranslation(t));
+        Matrix4 orbit = matrixOrbit(yaw, pitch, t);
+        checkMatrix("matrixOrbit", orbit, oldOrbit, &viewFailed);
+        float near = randomFloat(0.01f, 1), fov = randomFloat(0.3f, 2);
+        checkMatrix("matrixViewPerspective", matrixViewPerspective(&orbit, near, fov),
+            oldMatrixMultiply(oldOrbit, oldMatrixPerspective(near, fov)), &viewFailed);
+    }
+    report("quaternions", quaternionFailed);
+    report("matrixTRS", trsFailed);
+    report("matrixOrbit and matrixViewPerspective", viewFailed);
+}
+
+static float dot(Vector3 a, Vector3 b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vector3 cross(Vector3 a, Vector3 b)
+{
+    return (Vector3){ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static Vector3 normalize(Vector3 v)
+{
+    float length = sqrtf(dot(v, v));
+    return (Vector3){ v.x / length, v.y / length, v.z / length };
+}
+
+static Vector3 arraysElement(Vector3Arrays arrays, size_t i)
+{
+    return (Vector3){ arrays.x[i], arrays.y[i], arrays.z[i] };
+}
+
+static void setArraysElement(Vector3Arrays arrays, size_t i, Vector3 v)
+{
+    arrays.x[i] = v.x;
+    arrays.y[i] = v.y;
+    arrays.z[i] = v.z;
+}
+
+// A transformed normal has to be a unit vector that is perpendicular to the transformed tangents
+// of its surface, and on the same side of the surface as the transformed normal vector itself,
+// even for transforms that mirror.
+static void checkNormals()
+{
+    static float storage[4][3][BATCH_POINTS];
+    Vector3Arrays normals = { storage[0][0], storage[0][1], storage[0][2] };
+    Vector3Arrays tangents = { storage[1][0], storage[1][1], storage[1][2] };
+    Vector3Arrays out = { storage[2][0], storage[2][1], storage[2][2] };
+    Vector3Arrays vectors = { storage[3][0], storage[3][1], storage[3][2] };
+    bool lengthFailed = false, perpendicularFailed = false, sideFailed = false, zeroFailed = false;
+
+    for (int test = 0; test < 40; test++)
+    {
+        // Scaling that is not uniform, and mirrors in half of the tests, then shearing:
+        Vector3 s = randomVector(0.2f, 3);
+        s.x = (test & 1) ? -s.x : s.x;
+        s.z = (test & 2) ? -s.z : s.z;
+        Quaternion q = quaternionAxisAngle(normalize(randomVector(-1, 1)), randomFloat(-3, 3));
+        Matrix4 shear = matrixIdentity();
+        shear.e[4] = randomFloat(-1, 1);
+        shear.e[8] = randomFloat(-1, 1);
+        shear.e[9] = randomFloat(-1, 1);
+        Matrix4 transform = matrixMultiply(matrixTRS(randomVector(-10, 10), q, s), shear);
+
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            Vector3 normal = normalize(randomVector(-1, 1));
+            setArraysElement(normals, i, normal);
+            setArraysElement(tangents, i, normalize(cross(normal, randomVector(-1, 1))));
+        }
+        setArraysElement(normals, 0, (Vector3){ 0, 0, 0 });
+
+        matrixTransformVectors(&transform, tangents, tangents, BATCH_POINTS);
+        matrixTransformVectors(&transform, normals, vectors, BATCH_POINTS);
+        matrixTransformNormals(&transform, normals, out, BATCH_POINTS);
+        checkPoint("matrixTransformNormals of a zero normal", arraysElement(out, 0), (Vector3){ 0, 0, 0 }, &zeroFailed);
+        for (int i = 1; i < BATCH_POINTS; i++)
+        {
+            Vector3 normal = arraysElement(out, i);
+            g.checks += 3;
+            if (!closeEnough(dot(normal, normal), 1))
+            {
+                g.failures++;
+                if (!lengthFailed)
+                {
+                    printf("FAIL matrixTransformNormals: length %g\n", sqrtf(dot(normal, normal)));
+                }
+                lengthFailed = true;
+            }
+            float cosine = dot(normal, normalize(arraysElement(tangents, i)));
+            if (!closeEnough(cosine, 0))
+            {
+                g.failures++;
+                if (!perpendicularFailed)
+                {
+                    printf("FAIL matrixTransformNormals: cosine %g with a tangent\n", cosine);
+                }
+                perpendicularFailed = true;
+            }
+            if (dot(normal, arraysElement(vectors, i)) <= 0)
+            {
+                g.failures++;
+                if (!sideFailed)
+                {
+                    printf("FAIL matrixTransformNormals: on the wrong side of the surface\n");
+                }
+                sideFailed = true;
+            }
+        }
+    }
+    report("matrixTransformNormals are unit vectors", lengthFailed);
+    report("matrixTransformNormals are perpendicular to tangents", perpendicularFailed);
+    report("matrixTransformNormals stay on their side", sideFailed);
+    report("matrixTransformNormals of a zero normal", zeroFailed);
+}
+
+static void checkSinCos()
+{
+    bool failed = false;
+    float worst = 0;
+    for (int i = 0; i < SINCOS_TESTS; i++)
+    {
+        // Multiples of pi/4 out to about 100, where the quadrants change, then random angles:
+        float angle = (i < 256) ? (i - 128) * (PI / 4) : randomFloat(-SINCOS_RANGE, SINCOS_RANGE);
+        float sine, cosine;
+        sinCos(angle, &sine, &cosine);
+        float error = fmaxf(fabsf(sine - sinf(angle)), fabsf(cosine - cosf(angle)));
+        worst = fmaxf(worst, error);
+        g.checks++;
+        if (error > SINCOS_TOLERANCE)
+        {
+            g.failures++;
+            if (!failed)
+            {
+                printf("FAIL sinCos(%g): (%g, %g), expected (%g, %g)\n", angle, sine, cosine, sinf(angle), cosf(angle));
+            }
+            failed = true;
+        }
+    }
+    if (!failed)
+    {
+        printf("ok   sinCos, within %g of sinf and cosf\n", worst);
+    }
+}
+
+// The camera's axes in double, and the old code's way of making a view from them: move the eye to
+// the origin, then turn the axes onto X, Y and -Z.
+static Matrix4 referenceLookAt(Vector3 eye, Vector3 target, Vector3 up, Vector3 *right, Vector3 *cameraUp)
+{
+    double f[3] = { target.x - eye.x, target.y - eye.y, target.z - eye.z };
+    double fLength = sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    for (int i = 0; i < 3; i++)
+    {
+        f[i] /= fLength;
+    }
+    double r[3] = { f[1] * up.z - f[2] * up.y, f[2] * up.x - f[0] * up.z, f[0] * up.y - f[1] * up.x };
+    double rLength = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    for (int i = 0; i < 3; i++)
+    {
+        r[i] /= rLength;
+    }
+    double u[3] = { r[1] * f[2] - r[2] * f[1], r[2] * f[0] - r[0] * f[2], r[0] * f[1] - r[1] * f[0] };
+    *right = (Vector3){ (float)r[0], (float)r[1], (float)r[2] };
+    *cameraUp = (Vector3){ (float)u[0], (float)u[1], (float)u[2] };
+
+    Matrix4 turn = {
+        (float)r[0], (float)r[1], (float)r[2], 0,
+        (float)u[0], (float)u[1], (float)u[2], 0,
+        (float)-f[0], (float)-f[1], (float)-f[2], 0,
+        0, 0, 0, 1,
+    };
+    return oldMatrixMultiply(oldMatrixTranslation((Vector3){ -eye.x, -eye.y, -eye.z }), turn);
+}
+
+static void checkViews()
+{
+    bool lookAtFailed = false, targetFailed = false, positionFailed = false, axesFailed = false;
+    for (int i = 0; i < RANDOM_TESTS; i++)
+    {
+        Vector3 eye = randomVector(-100, 100);
+        Vector3 target = randomVector(-100, 100);
+        Vector3 up = (i & 1) ? (Vector3){ 0, 1, 0 } : normalize(randomVector(-1, 1));
+        Vector3 toTarget = { target.x - eye.x, target.y - eye.y, target.z - eye.z };
+        // Up must not be too close to the direction of view:
+        if (fabsf(dot(normalize(toTarget), up)) > 0.99f)
+        {
+            continue;
+        }
+
+        // Positions come from the eye and target, so they are only as exact as those are big:
+        float size = sqrtf(dot(eye, eye)) + sqrtf(dot(target, target));
+        Vector3 right, cameraUp;
+        Matrix4 expected = referenceLookAt(eye, target, up, &right, &cameraUp);
+        Matrix4 view = matrixLookAt(eye, target, up);
+        checkMatrixAt("matrixLookAt", view, expected, size, &lookAtFailed);
+        Vector3 onAxis = { 0, 0, -sqrtf(dot(toTarget, toTarget)) };
+        checkPointAt("matrixLookAt puts the target on -Z", matrixTransformPoint(view, target), onAxis, size, &targetFailed);
+
+        checkPointAt("matrixViewPosition", matrixViewPosition(&view), eye, size, &positionFailed);
+        checkPoint("matrixViewRight", matrixViewRight(&view), right, &axesFailed);
+        checkPoint("matrixViewUp", matrixViewUp(&view), cameraUp, &axesFailed);
+
+        // An orbiting camera is at the point that its view moves to the origin:
+        Vector3 offset = randomVector(-10, 10);
+        Matrix4 orbit = matrixOrbit(randomFloat(-10, 10), randomFloat(-1.5f, 1.5f), offset);
+        Vector3 origin = { 0, 0, 0 };
+        checkPointAt("matrixViewPosition of matrixOrbit", matrixTransformPoint(orbit, matrixViewPosition(&orbit)), origin,
+            sqrtf(dot(offset, offset)), &positionFailed);
+    }
+    report("matrixLookAt", lookAtFailed);
+    report("matrixLookAt puts the target on -Z", targetFailed);
+    report("matrixViewPosition", positionFailed);
+    report("matrixViewRight and matrixViewUp", axesFailed);
+}
+
+static void checkPoints()
+{
+    static float x[BATCH_POINTS], y[BATCH_POINTS], z[BATCH_POINTS];
+    static float outX[BATCH_POINTS], outY[BATCH_POINTS], outZ[BATCH_POINTS];
+    Vector3Arrays in = { x, y, z };
+    Vector3Arrays out = { outX, outY, outZ };
+    bool pointFailed = false, batchFailed = false, projectFailed = false, vectorFailed = false, inPlaceFailed = false;
+
+    for (int test = 0; test < 20; test++)
+    {
+        // An affine transform, then a projection of it:
+        Vector3 t = randomVector(-10, 10);
+        Vector3 s = randomVector(0.5f, 2);
+        Quaternion q = quaternionAxisAngle((Vector3){ 0, 0.6f, 0.8f }, randomFloat(-3, 3));
+        Matrix4 transform = matrixTRS(t, q, s);
+        Matrix4 oldTransform;
+        for (int i = 0; i < 16; i++)
+        {
+            oldTransform.e[(i % 4) * 4 + i / 4] = transform.e[i];
+        }
+        Matrix4 projection = matrixViewPerspective(&transform, 0.1f, 1);
+        Matrix4 oldProjection = oldMatrixMultiply(oldTransform, oldMatrixPerspective(0.1f, 1));
+
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            // In front of the camera, so that w stays well away from 0:
+            Vector3 p = randomVector(-5, 5);
+            Vector3 inFront = matrixTransformPoint(transform, p);
+            if (inFront.z > -1)
+            {
+                p.z = -p.z;
+            }
+            x[i] = p.x;
+            y[i] = p.y;
+            z[i] = p.z;
+            checkPoint("matrixTransformPoint", matrixTransformPoint(transform, p), oldTransformPoint(oldTransform, p, false), &pointFailed);
+        }
+
+        matrixTransformPoints(&transform, in, out, BATCH_POINTS);
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            Vector3 p = { x[i], y[i], z[i] };
+            checkPoint("matrixTransformPoints", (Vector3){ outX[i], outY[i], outZ[i] }, oldTransformPoint(oldTransform, p, false), &batchFailed);
+        }
+
+        matrixTransformVectors(&transform, in, out, BATCH_POINTS);
+        Matrix4 oldLinear = oldTransform;
+        oldLinear.e[3] = oldLinear.e[7] = oldLinear.e[11] = 0;
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            Vector3 p = { x[i], y[i], z[i] };
+            checkPoint("matrixTransformVectors", (Vector3){ outX[i], outY[i], outZ[i] }, oldTransformPoint(oldLinear, p, false), &vectorFailed);
+        }
+
+        matrixProjectPoints(&projection, in, out, BATCH_POINTS);
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            Vector3 p = { x[i], y[i], z[i] };
+            Vector3 expected = oldTransformPoint(oldProjection, p, true);
+            if (fabsf(oldTransformPoint(oldTransform, p, false).z) > 0.5f)
+            {
+                checkPoint("matrixProjectPoints", (Vector3){ outX[i], outY[i], outZ[i] }, expected, &projectFailed);
+            }
+        }
+
+        // Writing over the input:
+        memcpy(outX, x, sizeof(x));
+        memcpy(outY, y, sizeof(y));
+        memcpy(outZ, z, sizeof(z));
+        matrixTransformPoints(&transform, out, out, BATCH_POINTS);
+        for (int i = 0; i < BATCH_POINTS; i++)
+        {
+            Vector3 p = { x[i], y[i], z[i] };
+            checkPoint("matrixTransformPoints in place", (Vector3){ outX[i], outY[i], outZ[i] }, oldTransformPoint(oldTransform, p, false), &inPlaceFailed);
+        }
+    }
+    report("matrixTransformPoint", pointFailed);
+    report("matrixTransformPoints", batchFailed);
+    report("matrixTransformVectors", vectorFailed);
+    report("matrixProjectPoints", projectFailed);
+    report("matrixTransformPoints in place", inPlaceFailed);
+}
+
+//=============================================================================================
+// Timing
+//=============================================================================================
+
+// Chains rotations, which keep the numbers the same size however many are multiplied:
+static void timeProducts()
+{
+    static Matrix4 old[BENCHMARK_MATRICES], new[BENCHMARK_MATRICES];
+    for (int i = 0; i < BENCHMARK_MATRICES; i++)
+    {
+        Quaternion q = quaternionAxisAngle((Vector3){ 0.48f, 0.6f, 0.64f }, randomFloat(-3, 3));
+        new[i] = matrixTRS((Vector3){ 0, 0, 0 }, q, (Vector3){ 1, 1, 1 });
+        for (int j = 0; j < 16; j++)
+        {
+            old[i].e[(j % 4) * 4 + j / 4] = new[i].e[j];
+        }
+    }
+
+    double start = now();
+    Matrix4 m = matrixIdentity();
+    for (int i = 0; i < BENCHMARK_PRODUCTS; i++)
+    {
+        m = oldMatrixMultiply(m, old[i % BENCHMARK_MATRICES]);
+    }
+    double oldTime = now() - start;
+    float sum = m.e[0];
+
+    start = now();
+    m = matrixIdentity();
+    for (int i = 0; i < BENCHMARK_PRODUCTS; i++)
+    {
+        m = matrixMultiply(m, new[i % BENCHMARK_MATRICES]);
+    }
+    double newTime = now() - start;
+    sum += m.e[0];
+
+    start = now();
+    m = matrixIdentity();
+    for (int i = 0; i < BENCHMARK_PRODUCTS; i++)
+    {
+        matrixMultiplyTo(&m, &m, &new[i % BENCHMARK_MATRICES]);
+    }
+    double toTime = now() - start;
+    sum += m.e[0];
+
+    printf("products: old %.1f ns, matrixMultiply %.1f ns (%.1fx), matrixMultiplyTo %.1f ns (%.1fx) [%g]\n",
+        oldTime / BENCHMARK_PRODUCTS * 1e9,
+        newTime / BENCHMARK_PRODUCTS * 1e9, oldTime / newTime,
+        toTime / BENCHMARK_PRODUCTS * 1e9, oldTime / toTime, sum);
+}
+
+static void timePoints()
+{
+    static float x[BENCHMARK_POINTS], y[BENCHMARK_POINTS], z[BENCHMARK_POINTS];
+    static float outX[BENCHMARK_POINTS], outY[BENCHMARK_POINTS], outZ[BENCHMARK_POINTS];
+    for (int i = 0; i < BENCHMARK_POINTS; i++)
+    {
+        x[i] = randomFloat(-1, 1);
+        y[i] = randomFloat(-1, 1);
+        z[i] = randomFloat(-1, 1);
+    }
+    Matrix4 transform = matrixTRS((Vector3){ 1, 2, 3 }, quaternionAxisAngle((Vector3){ 0, 1, 0 }, 0.5f), (Vector3){ 2, 2, 2 });
+    Matrix4 oldTransform;
+    for (int j = 0; j < 16; j++)
+    {
+        oldTransform.e[(j % 4) * 4 + j / 4] = transform.e[j];
+    }
+
+    // The old code had no batch transform, so it went one point at a time:
+    double start = now();
+    for (int batch = 0; batch < BENCHMARK_BATCHES; batch++)
+    {
+        for (int i = 0; i < BENCHMARK_POINTS; i++)
+        {
+            Vector3 p = oldTransformPoint(oldTransform, (Vector3){ x[i], y[i], z[i] }, false);
+            outX[i] = p.x;
+            outY[i] = p.y;
+            outZ[i] = p.z;
+        }
+        x[batch % BENCHMARK_POINTS] = outX[batch % BENCHMARK_POINTS] * 1e-3f;
+    }
+    double oldTime = now() - start;
+
+    start = now();
+    for (int batch = 0; batch < BENCHMARK_BATCHES; batch++)
+    {
+        matrixTransformPoints(&transform, (Vector3Arrays){ x, y, z }, (Vector3Arrays){ outX, outY, outZ }, BENCHMARK_POINTS);
+        x[batch % BENCHMARK_POINTS] = outX[batch % BENCHMARK_POINTS] * 1e-3f;
+    }
+    double newTime = now() - start;
+
+    double points = (double)BENCHMARK_BATCHES * BENCHMARK_POINTS;
+    printf("points: one at a time %.2f ns, matrixTransformPoints %.2f ns (%.1fx)\n",
+        oldTime / points * 1e9, newTime / points * 1e9, oldTime / newTime);
+}
+
+int main(int argc, char *argv[])
+{
+    bool checkOnly = (argc == 2 && strcmp(argv[1], "-c") == 0);
+    if (argc > 2 || (argc == 2 && !checkOnly))
+    {
+        fprintf(stderr, "usage: %s [-c]\n", argv[0]);
+        return 1;
+    }
+
+    g.random = 0x2545F491;
+#if defined(__AVX__)
+    printf("matrix.c is using AVX\n");
+#elif defined(__SSE__) || defined(_M_X64)
+    printf("matrix.c is using SSE\n");
+#else
+    printf("matrix.c is using scalar code\n");
+#endif
+    checkProducts();
+    checkConstructors();
+    checkTransforms();
+    checkSinCos();
+    checkViews();
+    checkPoints();
+    checkNormals();
+    printf("%d checks, %d failed\n", g.checks, g.failures);
+
+    if (!checkOnly && g.failures == 0)
+    {
+        timeProducts();
+        timePoints();
+    }
+    return g.failures ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+// Packs every file under an assets directory into a single archive; see assetformat.h.
+//
+//     packassets assets assets.pak
+//     packassets -c assets embeddedassets.c
+
+#define _DEFAULT_SOURCE
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../assetformat.h"
+
+typedef struct InputFile
+{
+    char *name;
+    char *path;
+    uint64_t size;
+} InputFile;
+
+static struct packGlobals
+{
+    InputFile *files;
+    size_t fileCount, fileCapacity;
+} g;
+
+static void check(bool condition, char *message)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+static char *joinPath(const char *a, const char *b)
+{
+    size_t length = strlen(a) + strlen(b) + 2;
+    char *path = malloc(length);
+    check(path != NULL, "malloc");
+    snprintf(path, length, "%s%s%s", a, *a ? "/" : "", b);
+    return path;
+}
+
+static void addFiles(const char *root, const char *relative)
+{
+    char *directoryPath = *relative ? joinPath(root, relative) : strdup(root);
+    DIR *directory = opendir(directoryPath);
+    if (!directory)
+    {
+        fprintf(stderr, "error: cannot open directory: %s\n", directoryPath);
+        exit(1);
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        char *name = joinPath(relative, entry->d_name);
+        char *path = joinPath(root, name);
+        struct stat info;
+        check(stat(path, &info) == 0, path);
+
+        if (S_ISDIR(info.st_mode))
+        {
+            addFiles(root, name);
+            free(name);
+            free(path);
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            if (g.fileCount == g.fileCapacity)
+            {
+                g.fileCapacity = g.fileCapacity ? 2 * g.fileCapacity : 64;
+                g.files = realloc(g.files, g.fileCapacity * sizeof(g.files[0]));
+                check(g.files != NULL, "realloc");
+            }
+            g.files[g.fileCount++] = (InputFile){ name, path, (uint64_t)info.st_size };
+        }
+    }
+
+    closedir(directory);
+    free(directoryPath);
+}
+
+static int compareFiles(const void *a, const void *b)
+{
+    return strcmp(((const InputFile *)a)->name, ((const InputFile *)b)->name);
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + ASSET_ALIGNMENT - 1) & ~(uint64_t)(ASSET_ALIGNMENT - 1);
+}
+
+// Builds the whole archive in memory; the asset tree is small.
+static uint8_t *buildArchive(size_t *archiveSize)
+{
+    // Lay out the table of contents, then the names, then the data:
+    AssetArchiveHeader header = { ASSET_ARCHIVE_MAGIC, ASSET_ARCHIVE_VERSION, (uint32_t)g.fileCount, 0 };
+    AssetArchiveEntry *entries = calloc(g.fileCount + 1, sizeof(entries[0]));
+    check(entries != NULL, "calloc");
+
+    uint64_t offset = sizeof(header) + g.fileCount * sizeof(entries[0]);
+    for (size_t i = 0; i < g.fileCount; i++)
+    {
+        entries[i].nameOffset = (uint32_t)offset;
+        entries[i].nameLength = (uint32_t)strlen(g.files[i].name);
+        offset += entries[i].nameLength + 1;
+        check(offset < UINT32_MAX, "too many asset names");
+    }
+    for (size_t i = 0; i < g.fileCount; i++)
+    {
+        offset = alignOffset(offset);
+        entries[i].dataOffset = offset;
+        entries[i].dataSize = g.files[i].size;
+        // Terminator for text files:
+        offset += g.files[i].size + 1;
+    }
+
+    // Zero-filled, which takes care of the padding and the terminators:
+    uint8_t *archive = calloc(1, offset);
+    check(archive != NULL, "calloc");
+    memcpy(archive, &header, sizeof(header));
+    memcpy(archive + sizeof(header), entries, g.fileCount * sizeof(entries[0]));
+    for (size_t i = 0; i < g.fileCount; i++)
+    {
+        memcpy(archive + entries[i].nameOffset, g.files[i].name, entries[i].nameLength);
+
+        FILE *in = fopen(g.files[i].path, "rb");
+        check(in != NULL, g.files[i].path);
+        check(g.files[i].size == 0 || fread(archive + entries[i].dataOffset, g.files[i].size, 1, in) == 1, g.files[i].path);
+        fclose(in);
+    }
+
+    free(entries);
+    *archiveSize = offset;
+    return archive;
+}
+
+// Writes the archive as a C array for builds that embed their assets; see EMBED_ASSETS in assets.c.
+static void writeSource(FILE *out, uint8_t *archive, size_t size)
+{
+    fprintf(out, "// Generated by tools/packassets.c. Do not edit.\n\n");
+    fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    // Align the array like a loaded archive, so the files in it start on ASSET_ALIGNMENT boundaries:
+    fprintf(out, "#if defined(_MSC_VER)\n#define ARCHIVE_ALIGNMENT __declspec(align(%d))\n", ASSET_ALIGNMENT);
+    fprintf(out, "#else\n#define ARCHIVE_ALIGNMENT _Alignas(%d)\n#endif\n\n", ASSET_ALIGNMENT);
+    fprintf(out, "ARCHIVE_ALIGNMENT static const uint8_t Archive[%zu] = {", size);
+    for (size_t i = 0; i < size; i++)
+    {
+        fprintf(out, "%s%d,", (i % 24 == 0) ? "\n    " : "", archive[i]);
+    }
+    fprintf(out, "\n};\n\n");
+    fprintf(out, "const uint8_t *EmbeddedAssetArchive = Archive;\n");
+    fprintf(out, "const size_t EmbeddedAssetArchiveSize = %zu;\n", size);
+}
+
+int main(int argc, char *argv[])
+{
+    bool source = argc == 4 && strcmp(argv[1], "-c") == 0;
+    if (argc != 3 && !source)
+    {
+        fprintf(stderr, "usage: %s [-c] <assets directory> <output>\n", argv[0]);
+        fprintf(stderr, "  -c  write C source that embeds the archive instead of the archive itself\n");
+        return 1;
+    }
+    char *inputPath = argv[argc - 2];
+    char *outputPath = argv[argc - 1];
+
+    addFiles(inputPath, "");
+    qsort(g.files, g.fileCount, sizeof(g.files[0]), compareFiles);
+
+    size_t size;
+    uint8_t *archive = buildArchive(&size);
+
+    FILE *out = fopen(outputPath, source ? "w" : "wb");
+    check(out != NULL, "cannot create output file");
+    if (source)
+    {
+        writeSource(out, archive, size);
+    }
+    else
+    {
+        check(fwrite(archive, size, 1, out) == 1, "writing archive");
+    }
+    check(fclose(out) == 0, "writing output file");
+
+    printf("packed %zu files into %s\n", g.fileCount, outputPath);
+    return 0;
+}
@@ -0,0 +1,526 @@
+// Counts every sequence of moves to a given depth, to check the move generator in
+// checkersengine.c against known counts and a plain reference generator, and to time it apart
+// from any rendering.
+//
+//     perft                                run the suite, then time the opening
+//     perft [-t threads] depth [position]  count from the opening or a position
+//
+// Positions are PDN FEN strings, like "B:W18,24,27,28,K10,K15:B12,16,20,K22,K25,K29": the side
+// to move, then each side's pieces by their standard numbers, with K for kings and ranges like
+// 1-12 allowed. Black starts on 1 to 12 and moves first.
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../checkersengine.h"
+
+#define MAX_THREADS 64
+#define PLAIN_MAX_MOVES 256
+// The suite's timing run:
+#define BENCHMARK_DEPTH 11
+
+typedef struct PerftTest
+{
+    char *name;
+    char *position;
+    int depth;
+    uint64_t count;
+} PerftTest;
+
+// The opening counts are the published ones. The others are positions with kings, long captures
+// and crowning. The suite counts every test with the reference generator below as well:
+static PerftTest Tests[] =
+{
+    { "opening", "B:W21-32:B1-12", 1, 7 },
+    { "opening", "B:W21-32:B1-12", 2, 49 },
+    { "opening", "B:W21-32:B1-12", 3, 302 },
+    { "opening", "B:W21-32:B1-12", 4, 1469 },
+    { "opening", "B:W21-32:B1-12", 5, 7361 },
+    { "opening", "B:W21-32:B1-12", 6, 36768 },
+    { "opening", "B:W21-32:B1-12", 7, 179740 },
+    { "opening", "B:W21-32:B1-12", 8, 845931 },
+    { "opening", "B:W21-32:B1-12", 9, 3963680 },
+    { "opening", "B:W21-32:B1-12", 10, 18391564 },
+    { "PDN example", "B:W18,24,27,28,K10,K15:B12,16,20,K22,K25,K29", 9, 6924280 },
+    { "kings against men", "W:WK1,K32:BK14,K19,K23,10,11,18,26,27", 9, 3874317 },
+    { "crowning captures", "B:W6,7,8,14,15,22,23,K30:B17,19,20,26,27,K3", 9, 508509 },
+    { "middle game", "W:W9,10,11,22,23,24,K28:B5,6,13,14,15,K19,K30", 9, 2873910 },
+    { "three kings", "W:WK6,K14,K23:B9,10,11,15,16,18,19,20,24,26,27", 9, 3645076 },
+};
+
+// A share of the work, for the threads to take in turn:
+// For the reference generator: each square is positive for White, negative for Black, 1 for a man
+// and 2 for a king. Rows count up from White's side, so White's men move up the rows.
+typedef struct PlainBoard
+{
+    int8_t squares[8][8];
+    // 1 for White, -1 for Black:
+    int turn;
+} PlainBoard;
+
+typedef struct PlainMove
+{
+    // Squares, as row * 8 + column:
+    int from, to;
+    uint64_t captures;
+} PlainMove;
+
+typedef struct PlainMoveList
+{
+    PlainMove moves[PLAIN_MAX_MOVES];
+    int count;
+} PlainMoveList;
+
+typedef struct PerftTask
+{
+    CheckersBoard board;
+    int depth;
+    uint64_t count;
+} PerftTask;
+
+static struct perftGlobals
+{
+    PerftTask *tasks;
+    int taskCount, nextTask;
+    pthread_mutex_t lock;
+} g;
+
+static void check(bool condition, char *message)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//=============================================================================================
+// Positions
+//=============================================================================================
+
+// Standard square n is square 32 - n in checkersengine.c, and the standard White is red.
+static bool parsePosition(const char *text, CheckersBoard *board)
+{
+    memset(board, 0, sizeof(*board));
+    if (text[0] != 'W' && text[0] != 'B')
+    {
+        return false;
+    }
+    board->turn = (text[0] == 'W') ? CHECKERS_RED : CHECKERS_BLACK;
+
+    const char *p = text + 1;
+    int side = -1;
+    while (*p)
+    {
+        if (*p == ':')
+        {
+            p++;
+            if (*p != 'W' && *p != 'B')
+            {
+                return false;
+            }
+            side = (*p == 'W') ? CHECKERS_RED : CHECKERS_BLACK;
+            p++;
+            continue;
+        }
+        if (*p == ',' || *p == '.')
+        {
+            p++;
+            continue;
+        }
+
+        bool king = (*p == 'K');
+        p += king;
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p)
+        {
+            return false;
+        }
+        p = end;
+        if (*p == '-')
+        {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p)
+            {
+                return false;
+            }
+            p = end;
+        }
+        if (side < 0 || first < 1 || last > 32 || first > last)
+        {
+            return false;
+        }
+
+        for (long n = first; n <= last; n++)
+        {
+            uint32_t bit = 1u << (32 - n);
+            board->pieces[side] |= bit;
+            board->kings |= king ? bit : 0;
+        }
+    }
+    return (board->pieces[CHECKERS_RED] & board->pieces[CHECKERS_BLACK]) == 0;
+}
+
+//=============================================================================================
+// The reference generator
+//=============================================================================================
+
+// A slow but simple move generator on an 8 by 8 board, which shares nothing with the bitboards
+// in checkersengine.c. Jumps are found by following every path; paths that start and end on the
+// same squares and capture the same pieces are the same move.
+
+static const int PlainDirections[4][2] = { { 1, -1 }, { 1, 1 }, { -1, -1 }, { -1, 1 } };
+
+// Standard squares 1 to 4 are on the row furthest from White, with square 1 in column 1:
+static void findPlainSquare(int n, int *row, int *column)
+{
+    int rank = (n - 1) / 4;
+    *row = 7 - rank;
+    *column = 2 * ((n - 1) % 4) + (rank % 2 == 0);
+}
+
+static void toPlainBoard(const CheckersBoard *board, PlainBoard *plain)
+{
+    memset(plain, 0, sizeof(*plain));
+    plain->turn = (board->turn == CHECKERS_RED) ? 1 : -1;
+    for (int n = 1; n <= 32; n++)
+    {
+        uint32_t bit = 1u << (32 - n);
+        int side = (board->pieces[CHECKERS_RED] & bit) ? 1 : (board->pieces[CHECKERS_BLACK] & bit) ? -1 : 0;
+        int row, column;
+        findPlainSquare(n, &row, &column);
+        plain->squares[row][column] = side * ((board->kings & bit) ? 2 : 1);
+    }
+}
+
+static void addPlainMove(PlainMoveList *list, int from, int to, uint64_t captures)
+{
+    for (int i = 0; i < list->count; i++)
+    {
+        PlainMove *move = &list->moves[i];
+        if (move->from == from && move->to == to && move->captures == captures)
+        {
+            return;
+        }
+    }
+    check(list->count < PLAIN_MAX_MOVES, "too many reference moves");
+    list->moves[list->count++] = (PlainMove){ from, to, captures };
+}
+
+// Captured pieces stay on the board until the move ends, so they cannot be jumped twice or
+// landed on. A man that crowns stops there.
+static void addPlainJumps(const PlainBoard *board, PlainMoveList *list, int from, int row, int column, bool king, uint64_t captures)
+{
+    int side = board->turn;
+    bool extended = false;
+    for (int d = 0; d < 4; d++)
+    {
+        int rowStep = PlainDirections[d][0], columnStep = PlainDirections[d][1];
+        int overRow = row + rowStep, overColumn = column + columnStep;
+        int toRow = row + 2 * rowStep, toColumn = column + 2 * columnStep;
+        if ((!king && rowStep != side) || toRow < 0 || toRow > 7 || toColumn < 0 || toColumn > 7)
+        {
+            continue;
+        }
+        int over = overRow * 8 + overColumn;
+        int to = toRow * 8 + toColumn;
+        if ((captures >> over & 1) || board->squares[overRow][overColumn] * side >= 0 ||
+            (board->squares[toRow][toColumn] != 0 && to != from))
+        {
+            continue;
+        }
+
+        extended = true;
+        uint64_t newCaptures = captures | (1ull << over);
+        if (!king && toRow == (side == 1 ? 7 : 0))
+        {
+            addPlainMove(list, from, to, newCaptures);
+        }
+        else
+        {
+            addPlainJumps(board, list, from, toRow, toColumn, king, newCaptures);
+        }
+    }
+    if (!extended && captures)
+    {
+        addPlainMove(list, from, row * 8 + column, captures);
+    }
+}
+
+// Jumps are compulsory, so there are only simple moves if there are no jumps:
+static void generatePlainMoves(const PlainBoard *board, PlainMoveList *list)
+{
+    int side = board->turn;
+    list->count = 0;
+    for (int row = 0; row < 8; row++)
+    {
+        for (int column = 0; column < 8; column++)
+        {
+            if (board->squares[row][column] * side > 0)
+            {
+                addPlainJumps(board, list, row * 8 + column, row, column, abs(board->squares[row][column]) == 2, 0);
+            }
+        }
+    }
+    if (list->count > 0)
+    {
+        return;
+    }
+
+    for (int row = 0; row < 8; row++)
+    {
+        for (int column = 0; column < 8; column++)
+        {
+            if (board->squares[row][column] * side <= 0)
+            {
+                continue;
+            }
+            bool king = abs(board->squares[row][column]) == 2;
+            for (int d = 0; d < 4; d++)
+            {
+                int toRow = row + PlainDirections[d][0], toColumn = column + PlainDirections[d][1];
+                if ((!king && PlainDirections[d][0] != side) || toRow < 0 || toRow > 7 || toColumn < 0 || toColumn > 7 ||
+                    board->squares[toRow][toColumn] != 0)
+                {
+                    continue;
+                }
+                addPlainMove(list, row * 8 + column, toRow * 8 + toColumn, 0);
+            }
+        }
+    }
+}
+
+static void makePlainMove(PlainBoard *board, const PlainMove *move)
+{
+    int side = board->turn;
+    int8_t piece = board->squares[move->from / 8][move->from % 8];
+    board->squares[move->from / 8][move->from % 8] = 0;
+    for (int i = 0; i < 64; i++)
+    {
+        if (move->captures >> i & 1)
+        {
+            board->squares[i / 8][i % 8] = 0;
+        }
+    }
+    if (move->to / 8 == (side == 1 ? 7 : 0))
+    {
+        piece = side * 2;
+    }
+    board->squares[move->to / 8][move->to % 8] = piece;
+    board->turn = -side;
+}
+
+static uint64_t plainPerft(const PlainBoard *board, int depth)
+{
+    PlainMoveList list;
+    generatePlainMoves(board, &list);
+    if (depth <= 1)
+    {
+        return (depth == 1) ? (uint64_t)list.count : 1;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < list.count; i++)
+    {
+        PlainBoard next = *board;
+        makePlainMove(&next, &list.moves[i]);
+        total += plainPerft(&next, depth - 1);
+    }
+    return total;
+}
+
+//=============================================================================================
+// Counting
+//=============================================================================================
+
+static uint64_t perft(const CheckersBoard *board, int depth)
+{
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = generateCheckersMoves(board, moves);
+    if (depth <= 1)
+    {
+        return (depth == 1) ? (uint64_t)count : 1;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++)
+    {
+        CheckersBoard next = *board;
+        makeCheckersMove(&next, &moves[i]);
+        total += perft(&next, depth - 1);
+    }
+    return total;
+}
+
+static void *runWorker(void *data)
+{
+    (void)data;
+    for (;;)
+    {
+        pthread_mutex_lock(&g.lock);
+        int task = g.nextTask++;
+        pthread_mutex_unlock(&g.lock);
+        if (task >= g.taskCount)
+        {
+            return NULL;
+        }
+        g.tasks[task].count = perft(&g.tasks[task].board, g.tasks[task].depth);
+    }
+}
+
+// Adds every position `split` moves in as a task, or the position itself if the game ends first:
+static void addTasks(const CheckersBoard *board, int depth, int split)
+{
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = (split > 0 && depth > 1) ? generateCheckersMoves(board, moves) : 0;
+    if (count == 0)
+    {
+        g.tasks = realloc(g.tasks, (g.taskCount + 1) * sizeof(g.tasks[0]));
+        check(g.tasks != NULL, "realloc");
+        g.tasks[g.taskCount++] = (PerftTask){ *board, depth, 0 };
+        return;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        CheckersBoard next = *board;
+        makeCheckersMove(&next, &moves[i]);
+        addTasks(&next, depth - 1, split - 1);
+    }
+}
+
+// Splits the tree a couple of moves in, so that there are plenty of tasks to share out:
+static uint64_t parallelPerft(const CheckersBoard *board, int depth, int threadCount)
+{
+    if (threadCount <= 1)
+    {
+        return perft(board, depth);
+    }
+
+    g.taskCount = 0;
+    g.nextTask = 0;
+    addTasks(board, depth, 2);
+
+    pthread_t threads[MAX_THREADS];
+    for (int i = 0; i < threadCount; i++)
+    {
+        check(pthread_create(&threads[i], NULL, runWorker, NULL) == 0, "pthread_create");
+    }
+    for (int i = 0; i < threadCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < g.taskCount; i++)
+    {
+        total += g.tasks[i].count;
+    }
+    return total;
+}
+
+static void timePerft(const CheckersBoard *board, int depth, int threadCount)
+{
+    double start = now();
+    uint64_t count = parallelPerft(board, depth, threadCount);
+    double seconds = now() - start;
+    printf("depth %d, %d thread%s: %llu nodes in %.3f s, %.1f million nodes per second\n",
+        depth, threadCount, (threadCount == 1) ? "" : "s", (unsigned long long)count, seconds,
+        count / (seconds > 0 ? seconds : 1e-9) / 1e6);
+}
+
+static int runSuite(int threadCount)
+{
+    int failures = 0;
+    for (int i = 0; i < (int)(sizeof(Tests) / sizeof(Tests[0])); i++)
+    {
+        PerftTest *test = &Tests[i];
+        CheckersBoard board;
+        check(parsePosition(test->position, &board), "bad test position");
+        PlainBoard plain;
+        toPlainBoard(&board, &plain);
+        uint64_t count = perft(&board, test->depth);
+        uint64_t reference = plainPerft(&plain, test->depth);
+        bool passed = (count == test->count && reference == test->count);
+        failures += !passed;
+        printf("%-4s %s, depth %d: %llu", passed ? "ok" : "FAIL", test->name, test->depth, (unsigned long long)count);
+        if (!passed)
+        {
+            printf(" (expected %llu, reference %llu)", (unsigned long long)test->count, (unsigned long long)reference);
+        }
+        printf("\n");
+    }
+
+    CheckersBoard opening;
+    startCheckersBoard(&opening);
+    timePerft(&opening, BENCHMARK_DEPTH, 1);
+    if (threadCount > 1)
+    {
+        timePerft(&opening, BENCHMARK_DEPTH, threadCount);
+    }
+
+    printf("%s\n", failures ? "some counts are wrong" : "all counts are right");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = (cpus < 1) ? 1 : (cpus > MAX_THREADS) ? MAX_THREADS : (int)cpus;
+    int depth = 0;
+    char *position = NULL;
+    pthread_mutex_init(&g.lock, NULL);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            threadCount = atoi(argv[++i]);
+            threadCount = (threadCount < 1) ? 1 : (threadCount > MAX_THREADS) ? MAX_THREADS : threadCount;
+        }
+        else if (depth == 0 && atoi(argv[i]) > 0)
+        {
+            depth = atoi(argv[i]);
+        }
+        else if (depth > 0 && !position)
+        {
+            position = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t threads] [depth [position]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (depth == 0)
+    {
+        return runSuite(threadCount);
+    }
+
+    CheckersBoard board;
+    if (position)
+    {
+        check(parsePosition(position, &board), "cannot read the position");
+    }
+    else
+    {
+        startCheckersBoard(&board);
+    }
+    timePerft(&board, depth, threadCount);
+    return 0;
+}
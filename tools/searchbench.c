@@ -0,0 +1,123 @@
+// Times how long the checkers search in checkerssearch.c takes to reach a depth with more and
+// more threads, to see how well its helper threads scale.
+//
+//     searchbench [-t threads] [depth]
+//
+// Every thread count searches the same positions: the opening, and a few games a little way in.
+// The table is cleared before each search, so that no search is helped by the last one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../checkerssearch.h"
+
+#define DEFAULT_DEPTH 15
+#define POSITION_COUNT 4
+// Each position after the opening is this many more random moves in:
+#define POSITION_MOVES 6
+#define TABLE_MEGABYTES 64
+
+static void check(bool condition, char *message)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "error: %s\n", message);
+        exit(1);
+    }
+}
+
+// The same moves every run. A position with only one move would not be searched, so the moves go
+// on until there is a choice.
+static void makePositions(CheckersBoard *positions)
+{
+    uint32_t random = 0x2545F491;
+    CheckersBoard board;
+    startCheckersBoard(&board);
+    for (int i = 0; i < POSITION_COUNT; i++)
+    {
+        for (int j = 0; ; j++)
+        {
+            CheckersMove moves[CHECKERS_MAX_MOVES];
+            int count = generateCheckersMoves(&board, moves);
+            check(count > 0, "a game ended before the positions were all made");
+            if ((i == 0 || j >= POSITION_MOVES) && count > 1)
+            {
+                break;
+            }
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            makeCheckersMove(&board, &moves[random % count]);
+        }
+        positions[i] = board;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int maxThreads = SDL_GetCPUCount();
+    int depth = DEFAULT_DEPTH;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            maxThreads = atoi(argv[++i]);
+        }
+        else if (atoi(argv[i]) > 0)
+        {
+            depth = atoi(argv[i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t threads] [depth]\n", argv[0]);
+            return 1;
+        }
+    }
+    maxThreads = (maxThreads < 1) ? 1 : (maxThreads > CHECKERS_MAX_HELPERS + 1) ? CHECKERS_MAX_HELPERS + 1 : maxThreads;
+
+    CheckersBoard positions[POSITION_COUNT];
+    makePositions(positions);
+    CheckersTable table;
+    check(createCheckersTable(&table, TABLE_MEGABYTES), "not enough memory for the table");
+    CheckersSearch search;
+    memset(&search, 0, sizeof(search));
+    search.timeBudget = 1e9;
+    search.maxDepth = depth;
+    search.table = &table;
+
+    printf("time to depth %d over %d positions\n", depth, POSITION_COUNT);
+    // Doubling the threads each time, and finishing with all of them:
+    double oneThread = 0;
+    int threads = 1;
+    for (;;)
+    {
+        check(startCheckersHelpers(&search, threads - 1), "cannot start the helper threads");
+        double seconds = 0;
+        uint64_t nodes = 0, probes = 0, hits = 0;
+        for (int i = 0; i < POSITION_COUNT; i++)
+        {
+            clearCheckersTable(&table);
+            CheckersSearchResult result;
+            findCheckersMove(&search, &positions[i], &result);
+            check(result.depth == depth, "a search stopped short of the depth");
+            seconds += result.seconds;
+            nodes += result.nodes;
+            probes += result.tableProbes;
+            hits += result.tableHits;
+        }
+        stopCheckersHelpers(&search);
+
+        oneThread = (threads == 1) ? seconds : oneThread;
+        printf("%2d thread%s: %.3f s, %.2fx speedup, %.1f million nodes, %.1f million nodes per second, %.1f%% table hits\n",
+            threads, (threads == 1) ? " " : "s", seconds, oneThread / seconds, nodes / 1e6, nodes / seconds / 1e6,
+            probes ? 100.0 * hits / probes : 0.0);
+        if (threads == maxThreads)
+        {
+            break;
+        }
+        threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+    }
+
+    destroyCheckersTable(&table);
+    return 0;
+}